@@ -143,6 +143,8 @@ void Action::commit(DirtyList* dirty_list) {
 					}
 				}
 
+				// Plain items go back to their shared records before the tile enters the map
+				new_tile->compactItems();
 				Tile* old_tile = map.swapTile(pos, new_tile);
 				TileLocation* location = new_tile->getLocation();
 
@@ -203,6 +205,8 @@ void Action::commit(DirtyList* dirty_list) {
 						selection.removeInternal(old_tile);
 					}
 
+					// The undo history only holds copies of the items that changed
+					old_tile->shareItems(*new_tile);
 					*data = old_tile;
 				} else {
 					*data = map.allocator(location);
@@ -354,6 +358,7 @@ void Action::undo(DirtyList* dirty_list) {
 				} else if (new_tile->spawnNpc) {
 					map.removeSpawnNpc(new_tile);
 				}
+				new_tile->shareItems(*old_tile);
 				*data = new_tile;
 
 				// Update client dirty list
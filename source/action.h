@@ -256,6 +256,12 @@ public:
 	}
 
 	bool hasChanges() const;
+	// Estimated memory held by the undo history. An attribute list shared with the map or other
+	// actions is split by its reference count at the time the action was added, so it is amortised
+	// rather than owned bytes, and the total drifts as the other references come and go.
+	size_t memsize() const noexcept {
+		return memory_size;
+	}
 
 	void generateLabels();
 
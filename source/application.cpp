@@ -32,9 +32,11 @@
 
 #include "materials.h"
 #include "map.h"
+#include "batch_mode.h"
 #include "complexitem.h"
 #include "monster.h"
 #include "npc.h"
+#include "sprite_appearances.h"
 
 #if defined(__LINUX__) || defined(__WINDOWS__)
 	#include <GL/glut.h>
@@ -92,6 +94,23 @@ Application::~Application() {
 	// Destroy
 }
 
+bool Application::Initialize(int &argc, wxChar** argv) {
+	// Batch mode has to run without a display, so the toolkit is left alone
+	m_batch = argc > 1 && (wxString(argv[1]) == BatchMode::Flag || wxString(argv[1]) == BatchMode::BenchmarkFlag);
+	if (m_batch) {
+		return wxAppConsole::Initialize(argc, argv);
+	}
+	return wxApp::Initialize(argc, argv);
+}
+
+void Application::CleanUp() {
+	if (m_batch) {
+		wxAppConsole::CleanUp();
+	} else {
+		wxApp::CleanUp();
+	}
+}
+
 bool Application::OnInit() {
 #if defined __DEBUG_MODE__ && defined __WINDOWS__
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
@@ -103,6 +122,22 @@ bool Application::OnInit() {
 	spdlog::info("Visit our website for updates, support, and resources: https://docs.opentibiabr.com/");
 	spdlog::info("Application started sucessfull!\n");
 
+	if (m_batch) {
+		// Messages of wxWidgets would otherwise wait for a window
+		delete wxLog::SetActiveTarget(newd wxLogStderr);
+
+		std::vector<std::string> args;
+		for (int i = 2; i < argc; ++i) {
+			args.push_back(argv[i].ToStdString());
+		}
+		if (wxString(argv[1]) == BatchMode::BenchmarkFlag) {
+			m_batch_result = BatchMode::RunBenchmark(args);
+		} else {
+			m_batch_result = BatchMode::Run(args);
+		}
+		return true;
+	}
+
 	mt_seed(time(nullptr));
 	srand(time(nullptr));
 
@@ -306,11 +341,20 @@ void Application::Unload() {
 	g_gui.root = nullptr;
 }
 
+int Application::OnRun() {
+	if (m_batch) {
+		return m_batch_result;
+	}
+	return wxApp::OnRun();
+}
+
 int Application::OnExit() {
 #ifdef _USE_PROCESS_COM
 	wxDELETE(m_proc_server);
 	wxDELETE(m_single_instance_checker);
 #endif
+	// Stops the sprite decoders and the sheet cache rebuild before the globals go away
+	g_spriteAppearances.terminate();
 	return 1;
 }
 
@@ -39,7 +39,10 @@ class wxSingleInstanceChecker;
 class Application : public wxApp {
 public:
 	~Application();
+	virtual bool Initialize(int &argc, wxChar** argv);
+	virtual void CleanUp();
 	virtual bool OnInit();
+	virtual int OnRun();
 	virtual void OnEventLoopEnter(wxEventLoopBase* loop);
 	virtual void MacOpenFiles(const wxArrayString &fileNames);
 	virtual int OnExit();
@@ -48,13 +51,16 @@ public:
 private:
 	bool m_startup;
 	wxString m_file_to_open;
+	// Command line batch mode, no window is created and OnRun returns its result
+	bool m_batch = false;
+	int m_batch_result = 0;
 	bool ParseCommandLineMap(wxString &fileName);
 
 	virtual void OnFatalException();
 
 #ifdef _USE_PROCESS_COM
-	RMEProcessServer* m_proc_server;
-	wxSingleInstanceChecker* m_single_instance_checker;
+	RMEProcessServer* m_proc_server = nullptr;
+	wxSingleInstanceChecker* m_single_instance_checker = nullptr;
 #endif
 };
 
@@ -19,6 +19,7 @@
 
 #include "tile.h"
 #include "basemap.h"
+#include "map_pager.h"
 
 BaseMap::BaseMap() :
 	allocator(),
@@ -28,10 +29,18 @@ BaseMap::BaseMap() :
 }
 
 BaseMap::~BaseMap() {
-	////
+	pager.reset();
+	// Floors still own their tiles, so they are destroyed before the slabs go away
+	root.releaseChildren();
+	leaves.clear();
+	allocator.releasePools();
 }
 
 void BaseMap::clear(bool del) {
+	// The areas still on disk go away with the rest of the map
+	pager.reset();
+	save_cache.clear();
+
 	PositionVector pos_vec;
 	for (MapIterator map_iter = begin(); map_iter != end(); ++map_iter) {
 		Tile* t = (*map_iter)->get();
@@ -40,27 +49,46 @@ void BaseMap::clear(bool del) {
 	for (PositionVector::iterator pos_iter = pos_vec.begin(); pos_iter != pos_vec.end(); ++pos_iter) {
 		setTile(*pos_iter, nullptr, del);
 	}
+
+	// Tiles that were kept alive may still point at their locations, so the structure is only dropped along with them
+	if (del) {
+		root.releaseChildren();
+		leaves.clear();
+		allocator.releasePools();
+	}
 }
 
 void BaseMap::clearVisible(uint32_t mask) {
 	root.clearVisible(mask);
 }
 
+void BaseMap::setPager(std::unique_ptr<MapPager> new_pager) {
+	pager = std::move(new_pager);
+}
+
 Tile* BaseMap::createTile(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	if (pager) {
+		pager->pageIn(x, y, z, true);
+	}
+	save_cache.markDirty(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	TileLocation* loc = leaf->createTile(x, y, z);
 	if (loc->get()) {
 		return loc->get();
 	}
 	Tile* t = allocator(loc);
 	leaf->setTile(x, y, z, t);
+	memory.addTile(t);
 	return t;
 }
 
 TileLocation* BaseMap::getTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeaf(x, y);
+	if (pager) {
+		pager->pageIn(x, y, z);
+	}
+	QTreeNode* leaf = leaves.get(x, y);
 	if (leaf) {
 		Floor* floor = leaf->getFloor(z);
 		if (floor) {
@@ -86,8 +114,11 @@ const TileLocation* BaseMap::getTileL(const Position &pos) const {
 
 TileLocation* BaseMap::createTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
+	if (pager) {
+		pager->pageIn(x, y, z, true);
+	}
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Floor* floor = leaf->createFloor(x, y, z);
 	uint32_t offsetX = x & 3;
 	uint32_t offsetY = y & 3;
@@ -103,13 +134,22 @@ void BaseMap::setTile(int x, int y, int z, Tile* new_tile, bool remove) {
 	ASSERT(!new_tile || new_tile->getX() == x);
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
+	if (pager) {
+		pager->pageIn(x, y, z, true);
+	}
+	save_cache.markDirty(x, y);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
+	memory.removeTile(old_tile);
+	memory.addTile(new_tile);
 
 	if ((remove && old_tile) || new_tile) {
 		updateUniqueIds(remove ? old_tile : nullptr, new_tile);
 	}
+	if (old_tile || new_tile) {
+		updateZones(Position(x, y, z), old_tile, new_tile);
+	}
 
 	if (remove) {
 		delete old_tile;
@@ -132,12 +172,19 @@ Tile* BaseMap::swapTile(int x, int y, int z, Tile* new_tile) {
 	ASSERT(!new_tile || new_tile->getX() == x);
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
+	if (pager) {
+		pager->pageIn(x, y, z, true);
+	}
+	save_cache.markDirty(x, y);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
+	memory.removeTile(old_tile);
+	memory.addTile(new_tile);
 
 	if (old_tile || new_tile) {
 		updateUniqueIds(old_tile, new_tile);
+		updateZones(Position(x, y, z), old_tile, new_tile);
 	}
 
 	return old_tile;
@@ -147,6 +194,64 @@ Tile* BaseMap::swapTile(const Position &position, Tile* new_tile) {
 	return swapTile(position.x, position.y, position.z, new_tile);
 }
 
+void BaseMap::markTileChanged(const Position &position) {
+	if (pager) {
+		pager->pageIn(position.x, position.y, position.z, true);
+	}
+	save_cache.markDirty(position.x, position.y);
+}
+
+void BaseMap::setPagedTile(const Position &position, Tile* new_tile) {
+	QTreeNode* leaf = createLeaf(position.x, position.y);
+	Tile* old_tile = leaf->setTile(position.x, position.y, position.z, new_tile);
+	memory.removeTile(old_tile);
+	memory.addTile(new_tile);
+	delete old_tile;
+}
+
+std::vector<QTreeNode*> BaseMap::getLeaves() {
+	// The parallel traversals only read the tiles
+	if (pager) {
+		pager->pageInAll(false);
+	}
+
+	std::vector<QTreeNode*> result;
+	result.reserve(tilecount / 16 + 1);
+	root.collectLeaves(result);
+	return result;
+}
+
+TileNeighborhood::TileNeighborhood(BaseMap* map, const Position &center, int radius) :
+	center(center),
+	radius(radius),
+	leaf_x((center.x - radius) >> 2),
+	leaf_y((center.y - radius) >> 2) {
+	ASSERT(map);
+	ASSERT(radius >= 0 && radius <= MaxRadius);
+	ASSERT(center.z >= rme::MapMinLayer && center.z <= rme::MapMaxLayer);
+
+	const int last_x = (center.x + radius) >> 2;
+	const int last_y = (center.y + radius) >> 2;
+	for (int i = 0; i < 2; ++i) {
+		for (int j = 0; j < 2; ++j) {
+			floors[i][j] = nullptr;
+
+			const int x = (leaf_x + i) * 4;
+			const int y = (leaf_y + j) * 4;
+			if (x < 0 || y < 0 || leaf_x + i > last_x || leaf_y + j > last_y) {
+				continue;
+			}
+
+			if (MapPager* pager = map->getPager()) {
+				pager->pageIn(x, y, center.z);
+			}
+			if (QTreeNode* leaf = map->getLeaf(x, y)) {
+				floors[i][j] = leaf->getFloor(center.z);
+			}
+		}
+	}
+}
+
 // Iterators
 
 MapIterator::MapIterator(BaseMap* _map) :
@@ -172,6 +277,24 @@ MapIterator::MapIterator(const MapIterator &other) {
 }
 
 MapIterator BaseMap::begin() {
+	// Read-only walks only bring the areas in, they can still be evicted once the walk is done
+	if (pager) {
+		pager->pageInAll(false);
+	}
+	return firstTile();
+}
+
+MapIterator BaseMap::beginMutable() {
+	// Whoever walks the whole map to change tiles in place keeps them, none of them can be evicted anymore,
+	// and the saved columns of all of them are stale
+	if (pager) {
+		pager->pageInAll(true);
+	}
+	save_cache.markAllDirty();
+	return firstTile();
+}
+
+MapIterator BaseMap::firstTile() {
 	MapIterator it(this);
 	it.nodestack.push_back(MapIterator::NodeIndex(&root));
 
@@ -22,6 +22,8 @@
 #include "position.h"
 #include "filehandle.h"
 #include "map_allocator.h"
+#include "map_memory.h"
+#include "map_save_cache.h"
 #include "tile.h"
 
 // Class declarations
@@ -31,6 +33,7 @@ class MapIterator;
 class Floor;
 class QTreeNode;
 class TileLocation;
+class MapPager;
 
 class MapIterator {
 public:
@@ -88,9 +91,14 @@ public:
 	BaseMap();
 	virtual ~BaseMap();
 
-	// This doesn't destroy the map structure, just clears it, if param is true, delete all tiles too.
+	// Clears all tiles from the map, if param is true, delete all tiles too and release the map structure
+	// (floors and nodes) back to the allocator in bulk.
 	void clear(bool del = true);
+	// begin() is for walks that only read tiles, beginMutable() for walks that change them in place,
+	// it also throws away the incremental save cache. Walks that change items in place rather than
+	// replacing them must call Tile::unshareItems on the tile first.
 	MapIterator begin();
+	MapIterator beginMutable();
 	MapIterator end();
 	uint64_t size() const noexcept {
 		return tilecount;
@@ -109,13 +117,27 @@ public:
 	const TileLocation* getTileL(int x, int y, int z) const;
 	const TileLocation* getTileL(const Position &pos) const;
 
-	// Get a Quad Tree Leaf from the map
-	QTreeNode* getLeaf(int x, int y) {
-		return root.getLeaf(x, y);
+	// Get a Quad Tree Leaf from the map, resolved through the leaf directory
+	QTreeNode* getLeaf(int x, int y) const noexcept {
+		return leaves.get(x, y);
 	}
 	QTreeNode* createLeaf(int x, int y) {
-		return root.getLeafForce(x, y);
+		if (QTreeNode* leaf = leaves.get(x, y)) {
+			return leaf;
+		}
+		QTreeNode* leaf = root.getLeafForce(x, y);
+		leaves.set(x, y, leaf);
+		return leaf;
+	}
+	// Walks down the tree instead of using the directory, only meant for validation and benchmarks
+	QTreeNode* getLeafFromTree(int x, int y) {
+		return root.getLeaf(x, y);
 	}
+	const LeafDirectory &getLeafDirectory() const noexcept {
+		return leaves;
+	}
+	// All leaves of the tree, in iteration order, for splitting work across threads
+	std::vector<QTreeNode*> getLeaves();
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
 	void setTile(int x, int y, int z, Tile* new_tile, bool remove = false);
@@ -124,6 +146,12 @@ public:
 	// Replaces a tile and returns the old one
 	Tile* swapTile(int x, int y, int z, Tile* new_tile);
 	Tile* swapTile(const Position &position, Tile* new_tile);
+	// For tiles changed in place rather than through setTile or swapTile, so neither the save cache
+	// nor the pager bring back what the tile was
+	void markTileChanged(const Position &position);
+	// Takes a tile of a cell the pager evicts out of the map or puts it back, without updating the
+	// unique ids and zones registered for it, which stay registered while the tile is on disk
+	void setPagedTile(const Position &position, Tile* new_tile);
 
 	// Clears the visiblity according to the mask passed
 	void clearVisible(uint32_t mask);
@@ -132,19 +160,85 @@ public:
 		return tilecount;
 	}
 
+	// Set when the tiles are read from the file on demand, see MapPager
+	MapPager* getPager() const noexcept {
+		return pager.get();
+	}
+	void setPager(std::unique_ptr<MapPager> new_pager);
+
 public:
 	MapAllocator allocator;
+	MapMemoryCounters memory;
+	MapSaveCache save_cache;
 
 protected:
 	virtual void updateUniqueIds(Tile* old_tile, Tile* new_tile) { }
+	// Called whenever a tile enters or leaves the map at the position
+	virtual void updateZones(const Position &position, Tile* old_tile, Tile* new_tile) { }
+
+	MapIterator firstTile();
 
 	uint64_t tilecount;
 
 	QTreeNode root; // The Quad Tree root
+	LeafDirectory leaves; // Direct lookup table for the leaves of root
+	std::unique_ptr<MapPager> pager;
 
 	friend class QTreeNode;
 };
 
+// Cursor over a (2 * radius + 1) square window of tiles on one floor. The leaves covering the
+// window (never more than 2x2 for radius <= 2) are resolved once on construction and every read
+// inside the window is served from them, instead of going through the map for each neighbour.
+// The cursor must not outlive a change to the map structure (clear or destruction).
+class TileNeighborhood {
+public:
+	static constexpr int MaxRadius = 2;
+
+	// Offsets of the 8 direct neighbours, in the order used by the border tables
+	// (north-west, north, north-east, west, east, south-west, south, south-east)
+	static constexpr int NeighborOffsets[8][2] = {
+		{ -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 }
+	};
+
+	TileNeighborhood(BaseMap* map, const Position &center, int radius = 1);
+
+	// Offsets are relative to the center, positions outside the map (negative) yield nullptr
+	TileLocation* getLocation(int dx, int dy) const noexcept;
+	Tile* get(int dx, int dy) const noexcept {
+		TileLocation* location = getLocation(dx, dy);
+		return location ? location->get() : nullptr;
+	}
+	Tile* getNeighbor(int index) const noexcept {
+		return get(NeighborOffsets[index][0], NeighborOffsets[index][1]);
+	}
+
+	const Position &getCenter() const noexcept {
+		return center;
+	}
+
+private:
+	Position center;
+	int radius;
+	int leaf_x, leaf_y; // Leaf coordinates (position / 4) of floors[0][0]
+	Floor* floors[2][2];
+};
+
+inline TileLocation* TileNeighborhood::getLocation(int dx, int dy) const noexcept {
+	ASSERT(dx >= -radius && dx <= radius && dy >= -radius && dy <= radius);
+	const int x = center.x + dx;
+	const int y = center.y + dy;
+	if (x < 0 || y < 0) {
+		return nullptr;
+	}
+
+	Floor* floor = floors[(x >> 2) - leaf_x][(y >> 2) - leaf_y];
+	if (!floor) {
+		return nullptr;
+	}
+	return &floor->locs[(x & 3) * 4 + (y & 3)];
+}
+
 inline Tile* BaseMap::getTile(int x, int y, int z) {
 	TileLocation* l = getTileL(x, y, z);
 	return l ? l->get() : nullptr;
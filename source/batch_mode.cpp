@@ -0,0 +1,358 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "batch_mode.h"
+#include "gui.h"
+#include "editor.h"
+#include "client_assets.h"
+#include "iominimap.h"
+#include "map_statistics.h"
+#include "memory_report.h"
+#include "items.h"
+#include "map_benchmark.h"
+
+#include <fstream>
+
+namespace {
+	struct OperationInfo {
+		const char* name;
+		const char* argument; // nullptr if the operation takes none
+	};
+
+	constexpr OperationInfo operations[] = {
+		{ "--convert-otbm", "<1-6>" },
+		{ "--borderize", nullptr },
+		{ "--randomize", nullptr },
+		{ "--clean-invalid-items", nullptr },
+		{ "--clean-house-tiles", nullptr },
+		{ "--validate", nullptr },
+		{ "--statistics", nullptr },
+		{ "--memory-report", nullptr },
+		{ "--export-minimap", "<dir>" },
+		{ "--export-otmm", "<dir>" },
+		{ "--save", nullptr },
+		{ "--save-as", "<file>" },
+	};
+
+	struct Operation {
+		std::string name;
+		std::string argument;
+	};
+
+	const OperationInfo* findOperation(const std::string &name) {
+		for (const OperationInfo &info : operations) {
+			if (name == info.name) {
+				return &info;
+			}
+		}
+		return nullptr;
+	}
+
+	void logUsage() {
+		std::string usage = fmt::format("Usage: {} [--yes] <map> <operation>...\nOperations, run in the given order:", BatchMode::Flag);
+		for (const OperationInfo &info : operations) {
+			usage += fmt::format("\n  {} {}", info.name, info.argument ? info.argument : "");
+		}
+		spdlog::info(usage);
+	}
+
+	struct ValidationResult {
+		uint64_t invalid_items = 0;
+		uint64_t orphan_house_tiles = 0;
+	};
+
+	// Looks for the same things the cleanup operations remove, without changing anything
+	bool validateMap(Map &map) {
+		const Houses &houses = map.houses;
+		const auto validateTile = [&houses](ValidationResult &result, const Tile* tile) {
+			for (const Item* item : tile->items) {
+				if (!g_items.isValidID(item->getID())) {
+					result.invalid_items += 1;
+				}
+			}
+			if (tile->isHouseTile() && !houses.getHouse(tile->getHouseID())) {
+				result.orphan_house_tiles += 1;
+			}
+		};
+		const auto mergeResults = [](ValidationResult &into, const ValidationResult &from) {
+			into.invalid_items += from.invalid_items;
+			into.orphan_house_tiles += from.orphan_house_tiles;
+		};
+		const ValidationResult result = parallel_reduce_TileOnMap(map, ValidationResult(), validateTile, mergeResults);
+
+		uint64_t houses_without_town = 0;
+		for (const auto &entry : houses) {
+			if (!map.towns.getTown(entry.second->townid)) {
+				houses_without_town += 1;
+			}
+		}
+
+		if (result.invalid_items != 0) {
+			spdlog::warn("{} items have an id the client does not know", result.invalid_items);
+		}
+		if (result.orphan_house_tiles != 0) {
+			spdlog::warn("{} house tiles belong to a house that does not exist", result.orphan_house_tiles);
+		}
+		if (houses_without_town != 0) {
+			spdlog::warn("{} houses belong to a town that does not exist", houses_without_town);
+		}
+
+		const size_t warnings = map.getWarnings().size();
+		if (warnings != 0) {
+			spdlog::warn("The map loader reported {} warnings", warnings);
+		}
+		return result.invalid_items == 0 && result.orphan_house_tiles == 0 && houses_without_town == 0 && warnings == 0;
+	}
+
+	bool exportMinimap(Editor &editor, MinimapExportFormat format, const std::string &directory) {
+		if (!wxFileName::Mkdir(wxstr(directory), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+			spdlog::error("Could not create the directory {}", directory);
+			return false;
+		}
+
+		const std::string name = nstr(wxFileName(wxstr(editor.getMap().getFilename())).GetName());
+		IOMinimap minimap(&editor, format, MinimapExportMode::AllFloors, true);
+		if (!minimap.saveMinimap(directory, name) || !minimap.getError().empty()) {
+			spdlog::error("Could not export the minimap: {}", minimap.getError());
+			return false;
+		}
+		return true;
+	}
+
+	BatchMode::Result runOperation(Editor &editor, const Operation &operation) {
+		Map &map = editor.getMap();
+		spdlog::info("Running {} {}", operation.name, operation.argument);
+
+		if (operation.name == "--convert-otbm") {
+			MapVersion version;
+			version.otbm = static_cast<MapVersionID>(std::stoi(operation.argument) - 1);
+			map.convert(version, true);
+			map.doChange();
+		} else if (operation.name == "--borderize") {
+			editor.borderizeMap(true);
+		} else if (operation.name == "--randomize") {
+			editor.randomizeMap(true);
+		} else if (operation.name == "--clean-invalid-items") {
+			map.cleanInvalidTiles(true);
+		} else if (operation.name == "--clean-house-tiles") {
+			editor.clearInvalidHouseTiles(true);
+		} else if (operation.name == "--validate") {
+			if (!validateMap(map)) {
+				return BatchMode::ValidationFailed;
+			}
+		} else if (operation.name == "--statistics") {
+			spdlog::info("\n{}", GetMapStatisticsReport(map, editor.getHistoryActions(), [](int32_t) { }));
+		} else if (operation.name == "--memory-report") {
+			spdlog::info("\n{}", CollectMemoryReport(&editor).toJson().dump(2));
+		} else if (operation.name == "--export-minimap") {
+			if (!exportMinimap(editor, MinimapExportFormat::Png, operation.argument)) {
+				return BatchMode::OperationFailed;
+			}
+		} else if (operation.name == "--export-otmm") {
+			if (!exportMinimap(editor, MinimapExportFormat::Otmm, operation.argument)) {
+				return BatchMode::OperationFailed;
+			}
+		} else if (operation.name == "--save") {
+			if (!editor.saveMap(wxString(""), true)) {
+				return BatchMode::OperationFailed;
+			}
+		} else if (operation.name == "--save-as") {
+			if (!editor.saveMap(FileName(wxstr(operation.argument)), true)) {
+				return BatchMode::OperationFailed;
+			}
+		}
+		return BatchMode::Success;
+	}
+}
+
+BatchMode::Result BatchMode::Run(const std::vector<std::string> &args) {
+	bool assume_yes = false;
+	std::string map_path;
+	std::vector<Operation> queue;
+	for (size_t i = 0; i < args.size(); ++i) {
+		const std::string &arg = args[i];
+		if (arg == "--help") {
+			logUsage();
+			return Success;
+		} else if (arg == "--yes") {
+			assume_yes = true;
+		} else if (const OperationInfo* info = findOperation(arg)) {
+			Operation operation { arg, "" };
+			if (info->argument) {
+				if (i + 1 == args.size()) {
+					spdlog::error("{} needs an argument {}", arg, info->argument);
+					return UsageError;
+				}
+				operation.argument = args[++i];
+			}
+			queue.push_back(std::move(operation));
+		} else if (map_path.empty() && arg.rfind("--", 0) != 0) {
+			map_path = arg;
+		} else {
+			spdlog::error("Unknown argument {}", arg);
+			logUsage();
+			return UsageError;
+		}
+	}
+
+	if (map_path.empty()) {
+		logUsage();
+		return UsageError;
+	}
+	for (const Operation &operation : queue) {
+		if (operation.name == "--convert-otbm") {
+			const int otbm = std::atoi(operation.argument.c_str());
+			if (otbm < MAP_OTBM_1 + 1 || otbm > MAP_OTBM_LAST_VERSION + 1) {
+				spdlog::error("Unknown OTBM version {}", operation.argument);
+				return UsageError;
+			}
+		}
+	}
+
+	g_gui.SetHeadless(assume_yes);
+	g_gui.discoverDataDirectory("clients.xml");
+	g_settings.load();
+	ClientAssets::load();
+	wxImage::AddHandler(newd wxPNGHandler);
+
+	wxString error;
+	wxArrayString warnings;
+	if (!g_gui.loadMapWindow(error, warnings)) {
+		spdlog::error("Could not load the client assets: {}", error.ToStdString());
+		return LoadFailed;
+	}
+	g_gui.ListDialog("Client assets", warnings);
+
+	std::unique_ptr<Editor> editor;
+	try {
+		editor.reset(newd Editor(g_gui.copybuffer, FileName(wxstr(map_path))));
+	} catch (std::runtime_error &e) {
+		spdlog::error("{}", e.what());
+		return LoadFailed;
+	}
+
+	Map &map = editor->getMap();
+	if (!map.hasFile()) {
+		spdlog::error("Could not load {}: {}", map_path, map.getError().ToStdString());
+		return LoadFailed;
+	}
+	g_gui.ListDialog("Map loader", map.getWarnings());
+	spdlog::info("Loaded {} with {} tiles", map_path, map.getTileCount());
+
+	for (const Operation &operation : queue) {
+		const Result result = runOperation(*editor, operation);
+		if (result != Success) {
+			spdlog::error("{} failed, stopping", operation.name);
+			return result;
+		}
+	}
+	return Success;
+}
+
+namespace {
+	bool parseBenchmarkNumber(const std::string &text, double &out) {
+		char* end = nullptr;
+		out = std::strtod(text.c_str(), &end);
+		return !text.empty() && *end == '\0' && out >= 0.0;
+	}
+}
+
+BatchMode::Result BatchMode::RunBenchmark(const std::vector<std::string> &args) {
+	BenchmarkMapOptions options;
+	uint64_t lookups = 4'000'000;
+	std::string directory = nstr(wxFileName::GetTempDir()) + "/rme-benchmark";
+	std::string output;
+	std::string golden;
+
+	const std::pair<const char*, int*> integers[] = {
+		{ "--width", &options.width },
+		{ "--height", &options.height },
+		{ "--floors", &options.floors },
+		{ "--towns", &options.towns },
+		{ "--houses", &options.houses },
+		{ "--spawns", &options.spawns },
+		{ "--zones", &options.zones },
+	};
+
+	for (size_t i = 0; i < args.size(); ++i) {
+		const std::string &arg = args[i];
+		if (arg == "--help") {
+			spdlog::info("Usage: {} [--width <n>] [--height <n>] [--floors <n>] [--item-density <x>] [--attribute-ratio <x>] [--towns <n>] [--houses <n>] [--spawns <n>] [--zones <n>] [--zone-ratio <x>] [--seed <n>] [--lookups <n>] [--directory <dir>] [--output <file.json>] [--golden <file>]", BenchmarkFlag);
+			return Success;
+		}
+		if (i + 1 == args.size()) {
+			spdlog::error("{} needs an argument", arg);
+			return UsageError;
+		}
+		const std::string &value = args[++i];
+
+		double number = 0.0;
+		const bool numeric = parseBenchmarkNumber(value, number);
+		const auto integer = std::find_if(std::begin(integers), std::end(integers), [&arg](const auto &entry) { return arg == entry.first; });
+		if (integer != std::end(integers) && numeric) {
+			*integer->second = int(number);
+		} else if (arg == "--item-density" && numeric) {
+			options.item_density = number;
+		} else if (arg == "--attribute-ratio" && numeric) {
+			options.attribute_ratio = std::min(number, 1.0);
+		} else if (arg == "--zone-ratio" && numeric) {
+			options.zone_ratio = std::min(number, 1.0);
+		} else if (arg == "--seed" && numeric) {
+			options.seed = uint32_t(number);
+		} else if (arg == "--lookups" && numeric) {
+			lookups = uint64_t(number);
+		} else if (arg == "--directory") {
+			directory = value;
+		} else if (arg == "--output") {
+			output = value;
+		} else if (arg == "--golden") {
+			golden = value;
+		} else {
+			spdlog::error("Unknown argument {} {}", arg, value);
+			return UsageError;
+		}
+	}
+
+	g_gui.SetHeadless(false);
+	if (!wxFileName::Mkdir(wxstr(directory), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+		spdlog::error("Could not create {}", directory);
+		return OperationFailed;
+	}
+
+	const MapBenchmarkResult result = RunMapBenchmark(options, directory, lookups, golden);
+	spdlog::info("{}", FormatMapBenchmark(result));
+
+	if (!output.empty()) {
+		std::ofstream file(output);
+		file << result.toJson().dump(4) << std::endl;
+		if (!file) {
+			spdlog::error("Could not write {}", output);
+			return OperationFailed;
+		}
+		spdlog::info("Results written to {}", output);
+	}
+
+	if (!result.loaded) {
+		return LoadFailed;
+	}
+	if (!result.matches_serial || (result.golden_checked && !result.matches_golden) || !result.round_trip_identical || !result.region_matches || !result.deleted_zone_gone || result.lookup.mismatches != 0 || result.traversal.serial_checksum != result.traversal.parallel_checksum) {
+		return ValidationFailed;
+	}
+	return Success;
+}
@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_BATCH_MODE_H_
+#define RME_BATCH_MODE_H_
+
+#include <string>
+#include <vector>
+
+// Runs map operations from the command line without a display or any window:
+//   <editor> --batch [--yes] <map> <operation>...
+// The map is loaded with the client assets of the configured client, the operations then run in
+// the order they are given and the first one that fails stops the run.
+//   --convert-otbm <1-6>       Changes the OTBM version the map is saved with
+//   --borderize                Borderizes every tile
+//   --randomize                Randomizes every ground
+//   --clean-invalid-items      Removes items with ids the client does not know
+//   --clean-house-tiles        Removes houses without a town and tiles of houses that do not exist
+//   --validate                 Fails if the loader warned or the map has anything the cleanups remove
+//   --statistics               Logs the same statistics as Map > Statistics
+//   --memory-report            Logs the memory report as json
+//   --export-minimap <dir>     Writes png images of every floor
+//   --export-otmm <dir>        Writes the minimap as <map name>.otmm
+//   --save                     Saves the map to its own file
+//   --save-as <file>           Saves the map to another file, .otgz included
+// Questions the loader asks are answered with no, or with yes after --yes.
+//
+// Times a synthetic map instead, without client assets or user settings:
+//   <editor> --benchmark [--width <n>] [--height <n>] [--floors <n>] [--item-density <x>]
+//            [--attribute-ratio <x>] [--towns <n>] [--houses <n>] [--spawns <n>] [--seed <n>]
+//            [--lookups <n>] [--directory <dir>] [--output <file.json>] [--golden <file>]
+// The map files are written to the directory, the system temp directory by default, and the
+// results are logged and written to the output file as json. The tile areas written by the serial
+// writer are compared with the golden file when one is given, see tools/golden.
+namespace BatchMode {
+	constexpr const char* Flag = "--batch";
+	constexpr const char* BenchmarkFlag = "--benchmark";
+
+	// Exit codes of the process
+	enum Result : int {
+		Success = 0,
+		UsageError = 1,
+		LoadFailed = 2,
+		OperationFailed = 3,
+		ValidationFailed = 4,
+	};
+
+	// args are the arguments after --batch
+	Result Run(const std::vector<std::string> &args);
+	// args are the arguments after --benchmark
+	Result RunBenchmark(const std::vector<std::string> &args);
+}
+
+#endif
@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "block_gzip.h"
+#include "thread_pool.h"
+
+#include <zlib.h>
+
+namespace {
+	// Gzip header with FEXTRA set, a single "RM" subfield holds the member and inflated sizes
+	constexpr size_t BlockGzipHeaderSize = 24;
+	// CRC32 and inflated size
+	constexpr size_t BlockGzipTrailerSize = 8;
+
+	void putU16(uint8_t* out, uint32_t value) {
+		out[0] = static_cast<uint8_t>(value);
+		out[1] = static_cast<uint8_t>(value >> 8);
+	}
+
+	void putU32(uint8_t* out, uint32_t value) {
+		putU16(out, value & 0xFFFF);
+		putU16(out + 2, value >> 16);
+	}
+
+	uint32_t getU16(const uint8_t* in) {
+		return in[0] | (in[1] << 8);
+	}
+
+	uint32_t getU32(const uint8_t* in) {
+		return getU16(in) | (getU16(in + 2) << 16);
+	}
+
+	// Returns the size of the whole member, 0 when the header was not written by BlockGzipWriter
+	uint32_t parseBlockGzipHeader(const uint8_t* header, uint32_t &inflated_size) {
+		if (header[0] != 0x1F || header[1] != 0x8B || header[2] != Z_DEFLATED || header[3] != 0x04) {
+			return 0;
+		}
+		if (getU16(header + 10) != 12 || header[12] != 'R' || header[13] != 'M' || getU16(header + 14) != 8) {
+			return 0;
+		}
+
+		const uint32_t member_size = getU32(header + 16);
+		inflated_size = getU32(header + 20);
+		if (member_size < BlockGzipHeaderSize + BlockGzipTrailerSize || inflated_size > BlockGzip::BlockSize) {
+			return 0;
+		}
+		return member_size;
+	}
+
+	bool compressBlockGzipMember(const std::vector<uint8_t> &block, std::vector<uint8_t> &member, int level) {
+		z_stream stream = {};
+		if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return false;
+		}
+
+		member.resize(BlockGzipHeaderSize + deflateBound(&stream, static_cast<uLong>(block.size())) + BlockGzipTrailerSize);
+		stream.next_in = const_cast<Bytef*>(block.data());
+		stream.avail_in = static_cast<uInt>(block.size());
+		stream.next_out = member.data() + BlockGzipHeaderSize;
+		stream.avail_out = static_cast<uInt>(member.size() - BlockGzipHeaderSize - BlockGzipTrailerSize);
+
+		const int status = deflate(&stream, Z_FINISH);
+		const size_t compressed_size = stream.total_out;
+		deflateEnd(&stream);
+		if (status != Z_STREAM_END) {
+			return false;
+		}
+
+		member.resize(BlockGzipHeaderSize + compressed_size + BlockGzipTrailerSize);
+		uint8_t* header = member.data();
+		header[0] = 0x1F;
+		header[1] = 0x8B;
+		header[2] = Z_DEFLATED;
+		header[3] = 0x04; // FEXTRA
+		putU32(header + 4, 0); // No modification time
+		header[8] = 0;
+		header[9] = 0xFF; // Unknown OS
+		putU16(header + 10, 12);
+		header[12] = 'R';
+		header[13] = 'M';
+		putU16(header + 14, 8);
+		putU32(header + 16, static_cast<uint32_t>(member.size()));
+		putU32(header + 20, static_cast<uint32_t>(block.size()));
+
+		uint8_t* trailer = member.data() + member.size() - BlockGzipTrailerSize;
+		putU32(trailer, static_cast<uint32_t>(crc32(0, block.data(), static_cast<uInt>(block.size()))));
+		putU32(trailer + 4, static_cast<uint32_t>(block.size()));
+		return true;
+	}
+
+	bool inflateBlockGzipMember(const std::vector<uint8_t> &member, std::vector<uint8_t> &block) {
+		z_stream stream = {};
+		// Gzip only, which checks the CRC32 and size in the trailer as well
+		if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+			return false;
+		}
+
+		stream.next_in = const_cast<Bytef*>(member.data());
+		stream.avail_in = static_cast<uInt>(member.size());
+		stream.next_out = block.data();
+		stream.avail_out = static_cast<uInt>(block.size());
+
+		const int status = inflate(&stream, Z_FINISH);
+		const bool complete = status == Z_STREAM_END && stream.total_out == block.size() && stream.avail_in == 0;
+		inflateEnd(&stream);
+		return complete;
+	}
+}
+
+BlockGzipWriter::BlockGzipWriter(const std::string &filename, int level) :
+	file(filename),
+	level(level),
+	blocks(ThreadPool::getInstance().getThreadCount() * BlockGzip::BlocksPerThread),
+	members(blocks.size()) {
+	////
+}
+
+BlockGzipWriter::~BlockGzipWriter() {
+	finish();
+}
+
+bool BlockGzipWriter::write(const uint8_t* data, size_t size) {
+	while (size != 0 && isOk()) {
+		std::vector<uint8_t> &block = blocks[current];
+		if (block.size() == BlockGzip::BlockSize) {
+			if (++current == blocks.size()) {
+				flushBlocks();
+			}
+			continue;
+		}
+
+		if (block.capacity() < BlockGzip::BlockSize) {
+			block.reserve(BlockGzip::BlockSize);
+		}
+		const size_t chunk = std::min(size, BlockGzip::BlockSize - block.size());
+		block.insert(block.end(), data, data + chunk);
+		data += chunk;
+		size -= chunk;
+	}
+	return isOk();
+}
+
+bool BlockGzipWriter::finish() {
+	if (!file.isOpen()) {
+		return ok;
+	}
+
+	if (current < blocks.size() && !blocks[current].empty()) {
+		++current;
+	}
+	flushBlocks();
+
+	file.flush();
+	ok = ok && file.isOk();
+	file.close();
+	return ok;
+}
+
+bool BlockGzipWriter::flushBlocks() {
+	const size_t count = current;
+	current = 0;
+	if (count == 0 || !isOk()) {
+		return isOk();
+	}
+
+	std::vector<char> compressed(count, 0);
+	ThreadPool::getInstance().parallelFor(count, 1, [&](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i) {
+			compressed[i] = compressBlockGzipMember(blocks[i], members[i], level);
+		}
+	});
+
+	for (size_t i = 0; i < count; ++i) {
+		ok = ok && compressed[i] && file.addRAW(members[i].data(), members[i].size());
+		blocks[i].clear();
+	}
+	return isOk();
+}
+
+BlockGzipReader::BlockGzipReader(const std::string &filename) :
+	file(filename) {
+	uint8_t header[BlockGzipHeaderSize];
+	uint32_t inflated_size;
+	if (!file.isOk() || file.size() < BlockGzipHeaderSize || !file.getRAW(header, sizeof(header))) {
+		ok = false;
+		return;
+	}
+
+	block_file = parseBlockGzipHeader(header, inflated_size) != 0;
+	file.seek(0);
+
+	const size_t batch_size = ThreadPool::getInstance().getThreadCount() * BlockGzip::BlocksPerThread;
+	members.resize(batch_size);
+	blocks.resize(batch_size);
+}
+
+bool BlockGzipReader::next(const uint8_t*&data, size_t &size) {
+	if (current == count && (!readBlocks() || count == 0)) {
+		return false;
+	}
+
+	data = blocks[current].data();
+	size = blocks[current].size();
+	++current;
+	return true;
+}
+
+bool BlockGzipReader::readBlocks() {
+	current = 0;
+	count = 0;
+	if (!ok || !block_file) {
+		return false;
+	}
+
+	while (count < members.size() && file.tell() < file.size()) {
+		uint8_t header[BlockGzipHeaderSize];
+		uint32_t inflated_size = 0;
+		uint32_t member_size = 0;
+		if (file.getRAW(header, sizeof(header))) {
+			member_size = parseBlockGzipHeader(header, inflated_size);
+		}
+		if (member_size == 0) {
+			ok = false;
+			return false;
+		}
+
+		std::vector<uint8_t> &member = members[count];
+		member.resize(member_size);
+		std::copy(header, header + sizeof(header), member.begin());
+		if (!file.getRAW(member.data() + sizeof(header), member_size - sizeof(header))) {
+			ok = false;
+			return false;
+		}
+		blocks[count].resize(inflated_size);
+		++count;
+	}
+
+	std::vector<char> inflated(count, 0);
+	ThreadPool::getInstance().parallelFor(count, 1, [&](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i) {
+			inflated[i] = inflateBlockGzipMember(members[i], blocks[i]);
+		}
+	});
+
+	for (size_t i = 0; i < count; ++i) {
+		ok = ok && inflated[i];
+	}
+	return ok;
+}
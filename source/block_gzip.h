@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_BLOCK_GZIP_H_
+#define RME_BLOCK_GZIP_H_
+
+#include "filehandle.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Gzip files made of independently compressed members of at most BlockSize bytes each. Members
+// are simply concatenated, so any gzip reader inflates the file as one stream, but each of them
+// is compressed on its own thread. Every member also records its compressed and inflated size in
+// an extra header field, which lets BlockGzipReader find the members without inflating anything
+// and inflate them on every thread as well.
+namespace BlockGzip {
+	constexpr size_t BlockSize = 1024 * 1024;
+	// Same as gzip itself
+	constexpr int DefaultLevel = 6;
+	// Blocks kept in memory per thread of the pool while compressing or inflating
+	constexpr size_t BlocksPerThread = 2;
+}
+
+class BlockGzipWriter {
+public:
+	explicit BlockGzipWriter(const std::string &filename, int level = BlockGzip::DefaultLevel);
+	~BlockGzipWriter();
+
+	BlockGzipWriter(const BlockGzipWriter &) = delete;
+	BlockGzipWriter &operator=(const BlockGzipWriter &) = delete;
+
+	bool isOk() {
+		return ok && file.isOk();
+	}
+
+	bool write(const uint8_t* data, size_t size);
+	// Compresses and writes everything still buffered, nothing can be written afterwards
+	bool finish();
+
+private:
+	// Compresses the filled blocks on every thread and writes them in order
+	bool flushBlocks();
+
+	FileWriteHandle file;
+	int level;
+	bool ok = true;
+
+	std::vector<std::vector<uint8_t>> blocks;
+	std::vector<std::vector<uint8_t>> members;
+	size_t current = 0;
+};
+
+class BlockGzipReader {
+public:
+	explicit BlockGzipReader(const std::string &filename);
+
+	BlockGzipReader(const BlockGzipReader &) = delete;
+	BlockGzipReader &operator=(const BlockGzipReader &) = delete;
+
+	// Whether the file starts with a member written by BlockGzipWriter, any other gzip file has to
+	// be inflated as a single stream
+	bool isBlockFile() const noexcept {
+		return block_file;
+	}
+	bool isOk() const noexcept {
+		return ok;
+	}
+
+	// The next inflated block, valid until the following call. Returns false at the end of the
+	// file and on errors, which isOk tells apart.
+	bool next(const uint8_t*&data, size_t &size);
+
+private:
+	// Reads the next members and inflates them on every thread
+	bool readBlocks();
+
+	FileReadHandle file;
+	bool block_file = false;
+	bool ok = true;
+
+	std::vector<std::vector<uint8_t>> members;
+	std::vector<std::vector<uint8_t>> blocks;
+	size_t count = 0;
+	size_t current = 0;
+};
+
+#endif
@@ -170,8 +170,7 @@ void CarpetBrush::undraw(BaseMap* map, Tile* tile) {
 }
 
 void CarpetBrush::doCarpets(BaseMap* map, Tile* tile) {
-	static const auto hasMatchingCarpetBrushAtTile = [](BaseMap* map, CarpetBrush* carpetBrush, uint32_t x, uint32_t y, uint32_t z) -> bool {
-		Tile* tile = map->getTile(x, y, z);
+	static const auto hasMatchingCarpetBrushAtTile = [](const Tile* tile, CarpetBrush* carpetBrush) -> bool {
 		if (!tile) {
 			return false;
 		}
@@ -189,20 +188,7 @@ void CarpetBrush::doCarpets(BaseMap* map, Tile* tile) {
 		return;
 	}
 
-	const Position &position = tile->getPosition();
-	uint32_t x = position.x;
-	uint32_t y = position.y;
-	uint32_t z = position.z;
-	/*
-	static const std::pair<int32_t, int32_t> positionOffset[8] = {
-		{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}
-	};
-
-	const auto& offset = positionOffset[i];
-	if(neighbours[i] && hasMatchingCarpetBrushAtTile(map, carpetBrush, x + offset.first, y + offset.second, z)) {
-		//
-	}
-	*/
+	const TileNeighborhood neighborhood(map, tile->getPosition());
 	for (Item* item : tile->items) {
 		ASSERT(item);
 
@@ -212,44 +198,8 @@ void CarpetBrush::doCarpets(BaseMap* map, Tile* tile) {
 		}
 
 		bool neighbours[8] = { false };
-		if (x == 0) {
-			if (y == 0) {
-				neighbours[0] = false;
-				neighbours[1] = false;
-				neighbours[2] = false;
-				neighbours[3] = false;
-				neighbours[4] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y, z);
-				neighbours[5] = false;
-				neighbours[6] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x, y + 1, z);
-				neighbours[7] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y + 1, z);
-			} else {
-				neighbours[0] = false;
-				neighbours[1] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x, y - 1, z);
-				neighbours[2] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y - 1, z);
-				neighbours[3] = false;
-				neighbours[4] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y, z);
-				neighbours[5] = false;
-				neighbours[6] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x, y + 1, z);
-				neighbours[7] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y + 1, z);
-			}
-		} else if (y == 0) {
-			neighbours[0] = false;
-			neighbours[1] = false;
-			neighbours[2] = false;
-			neighbours[3] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x - 1, y, z);
-			neighbours[4] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y, z);
-			neighbours[5] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x - 1, y + 1, z);
-			neighbours[6] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x, y + 1, z);
-			neighbours[7] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y + 1, z);
-		} else {
-			neighbours[0] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x - 1, y - 1, z);
-			neighbours[1] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x, y - 1, z);
-			neighbours[2] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y - 1, z);
-			neighbours[3] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x - 1, y, z);
-			neighbours[4] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y, z);
-			neighbours[5] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x - 1, y + 1, z);
-			neighbours[6] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x, y + 1, z);
-			neighbours[7] = hasMatchingCarpetBrushAtTile(map, carpetBrush, x + 1, y + 1, z);
+		for (uint32_t i = 0; i < 8; ++i) {
+			neighbours[i] = hasMatchingCarpetBrushAtTile(neighborhood.getNeighbor(i), carpetBrush);
 		}
 
 		uint32_t tileData = 0;
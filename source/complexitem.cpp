@@ -44,6 +44,23 @@ Item* Container::deepCopy() const {
 	return copy;
 }
 
+bool Container::matches(const Item &other) const {
+	if (!Item::matches(other)) {
+		return false;
+	}
+
+	const Container &container = static_cast<const Container &>(other);
+	if (contents.size() != container.contents.size()) {
+		return false;
+	}
+	for (size_t index = 0; index < contents.size(); ++index) {
+		if (!contents[index]->matches(*container.contents[index])) {
+			return false;
+		}
+	}
+	return true;
+}
+
 Item* Container::getItem(size_t index) const {
 	if (index >= 0 && index < contents.size()) {
 		return contents.at(index);
@@ -66,6 +83,10 @@ Item* Teleport::deepCopy() const {
 	return copy;
 }
 
+bool Teleport::matches(const Item &other) const {
+	return Item::matches(other) && destination == static_cast<const Teleport &>(other).destination;
+}
+
 // Door
 Door::Door(const uint16_t type) :
 	Item(type, 0),
@@ -81,6 +102,10 @@ Item* Door::deepCopy() const {
 	return copy;
 }
 
+bool Door::matches(const Item &other) const {
+	return Item::matches(other) && doorId == static_cast<const Door &>(other).doorId;
+}
+
 // Depot
 Depot::Depot(const uint16_t type) :
 	Item(type, 0),
@@ -95,3 +120,7 @@ Item* Depot::deepCopy() const {
 	}
 	return copy;
 }
+
+bool Depot::matches(const Item &other) const {
+	return Item::matches(other) && depotId == static_cast<const Depot &>(other).depotId;
+}
@@ -37,6 +37,7 @@ public:
 	~Container();
 
 	Item* deepCopy() const override;
+	bool matches(const Item &other) const override;
 	Container* getContainer() override {
 		return this;
 	}
@@ -68,6 +69,7 @@ public:
 	Teleport(const uint16_t type);
 
 	Item* deepCopy() const override;
+	bool matches(const Item &other) const override;
 	Teleport* getTeleport() override {
 		return this;
 	}
@@ -106,6 +108,7 @@ public:
 	Door(const uint16_t type);
 
 	Item* deepCopy() const override;
+	bool matches(const Item &other) const override;
 	Door* getDoor() override {
 		return this;
 	}
@@ -130,6 +133,7 @@ public:
 	Depot(const uint16_t _type);
 
 	Item* deepCopy() const override;
+	bool matches(const Item &other) const override;
 	Depot* getDepot() override {
 		return this;
 	}
@@ -20,6 +20,7 @@
 #include "editor.h"
 #include "materials.h"
 #include "map.h"
+#include "map_pager.h"
 #include "client_assets.h"
 #include "complexitem.h"
 #include "settings.h"
@@ -97,7 +98,8 @@ Editor::Editor(CopyBuffer &copybuffer, const FileName &fn) :
 		throw std::runtime_error("Could not open file \"" + nstr(fn.GetFullPath()) + "\".\nThis is not a valid OTBM file or it does not exist.");
 	}
 
-	if (ver.otbm != g_gui.getLoadedMapVersion().otbm) {
+	// Batch mode never has another map open that would have to be closed
+	if (!g_gui.IsHeadless() && ver.otbm != g_gui.getLoadedMapVersion().otbm) {
 		auto result = g_gui.PopupDialog("Map error", "The loaded map appears to be a OTBM format that is not supported by the editor. Do you still want to attempt to load the map? Caution: this will close your current map!", wxYES | wxNO);
 		if (result == wxID_YES) {
 			if (!g_gui.CloseAllEditors()) {
@@ -117,7 +119,7 @@ Editor::Editor(CopyBuffer &copybuffer, const FileName &fn) :
 	if (!success) {
 		g_gui.PopupDialog("Error", error, wxOK);
 		auto clientDirectory = ClientAssets::getPath().ToStdString() + "/";
-		if (!wxDirExists(wxString(clientDirectory))) {
+		if (!g_gui.IsHeadless() && !wxDirExists(wxString(clientDirectory))) {
 			PreferencesWindow dialog(nullptr);
 			dialog.getBookCtrl().SetSelection(4);
 			dialog.ShowModal();
@@ -142,6 +144,19 @@ Editor::Editor(CopyBuffer &copybuffer, LiveClient* client) :
 	replace_brush(nullptr) { }
 
 Editor::~Editor() {
+	// The files of a background save have to be complete before the map goes away
+	if (background_save) {
+		background_save->editor = nullptr;
+		if (save_thread.joinable()) {
+			save_thread.join();
+		}
+		// The tabs report it with waitForBackgroundSave before closing, no dialog while tearing down
+		if (!background_save->success) {
+			spdlog::error("Could not save {}, unable to open target for writing.\n{}", map.name, nstr(background_save->error));
+		}
+		background_save.reset();
+	}
+
 	if (IsLive()) {
 		CloseLiveServer();
 	}
@@ -238,17 +253,16 @@ void Editor::clearChanges() {
 	map.clearChanges();
 }
 
-void Editor::saveMap(FileName filename, bool showdialog) {
-	std::string savefile = filename.GetFullPath().mb_str(wxConvUTF8).data();
-	bool save_as = false;
-	bool save_otgz = false;
+Editor::SaveTarget Editor::prepareSave(const FileName &filename) {
+	SaveTarget target;
+	target.savefile = filename.GetFullPath().mb_str(wxConvUTF8).data();
 
-	if (savefile.empty()) {
-		savefile = map.filename;
+	if (target.savefile.empty()) {
+		target.savefile = map.filename;
 
-		FileName c1(wxstr(savefile));
+		FileName c1(wxstr(target.savefile));
 		FileName c2(wxstr(map.filename));
-		save_as = c1 != c2;
+		target.save_as = c1 != c2;
 	}
 
 	// If not named yet, propagate the file name to the auxilliary files
@@ -270,70 +284,186 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 
 	// File object to convert between local paths etc.
 	FileName converter;
-	converter.Assign(wxstr(savefile));
-	std::string map_path = nstr(converter.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
+	converter.Assign(wxstr(target.savefile));
+	target.map_path = nstr(converter.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
+	target.save_otgz = converter.GetExt() == "otgz";
+
+	target.housefile = map.housefile;
+	target.spawnmonsterfile = map.spawnmonsterfile;
+	target.spawnnpcfile = map.spawnnpcfile;
+	target.zonefile = map.zonefile;
+
+	target.runfile = nstr(g_gui.GetLocalDataDirectory()) + ".saving.txt";
+	target.make_backup = !target.save_as && g_settings.getInteger(Config::ALWAYS_MAKE_BACKUP);
+	return target;
+}
 
-	// Make temporary backups
-	// converter.Assign(wxstr(savefile));
-	std::string backup_otbm, backup_house, backup_spawn, backup_spawn_npc, backup_zones;
+void Editor::makeTemporaryBackups(SaveTarget &target) {
+	FileName converter;
+	converter.Assign(wxstr(target.savefile));
+	const std::string &map_path = target.map_path;
 
-	if (converter.GetExt() == "otgz") {
-		save_otgz = true;
+	if (target.save_otgz) {
 		if (converter.FileExists()) {
-			backup_otbm = map_path + nstr(converter.GetName()) + ".otgz~";
-			std::remove(backup_otbm.c_str());
-			std::rename(savefile.c_str(), backup_otbm.c_str());
+			target.backup_otbm = map_path + nstr(converter.GetName()) + ".otgz~";
+			std::remove(target.backup_otbm.c_str());
+			std::rename(target.savefile.c_str(), target.backup_otbm.c_str());
 		}
 	} else {
 		if (converter.FileExists()) {
-			backup_otbm = map_path + nstr(converter.GetName()) + ".otbm~";
-			std::remove(backup_otbm.c_str());
-			std::rename(savefile.c_str(), backup_otbm.c_str());
+			target.backup_otbm = map_path + nstr(converter.GetName()) + ".otbm~";
+			std::remove(target.backup_otbm.c_str());
+			std::rename(target.savefile.c_str(), target.backup_otbm.c_str());
 		}
 
-		converter.SetFullName(wxstr(map.housefile));
+		converter.SetFullName(wxstr(target.housefile));
 		if (converter.FileExists()) {
-			backup_house = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_house.c_str());
-			std::rename((map_path + map.housefile).c_str(), backup_house.c_str());
+			target.backup_house = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(target.backup_house.c_str());
+			std::rename((map_path + target.housefile).c_str(), target.backup_house.c_str());
 		}
 
-		converter.SetFullName(wxstr(map.spawnmonsterfile));
+		converter.SetFullName(wxstr(target.spawnmonsterfile));
 		if (converter.FileExists()) {
-			backup_spawn = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_spawn.c_str());
-			std::rename((map_path + map.spawnmonsterfile).c_str(), backup_spawn.c_str());
+			target.backup_spawn = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(target.backup_spawn.c_str());
+			std::rename((map_path + target.spawnmonsterfile).c_str(), target.backup_spawn.c_str());
 		}
 
-		converter.SetFullName(wxstr(map.spawnnpcfile));
+		converter.SetFullName(wxstr(target.spawnnpcfile));
 		if (converter.FileExists()) {
-			backup_spawn_npc = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_spawn_npc.c_str());
-			std::rename((map_path + map.spawnnpcfile).c_str(), backup_spawn_npc.c_str());
+			target.backup_spawn_npc = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(target.backup_spawn_npc.c_str());
+			std::rename((map_path + target.spawnnpcfile).c_str(), target.backup_spawn_npc.c_str());
 		}
 
-		converter.SetFullName(wxstr(map.zonefile));
+		converter.SetFullName(wxstr(target.zonefile));
 		if (converter.FileExists()) {
-			backup_zones = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_zones.c_str());
-			std::rename((map_path + map.zonefile).c_str(), backup_zones.c_str());
+			target.backup_zones = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(target.backup_zones.c_str());
+			std::rename((map_path + target.zonefile).c_str(), target.backup_zones.c_str());
 		}
 	}
 
-	// Save the map
-	{
-		std::string n = nstr(g_gui.GetLocalDataDirectory()) + ".saving.txt";
-		std::ofstream f(n.c_str(), std::ios::trunc | std::ios::out);
-		f << backup_otbm << std::endl
-		  << backup_house << std::endl
-		  << backup_spawn << std::endl
-		  << backup_spawn_npc << std::endl;
+	// Save runfile, lists the backups in case the editor dies while saving
+	std::ofstream f(target.runfile.c_str(), std::ios::trunc | std::ios::out);
+	f << target.backup_otbm << std::endl
+	  << target.backup_house << std::endl
+	  << target.backup_spawn << std::endl
+	  << target.backup_spawn_npc << std::endl;
+}
+
+void Editor::restoreTemporaryBackups(const SaveTarget &target) {
+	// Rename the temporary backup files back to their previous names
+	FileName converter;
+	const std::string &map_path = target.map_path;
+
+	if (!target.backup_otbm.empty()) {
+		converter.SetFullName(wxstr(target.savefile));
+		std::string otbm_filename = map_path + nstr(converter.GetName());
+		std::rename(target.backup_otbm.c_str(), std::string(otbm_filename + (target.save_otgz ? ".otgz" : ".otbm")).c_str());
 	}
 
-	{
+	if (!target.backup_house.empty()) {
+		converter.SetFullName(wxstr(target.housefile));
+		std::string house_filename = map_path + nstr(converter.GetName());
+		std::rename(target.backup_house.c_str(), std::string(house_filename + ".xml").c_str());
+	}
+
+	if (!target.backup_spawn.empty()) {
+		converter.SetFullName(wxstr(target.spawnmonsterfile));
+		std::string spawn_filename = map_path + nstr(converter.GetName());
+		std::rename(target.backup_spawn.c_str(), std::string(spawn_filename + ".xml").c_str());
+	}
 
+	if (!target.backup_spawn_npc.empty()) {
+		converter.SetFullName(wxstr(target.spawnnpcfile));
+		std::string spawnnpc_filename = map_path + nstr(converter.GetName());
+		std::rename(target.backup_spawn_npc.c_str(), std::string(spawnnpc_filename + ".xml").c_str());
+	}
+
+	if (!target.backup_zones.empty()) {
+		converter.SetFullName(wxstr(target.zonefile));
+		std::string zones_filename = map_path + nstr(converter.GetName());
+		std::rename(target.backup_zones.c_str(), std::string(zones_filename + ".xml").c_str());
+	}
+}
+
+void Editor::finishTemporaryBackups(const SaveTarget &target) {
+	if (!target.make_backup) {
+		// Delete the temporary files
+		std::remove(target.backup_otbm.c_str());
+		std::remove(target.backup_house.c_str());
+		std::remove(target.backup_spawn.c_str());
+		std::remove(target.backup_spawn_npc.c_str());
+		std::remove(target.backup_zones.c_str());
+		return;
+	}
+
+	// Move to permanent backup
+	FileName converter;
+	std::string backup_path = target.map_path + "backups/";
+	ensureBackupDirectoryExists(backup_path);
+	// Move temporary backups to their proper files
+	time_t t = time(nullptr);
+	tm* current_time = localtime(&t);
+	ASSERT(current_time);
+
+	std::ostringstream date;
+	date << (1900 + current_time->tm_year);
+	if (current_time->tm_mon < 9) {
+		date << "-"
+			 << "0" << current_time->tm_mon + 1;
+	} else {
+		date << "-" << current_time->tm_mon + 1;
+	}
+	date << "-" << current_time->tm_mday;
+	date << "-" << current_time->tm_hour;
+	date << "-" << current_time->tm_min;
+	date << "-" << current_time->tm_sec;
+
+	if (!target.backup_otbm.empty()) {
+		converter.SetFullName(wxstr(target.savefile));
+		std::string otbm_filename = backup_path + nstr(converter.GetName());
+		std::rename(target.backup_otbm.c_str(), std::string(otbm_filename + "." + date.str() + (target.save_otgz ? ".otgz" : ".otbm")).c_str());
+	}
+
+	if (!target.backup_house.empty()) {
+		converter.SetFullName(wxstr(target.housefile));
+		std::string house_filename = backup_path + nstr(converter.GetName());
+		std::rename(target.backup_house.c_str(), std::string(house_filename + "." + date.str() + ".xml").c_str());
+	}
+
+	if (!target.backup_spawn.empty()) {
+		converter.SetFullName(wxstr(target.spawnmonsterfile));
+		std::string spawn_filename = backup_path + nstr(converter.GetName());
+		std::rename(target.backup_spawn.c_str(), std::string(spawn_filename + "." + date.str() + ".xml").c_str());
+	}
+
+	if (!target.backup_spawn_npc.empty()) {
+		converter.SetFullName(wxstr(target.spawnnpcfile));
+		std::string spawnnpc_filename = backup_path + nstr(converter.GetName());
+		std::rename(target.backup_spawn_npc.c_str(), std::string(spawnnpc_filename + "." + date.str() + ".xml").c_str());
+	}
+
+	if (!target.backup_zones.empty()) {
+		converter.SetFullName(wxstr(target.zonefile));
+		std::string zones_filename = backup_path + nstr(converter.GetName());
+		std::rename(target.backup_zones.c_str(), std::string(zones_filename + "." + date.str() + ".xml").c_str());
+	}
+}
+
+bool Editor::saveMap(FileName filename, bool showdialog) {
+	// A save that is still written in the background replaces the same files
+	waitForBackgroundSave();
+
+	SaveTarget target = prepareSave(filename);
+	makeTemporaryBackups(target);
+
+	// Save the map
+	{
 		// Set up the Map paths
-		wxFileName fn = wxstr(savefile);
+		wxFileName fn = wxstr(target.savefile);
 		map.filename = fn.GetFullPath().mb_str(wxConvUTF8);
 		map.name = fn.GetFullName().mb_str(wxConvUTF8);
 
@@ -351,116 +481,128 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 
 		// Check for errors...
 		if (!success) {
-			// Rename the temporary backup files back to their previous names
-			if (!backup_otbm.empty()) {
-				converter.SetFullName(wxstr(savefile));
-				std::string otbm_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_otbm.c_str(), std::string(otbm_filename + (save_otgz ? ".otgz" : ".otbm")).c_str());
-			}
-
-			if (!backup_house.empty()) {
-				converter.SetFullName(wxstr(map.housefile));
-				std::string house_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_house.c_str(), std::string(house_filename + ".xml").c_str());
-			}
-
-			if (!backup_spawn.empty()) {
-				converter.SetFullName(wxstr(map.spawnmonsterfile));
-				std::string spawn_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_spawn.c_str(), std::string(spawn_filename + ".xml").c_str());
-			}
-
-			if (!backup_spawn_npc.empty()) {
-				converter.SetFullName(wxstr(map.spawnnpcfile));
-				std::string spawnnpc_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_spawn_npc.c_str(), std::string(spawnnpc_filename + ".xml").c_str());
-			}
-
-			if (!backup_zones.empty()) {
-				converter.SetFullName(wxstr(map.zonefile));
-				std::string zones_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_zones.c_str(), std::string(zones_filename + ".xml").c_str());
-			}
+			restoreTemporaryBackups(target);
 
 			// Display the error
 			g_gui.PopupDialog("Error", "Could not save, unable to open target for writing.", wxOK);
 		}
 
 		// Remove temporary save runfile
-		{
-			std::string n = nstr(g_gui.GetLocalDataDirectory()) + ".saving.txt";
-			std::remove(n.c_str());
-		}
+		std::remove(target.runfile.c_str());
 
 		// If failure, don't run the rest of the function
 		if (!success) {
-			return;
+			return false;
 		}
 	}
 
-	// Move to permanent backup
-	if (!save_as && g_settings.getInteger(Config::ALWAYS_MAKE_BACKUP)) {
-		std::string backup_path = map_path + "backups/";
-		ensureBackupDirectoryExists(backup_path);
-		// Move temporary backups to their proper files
-		time_t t = time(nullptr);
-		tm* current_time = localtime(&t);
-		ASSERT(current_time);
-
-		std::ostringstream date;
-		date << (1900 + current_time->tm_year);
-		if (current_time->tm_mon < 9) {
-			date << "-"
-				 << "0" << current_time->tm_mon + 1;
-		} else {
-			date << "-" << current_time->tm_mon + 1;
-		}
-		date << "-" << current_time->tm_mday;
-		date << "-" << current_time->tm_hour;
-		date << "-" << current_time->tm_min;
-		date << "-" << current_time->tm_sec;
+	finishTemporaryBackups(target);
+	deleteOldBackups(target.map_path + "backups/");
 
-		if (!backup_otbm.empty()) {
-			converter.SetFullName(wxstr(savefile));
-			std::string otbm_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_otbm.c_str(), std::string(otbm_filename + "." + date.str() + (save_otgz ? ".otgz" : ".otbm")).c_str());
-		}
+	clearChanges();
+	return true;
+}
 
-		if (!backup_house.empty()) {
-			converter.SetFullName(wxstr(map.housefile));
-			std::string house_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_house.c_str(), std::string(house_filename + "." + date.str() + ".xml").c_str());
-		}
+void Editor::saveMapInBackground(FileName filename) {
+	waitForBackgroundSave();
 
-		if (!backup_spawn.empty()) {
-			converter.SetFullName(wxstr(map.spawnmonsterfile));
-			std::string spawn_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_spawn.c_str(), std::string(spawn_filename + "." + date.str() + ".xml").c_str());
-		}
+	// Compressed maps are written in one go and paged maps copy the areas they never read
+	// from the file that is replaced, neither can be snapshotted
+	const FileName target_name = filename.GetFullPath().empty() ? FileName(wxstr(map.filename)) : filename;
+	if (target_name.GetExt() == "otgz" || map.getPager()) {
+		saveMap(filename, true);
+		return;
+	}
 
-		if (!backup_spawn_npc.empty()) {
-			converter.SetFullName(wxstr(map.spawnnpcfile));
-			std::string spawnnpc_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_spawn_npc.c_str(), std::string(spawnnpc_filename + "." + date.str() + ".xml").c_str());
-		}
+	SaveTarget target = prepareSave(filename);
+
+	wxFileName fn = wxstr(target.savefile);
+	map.filename = fn.GetFullPath().mb_str(wxConvUTF8);
+	map.name = fn.GetFullName().mb_str(wxConvUTF8);
+
+	// Everything that changed since the last save is encoded here, the rest is already encoded
+	// in the save cache and only copied by the writer
+	g_gui.CreateLoadBar("Preparing OTBM map...");
+	OTBMSaveSnapshot snapshot;
+	IOMapOTBM mapsaver(map.getVersion());
+	const bool prepared = mapsaver.snapshotMap(map, fn, snapshot);
+	g_gui.DestroyLoadBar();
+
+	if (!prepared) {
+		g_gui.PopupDialog("Error", mapsaver.getError(), wxOK);
+		return;
+	}
+
+	auto save = std::make_shared<BackgroundSave>();
+	save->editor = this;
+	save->target = std::move(target);
+	save->change_count = map.getChangeCount();
+	background_save = save;
+
+	g_gui.SetStatusText("Saving " + wxstr(map.name) + "...");
+
+	save_thread = std::thread([save, snapshot = std::move(snapshot), version = map.getVersion()]() {
+		makeTemporaryBackups(save->target);
 
-		if (!backup_zones.empty()) {
-			converter.SetFullName(wxstr(map.zonefile));
-			std::string zones_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_zones.c_str(), std::string(zones_filename + "." + date.str() + ".xml").c_str());
+		IOMapOTBM writer(version);
+		int reported = 0;
+		save->success = writer.writeSnapshot(snapshot, [&](uint64_t done, uint64_t total) {
+			// Only every tenth so the event queue is not flooded
+			const int percent = static_cast<int>(done * 10 / std::max<uint64_t>(total, 1)) * 10;
+			if (percent == reported) {
+				return;
+			}
+			reported = percent;
+			wxTheApp->CallAfter([save, percent]() {
+				if (save->editor && save->editor->background_save == save) {
+					g_gui.SetStatusText(wxString::Format("Saving %s... %d%%", wxstr(save->editor->map.name), percent));
+				}
+			});
+		});
+		save->error = writer.getError();
+
+		if (save->success) {
+			finishTemporaryBackups(save->target);
+		} else {
+			restoreTemporaryBackups(save->target);
 		}
-	} else {
-		// Delete the temporary files
-		std::remove(backup_otbm.c_str());
-		std::remove(backup_house.c_str());
-		std::remove(backup_spawn.c_str());
-		std::remove(backup_spawn_npc.c_str());
-		std::remove(backup_zones.c_str());
+		std::remove(save->target.runfile.c_str());
+
+		wxTheApp->CallAfter([save]() {
+			// Already finished by waitForBackgroundSave or the editor is gone
+			if (save->editor && save->editor->background_save == save) {
+				save->editor->finishBackgroundSave();
+			}
+		});
+	});
+}
+
+void Editor::waitForBackgroundSave() {
+	if (background_save) {
+		finishBackgroundSave();
 	}
+}
 
-	deleteOldBackups(map_path + "backups/");
+void Editor::finishBackgroundSave() {
+	std::shared_ptr<BackgroundSave> save = std::move(background_save);
+	save_thread.join();
 
-	clearChanges();
+	if (!save->success) {
+		g_gui.SetStatusText("Could not save " + wxstr(map.name));
+		g_gui.PopupDialog("Error", "Could not save, unable to open target for writing.\n" + save->error, wxOK);
+		return;
+	}
+
+	deleteOldBackups(save->target.map_path + "backups/");
+
+	// Whatever was changed while the files were written still has to be saved
+	if (map.getChangeCount() == save->change_count) {
+		clearChanges();
+	}
+
+	g_gui.SetStatusText("Saved " + wxstr(map.name));
+	g_gui.UpdateTitle();
+	g_gui.UpdateMenubar();
 }
 
 bool Editor::importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset) {
@@ -854,15 +996,21 @@ void Editor::borderizeMap(bool showdialog) {
 	}
 
 	uint64_t tiles_done = 0;
-	for (TileLocation* tileLocation : map) {
+	// Changes the tiles in place
+	for (MapIterator map_iter = map.beginMutable(); map_iter != map.end(); ++map_iter) {
 		if (showdialog && tiles_done % 4096 == 0) {
 			g_gui.SetLoadDone(static_cast<int32_t>(tiles_done / double(map.tilecount) * 100.0));
 		}
 
-		Tile* tile = tileLocation->get();
+		Tile* tile = (*map_iter)->get();
 		ASSERT(tile);
 
+		// Borders are changed in place, the shared items must not change along
+		map.memory.removeTile(tile);
+		tile->unshareItems();
 		tile->borderize(&map);
+		tile->compactItems();
+		map.memory.addTile(tile);
 		++tiles_done;
 	}
 
@@ -905,16 +1053,19 @@ void Editor::randomizeMap(bool showdialog) {
 	}
 
 	uint64_t tiles_done = 0;
-	for (TileLocation* tileLocation : map) {
+	// Changes the tiles in place
+	for (MapIterator map_iter = map.beginMutable(); map_iter != map.end(); ++map_iter) {
 		if (showdialog && tiles_done % 4096 == 0) {
 			g_gui.SetLoadDone(static_cast<int32_t>(tiles_done / double(map.tilecount) * 100.0));
 		}
 
-		Tile* tile = tileLocation->get();
+		Tile* tile = (*map_iter)->get();
 		ASSERT(tile);
 
 		GroundBrush* groundBrush = tile->getGroundBrush();
 		if (groundBrush) {
+			map.memory.removeTile(tile);
+			tile->unshareItems();
 			Item* oldGround = tile->ground;
 
 			uint16_t actionId, uniqueId;
@@ -932,7 +1083,9 @@ void Editor::randomizeMap(bool showdialog) {
 				newGround->setActionID(actionId);
 				newGround->setUniqueID(uniqueId);
 			}
+			tile->compactItems();
 			tile->update();
+			map.memory.addTile(tile);
 		}
 		++tiles_done;
 	}
@@ -960,7 +1113,7 @@ void Editor::clearInvalidHouseTiles(bool showdialog) {
 	}
 
 	uint64_t tiles_done = 0;
-	for (MapIterator map_iter = map.begin(); map_iter != map.end(); ++map_iter) {
+	for (MapIterator map_iter = map.beginMutable(); map_iter != map.end(); ++map_iter) {
 		if (showdialog && tiles_done % 4096 == 0) {
 			g_gui.SetLoadDone(int(tiles_done / double(map.tilecount) * 100.0));
 		}
@@ -985,6 +1138,10 @@ void Editor::clearModifiedTileState(bool showdialog) {
 		g_gui.CreateLoadBar("Clearing modified state from all tiles...");
 	}
 
+	// Tiles that are still on disk were never modified, and the flag is not saved
+	MapPager::Suspend suspend_paging(map.getPager());
+	MapSaveCache::Suspend suspend_save_cache(map.save_cache);
+
 	uint64_t tiles_done = 0;
 	for (MapIterator map_iter = map.begin(); map_iter != map.end(); ++map_iter) {
 		if (showdialog && tiles_done % 4096 == 0) {
@@ -1066,44 +1223,15 @@ void Editor::moveSelection(const Position &offset) {
 		TileList borderize_tiles;
 		// Go through all modified (selected) tiles (might be slow)
 		for (const Tile* tile : storage) {
-			const Position &pos = tile->getPosition();
-			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
+			// Go through the tile and all its neighbours
+			const TileNeighborhood neighborhood(&map, tile->getPosition());
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					Tile* t = neighborhood.get(dx, dy);
+					if (t && !t->isSelected()) {
+						borderize_tiles.push_back(t);
+					}
+				}
 			}
 		}
 
@@ -1166,53 +1294,14 @@ void Editor::moveSelection(const Position &offset) {
 		// Go through all modified (selected) tiles (might be slow)
 		for (Tile* tile : selection) {
 			bool add_me = false; // If this tile is touched
-			const Position &pos = tile->getPosition();
 			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
+			const TileNeighborhood neighborhood(&map, tile->getPosition());
+			for (int i = 0; i < 8; ++i) {
+				Tile* t = neighborhood.getNeighbor(i);
+				if (t && !t->isSelected()) {
+					borderize_tiles.push_back(t);
+					add_me = true;
+				}
 			}
 			if (add_me) {
 				borderize_tiles.push_back(tile);
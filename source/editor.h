@@ -26,6 +26,8 @@
 #include "action.h"
 #include "selection.h"
 
+#include <thread>
+
 class BaseMap;
 class CopyBuffer;
 class LiveClient;
@@ -75,7 +77,15 @@ public: // Functions
 	void clearChanges();
 
 	// Map handling
-	void saveMap(FileName filename, bool showdialog); // "" means default filename
+	bool saveMap(FileName filename, bool showdialog); // "" means default filename
+	// Encodes what changed since the last save right away and writes the files on another thread,
+	// the map can be edited meanwhile. Maps that can not be snapshotted are saved by saveMap.
+	void saveMapInBackground(FileName filename);
+	bool isSavingInBackground() const noexcept {
+		return background_save != nullptr;
+	}
+	// Blocks until the files of a background save are written and reports how it went
+	void waitForBackgroundSave();
 
 	Map &getMap() noexcept {
 		return map;
@@ -149,7 +159,7 @@ public: // Functions
 	void undraw(const PositionVector &posvec, bool alt);
 	void undraw(const PositionVector &todraw, PositionVector &toborder, bool alt);
 
-	void ensureBackupDirectoryExists(const std::string &backup_path);
+	static void ensureBackupDirectoryExists(const std::string &backup_path);
 	void deleteOldBackups(const std::string &backup_path);
 
 protected:
@@ -161,10 +171,51 @@ protected:
 	Editor &operator=(const Editor &);
 
 private:
+	// The files a save writes and the temporary backups it keeps of the ones it replaces
+	struct SaveTarget {
+		std::string savefile;
+		std::string map_path;
+		std::string housefile;
+		std::string spawnmonsterfile;
+		std::string spawnnpcfile;
+		std::string zonefile;
+		std::string runfile;
+		bool save_as = false;
+		bool save_otgz = false;
+		bool make_backup = false;
+
+		std::string backup_otbm;
+		std::string backup_house;
+		std::string backup_spawn;
+		std::string backup_spawn_npc;
+		std::string backup_zones;
+	};
+
+	// Shared with the save thread and the events it posts, editor is cleared when the editor goes away
+	struct BackgroundSave {
+		Editor* editor = nullptr;
+		SaveTarget target;
+		uint64_t change_count = 0;
+		bool success = false;
+		wxString error;
+	};
+
+	// Names the auxilliary files of an unnamed map, has to run on the GUI thread
+	SaveTarget prepareSave(const FileName &filename);
+	// These only touch the files and can run on any thread
+	static void makeTemporaryBackups(SaveTarget &target);
+	static void restoreTemporaryBackups(const SaveTarget &target);
+	// Moves the temporary backups to the backup directory or deletes them
+	static void finishTemporaryBackups(const SaveTarget &target);
+	void finishBackgroundSave();
+
 	friend class MapCanvas;
 	Map map;
 	Selection selection;
 	ActionQueue* actionQueue;
+
+	std::shared_ptr<BackgroundSave> background_save;
+	std::thread save_thread;
 };
 
 inline void Editor::draw(const Position &offset, bool alt) {
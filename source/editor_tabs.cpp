@@ -86,6 +86,8 @@ void MapTabbook::OnNotebookPageClose(wxAuiNotebookEvent &event) {
 		}
 
 		if (refresh) {
+			// Reported while the editor is still there
+			editor->waitForBackgroundSave();
 			g_gui.RefreshPalettes(nullptr, false);
 			g_gui.UpdateMenus();
 		}
@@ -187,6 +189,10 @@ void MapTabbook::SetTabLabel(int idx, wxString label) {
 }
 
 void MapTabbook::DeleteTab(int idx) {
+	// The last tab of an editor waits for its background save, so a failure is reported before it goes
+	if (auto* mapTab = dynamic_cast<MapTab*>(GetTab(idx)); mapTab && mapTab->IsUniqueReference()) {
+		mapTab->GetEditor()->waitForBackgroundSave();
+	}
 	if (notebook) {
 		notebook->DeletePage(idx);
 	}
@@ -19,6 +19,15 @@
 
 #include "filehandle.h"
 
+#ifdef __WINDOWS__
+	#include <wx/msw/wrapwin.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 uint8_t NodeFileWriteHandle::NODE_START = ::NODE_START;
 uint8_t NodeFileWriteHandle::NODE_END = ::NODE_END;
 uint8_t NodeFileWriteHandle::ESCAPE_CHAR = ::ESCAPE_CHAR;
@@ -142,6 +151,7 @@ bool FileReadHandle::getLongString(std::string &str) {
 
 NodeFileReadHandle::NodeFileReadHandle() :
 	last_was_start(false),
+	in_memory(false),
 	cache(nullptr),
 	cache_size(32768),
 	cache_length(0),
@@ -186,6 +196,7 @@ void MemoryNodeFileReadHandle::assign(const uint8_t* data, size_t size) {
 	freeNode(root_node);
 	root_node = nullptr;
 	// Highly volatile, but we know we're not gonna modify
+	in_memory = true;
 	cache = const_cast<uint8_t*>(data);
 	cache_size = cache_length = size;
 	local_read_index = 0;
@@ -213,6 +224,143 @@ BinaryNode* MemoryNodeFileReadHandle::getRootNode() {
 	return root_node;
 }
 
+//=============================================================================
+// Memory mapped file
+
+bool MappedFile::open(const std::string &name, bool sequential /* = false */) {
+	close();
+#ifdef __WINDOWS__
+	HANDLE handle = CreateFileW(string2wstring(name).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(handle, &file_size) && file_size.QuadPart > 0) {
+		mapping_handle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle) {
+			data = static_cast<uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+			size = static_cast<size_t>(file_size.QuadPart);
+		}
+	}
+	// The mapping keeps the file open on its own
+	CloseHandle(handle);
+#else
+	const int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+		void* mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			data = static_cast<uint8_t*>(mapped);
+			size = static_cast<size_t>(file_stat.st_size);
+			if (sequential) {
+				madvise(mapped, size, MADV_SEQUENTIAL);
+			}
+		}
+	}
+	::close(fd);
+#endif
+
+	if (!data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef __WINDOWS__
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping_handle) {
+		CloseHandle(mapping_handle);
+		mapping_handle = nullptr;
+	}
+#else
+	if (data) {
+		munmap(data, size);
+	}
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+//=============================================================================
+// Memory mapped node file read handle
+
+MappedNodeFileReadHandle::MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers) {
+	in_memory = true;
+	if (!mapping.open(name, true)) {
+		close();
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+
+	const uint8_t* mapped_data = mapping.getData();
+	const size_t mapped_size = mapping.getSize();
+
+	// 0x00 00 00 00 is accepted as a wildcard version
+	if (mapped_size < 4) {
+		close();
+		error_code = FILE_SYNTAX_ERROR;
+		return;
+	}
+	if (mapped_data[0] != 0 || mapped_data[1] != 0 || mapped_data[2] != 0 || mapped_data[3] != 0) {
+		bool accepted = false;
+		for (const std::string &identifier : acceptable_identifiers) {
+			if (memcmp(mapped_data, identifier.c_str(), 4) == 0) {
+				accepted = true;
+				break;
+			}
+		}
+
+		if (!accepted) {
+			close();
+			error_code = FILE_SYNTAX_ERROR;
+			return;
+		}
+	}
+
+	// Never written to, like the memory handle
+	cache = const_cast<uint8_t*>(mapped_data) + 4;
+	cache_size = cache_length = mapped_size - 4;
+	local_read_index = 0;
+}
+
+MappedNodeFileReadHandle::~MappedNodeFileReadHandle() {
+	close();
+}
+
+void MappedNodeFileReadHandle::close() {
+	freeNode(root_node);
+	root_node = nullptr;
+	mapping.close();
+	cache = nullptr;
+	cache_size = cache_length = 0;
+	local_read_index = 0;
+}
+
+bool MappedNodeFileReadHandle::renewCache() {
+	return false;
+}
+
+BinaryNode* MappedNodeFileReadHandle::getRootNode() {
+	assert(root_node == nullptr); // You should never do this twice
+	if (local_read_index >= cache_length || cache[local_read_index] != NODE_START) {
+		error_code = FILE_SYNTAX_ERROR;
+		return nullptr;
+	}
+
+	++local_read_index;
+	last_was_start = true;
+	root_node = getNode(nullptr);
+	root_node->load();
+	return root_node;
+}
+
 //=============================================================================
 // File based node file read handle
 
@@ -303,6 +451,8 @@ BinaryNode* DiskNodeFileReadHandle::getRootNode() {
 // Binary file node
 
 BinaryNode::BinaryNode(NodeFileReadHandle* file, BinaryNode* parent) :
+	payload(nullptr),
+	payload_size(0),
 	read_offset(0),
 	file(file),
 	parent(parent),
@@ -327,21 +477,21 @@ BinaryNode* BinaryNode::getChild() {
 }
 
 bool BinaryNode::getRAW(uint8_t* ptr, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > payload_size) {
+		read_offset = payload_size;
 		return false;
 	}
-	memcpy(ptr, data.data() + read_offset, sz);
+	memcpy(ptr, payload + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
 
 bool BinaryNode::getRAW(std::string &str, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > payload_size) {
+		read_offset = payload_size;
 		return false;
 	}
-	str.assign(data.data() + read_offset, sz);
+	str.assign(reinterpret_cast<const char*>(payload) + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
@@ -424,6 +574,63 @@ BinaryNode* BinaryNode::advance() {
 
 void BinaryNode::load() {
 	ASSERT(file);
+	if (file->in_memory) {
+		loadInPlace();
+	} else {
+		loadBuffered();
+		payload = reinterpret_cast<const uint8_t*>(data.data());
+		payload_size = data.size();
+	}
+}
+
+void BinaryNode::loadInPlace() {
+	const uint8_t* cache = file->cache;
+	const size_t cache_length = file->cache_length;
+	size_t &local_read_index = file->local_read_index;
+	const size_t start = local_read_index;
+
+	// The three control bytes are the highest byte values, anything below is plain data
+	while (local_read_index < cache_length && cache[local_read_index] < ESCAPE_CHAR) {
+		++local_read_index;
+	}
+	if (local_read_index < cache_length && cache[local_read_index] != ESCAPE_CHAR) {
+		payload = cache + start;
+		payload_size = local_read_index - start;
+		file->last_was_start = cache[local_read_index] == NODE_START;
+		++local_read_index;
+		return;
+	}
+
+	// Escaped bytes, unescape the rest of the node into the scratch buffer
+	data.assign(reinterpret_cast<const char*>(cache + start), local_read_index - start);
+	payload = reinterpret_cast<const uint8_t*>(data.data());
+	payload_size = data.size();
+	while (local_read_index < cache_length) {
+		uint8_t op = cache[local_read_index];
+		++local_read_index;
+
+		if (op == NODE_START || op == NODE_END) {
+			file->last_was_start = op == NODE_START;
+			payload = reinterpret_cast<const uint8_t*>(data.data());
+			payload_size = data.size();
+			return;
+		}
+		if (op == ESCAPE_CHAR) {
+			if (local_read_index >= cache_length) {
+				break;
+			}
+			op = cache[local_read_index];
+			++local_read_index;
+		}
+		data.append(1, static_cast<char>(op));
+	}
+
+	file->error_code = FILE_PREMATURE_END;
+	payload = reinterpret_cast<const uint8_t*>(data.data());
+	payload_size = data.size();
+}
+
+void BinaryNode::loadBuffered() {
 	// Read until next node starts
 	uint8_t*&cache = file->cache;
 	size_t &cache_length = file->cache_length;
@@ -578,6 +785,9 @@ void DiskNodeFileWriteHandle::renewCache() {
 		if (ferror(file) != 0) {
 			error_code = FILE_WRITE_ERROR;
 		}
+		if (observer && local_write_index != 0) {
+			observer(cache, local_write_index);
+		}
 	} else {
 		cache = (uint8_t*)malloc(cache_size + 1);
 	}
@@ -628,6 +838,39 @@ void MemoryNodeFileWriteHandle::renewCache() {
 	}
 }
 
+//=============================================================================
+// Stream based node file write handle
+
+StreamNodeFileWriteHandle::StreamNodeFileWriteHandle(Sink sink) :
+	sink(std::move(sink)) {
+	if (!cache) {
+		cache = (uint8_t*)malloc(cache_size + 1);
+	}
+	local_write_index = 0;
+}
+
+StreamNodeFileWriteHandle::~StreamNodeFileWriteHandle() {
+	close();
+}
+
+void StreamNodeFileWriteHandle::close() {
+	if (cache) {
+		renewCache();
+		free(cache);
+		cache = nullptr;
+	}
+}
+
+void StreamNodeFileWriteHandle::renewCache() {
+	if (local_write_index != 0) {
+		if (sink && error_code == FILE_NO_ERROR && !sink(cache, local_write_index)) {
+			error_code = FILE_WRITE_ERROR;
+		}
+		size += local_write_index;
+	}
+	local_write_index = 0;
+}
+
 //=============================================================================
 // Node file write handle
 
@@ -715,3 +958,17 @@ bool NodeFileWriteHandle::addRAW(const uint8_t* ptr, size_t sz) {
 	writeBytes(ptr, sz);
 	return error_code == FILE_NO_ERROR;
 }
+
+bool NodeFileWriteHandle::addEncodedNode(const uint8_t* ptr, size_t sz) {
+	while (sz != 0) {
+		const size_t chunk = std::min(sz, cache_size - local_write_index);
+		memcpy(cache + local_write_index, ptr, chunk);
+		local_write_index += chunk;
+		ptr += chunk;
+		sz -= chunk;
+		if (local_write_index >= cache_size) {
+			renewCache();
+		}
+	}
+	return error_code == FILE_NO_ERROR;
+}
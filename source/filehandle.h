@@ -19,6 +19,7 @@
 #define RME_FILEHANDLE_H_
 
 #include "definitions.h"
+#include <functional>
 #include <stack>
 
 #ifndef FORCEINLINE
@@ -101,6 +102,9 @@ public:
 	FORCEINLINE bool get32(int32_t &i32) {
 		return getType(i32);
 	}
+	FORCEINLINE bool getU64(uint64_t &u64) {
+		return getType(u64);
+	}
 	bool getRAW(uint8_t* ptr, size_t sz);
 	bool getRAW(std::string &str, size_t sz);
 	bool getString(std::string &str);
@@ -124,6 +128,7 @@ protected:
 class NodeFileReadHandle;
 class DiskNodeFileReadHandle;
 class MemoryNodeFileReadHandle;
+class MappedNodeFileReadHandle;
 
 class BinaryNode {
 public:
@@ -146,8 +151,8 @@ public:
 		return getType(u64);
 	}
 	FORCEINLINE bool skip(size_t sz) {
-		if (read_offset + sz > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sz > payload_size) {
+			read_offset = payload_size;
 			return false;
 		}
 		read_offset += sz;
@@ -165,17 +170,24 @@ public:
 protected:
 	template <class T>
 	bool getType(T &ref) {
-		if (read_offset + sizeof(ref) > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sizeof(ref) > payload_size) {
+			read_offset = payload_size;
 			return false;
 		}
-		ref = *(T*)(data.data() + read_offset);
+		memcpy(&ref, payload + read_offset, sizeof(ref));
 
 		read_offset += sizeof(ref);
 		return true;
 	}
 
 	void load();
+	// Reads the payload straight from a handle that holds the whole file
+	void loadInPlace();
+	void loadBuffered();
+
+	// The node bytes, either inside the handle buffer or, when they had to be unescaped, in data
+	const uint8_t* payload;
+	size_t payload_size;
 	std::string data;
 	size_t read_offset;
 	NodeFileReadHandle* file;
@@ -184,6 +196,7 @@ protected:
 
 	friend class DiskNodeFileReadHandle;
 	friend class MemoryNodeFileReadHandle;
+	friend class MappedNodeFileReadHandle;
 };
 
 class NodeFileReadHandle : public FileHandle {
@@ -203,6 +216,8 @@ protected:
 	virtual bool renewCache() = 0;
 
 	bool last_was_start;
+	// The cache holds the whole file, so nodes without escaped bytes can point into it
+	bool in_memory;
 	uint8_t* cache;
 	size_t cache_size;
 	size_t cache_length;
@@ -266,6 +281,77 @@ protected:
 	uint8_t* index;
 };
 
+// Read only mapping of a whole file
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() {
+		close();
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// Fails for missing and empty files. sequential hints that the file is read front to back.
+	bool open(const std::string &name, bool sequential = false);
+	void close();
+
+	bool isOpen() const noexcept {
+		return data != nullptr;
+	}
+	const uint8_t* getData() const noexcept {
+		return data;
+	}
+	size_t getSize() const noexcept {
+		return size;
+	}
+
+private:
+	uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef __WINDOWS__
+	void* mapping_handle = nullptr;
+#endif
+};
+
+// Maps the whole file into memory instead of reading it through a cache, node payloads
+// are then used in place unless they contain escaped bytes
+class MappedNodeFileReadHandle : public NodeFileReadHandle {
+public:
+	MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers);
+	virtual ~MappedNodeFileReadHandle();
+
+	virtual void close();
+	virtual BinaryNode* getRootNode();
+
+	virtual bool isOpen() {
+		return mapping.isOpen();
+	}
+	virtual bool isOk() {
+		return isOpen() && error_code == FILE_NO_ERROR;
+	}
+
+	virtual size_t size() {
+		return mapping.getSize();
+	}
+	virtual size_t tell() {
+		return local_read_index + 4;
+	}
+
+	// The node stream following the identifier, valid until the handle is closed
+	const uint8_t* getData() const noexcept {
+		return cache;
+	}
+	size_t getDataSize() const noexcept {
+		return cache_length;
+	}
+
+protected:
+	virtual bool renewCache();
+
+	MappedFile mapping;
+};
+
 class FileWriteHandle : public FileHandle {
 public:
 	explicit FileWriteHandle(const std::string &name);
@@ -324,6 +410,8 @@ public:
 	bool addRAW(const char* c) {
 		return addRAW(reinterpret_cast<const uint8_t*>(c), strlen(c));
 	}
+	// Copies complete nodes, already escaped and framed by NODE_START/NODE_END, as is
+	bool addEncodedNode(const uint8_t* ptr, size_t sz);
 
 protected:
 	virtual void renewCache() = 0;
@@ -358,13 +446,22 @@ protected:
 
 class DiskNodeFileWriteHandle : public NodeFileWriteHandle {
 public:
+	// Sees every block of the node stream as it is written to the file, in order
+	using WriteObserver = std::function<void(const uint8_t* data, size_t length)>;
+
 	DiskNodeFileWriteHandle(const std::string &name, const std::string &identifier);
 	virtual ~DiskNodeFileWriteHandle();
 
 	virtual void close();
 
+	void setWriteObserver(WriteObserver new_observer) {
+		observer = std::move(new_observer);
+	}
+
 protected:
 	virtual void renewCache();
+
+	WriteObserver observer;
 };
 
 class MemoryNodeFileWriteHandle : public NodeFileWriteHandle {
@@ -382,4 +479,31 @@ protected:
 	virtual void renewCache();
 };
 
+// Hands every block of the node stream to a sink as it is written instead of keeping it. Without a
+// sink the blocks are only counted, which tells the size of a stream before it is written.
+class StreamNodeFileWriteHandle : public NodeFileWriteHandle {
+public:
+	// Returns false when the block could not be written
+	using Sink = std::function<bool(const uint8_t* data, size_t length)>;
+
+	explicit StreamNodeFileWriteHandle(Sink sink = nullptr);
+	virtual ~StreamNodeFileWriteHandle();
+
+	// Passes on what is still buffered
+	virtual void close();
+	virtual bool isOk() {
+		return error_code == FILE_NO_ERROR;
+	}
+
+	uint64_t getSize() const noexcept {
+		return size;
+	}
+
+protected:
+	virtual void renewCache();
+
+	Sink sink;
+	uint64_t size = 0;
+};
+
 #endif
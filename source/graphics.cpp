@@ -230,6 +230,7 @@ void GraphicManager::clear() {
 	item_count = 0;
 	creature_count = 0;
 	loaded_textures = 0;
+	atlas.clear();
 	lastclean = time(nullptr);
 }
 
@@ -797,7 +798,8 @@ bool GraphicManager::loadSpriteData(const FileName &datafile, wxString &error, w
 	return true;
 }
 
-bool GraphicManager::loadSpriteDump(uint8_t*&target, uint16_t &size, int sprite_id) {
+bool GraphicManager::loadSpriteDump(SpritePtr &sprite, uint8_t*&target, uint16_t &size, int sprite_id) {
+	sprite.reset();
 	if (g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) {
 		return false;
 	}
@@ -944,21 +946,22 @@ bool GraphicManager::loadOutfitSpriteMetadata(canary::protobuf::appearances::App
 	return true;
 }
 
-bool GraphicManager::loadSpriteDump(uint8_t*&target, uint16_t &size, int sprite_id) {
+bool GraphicManager::loadSpriteDump(SpritePtr &sprite, uint8_t*&target, uint16_t &size, int sprite_id) {
 	// Empty GameSprite
 	if (sprite_id == 0) {
+		sprite.reset();
 		size = 0;
 		target = nullptr;
 		return true;
 	}
 
-	const auto &spritePtr = g_spriteAppearances.getSprite(sprite_id);
-	if (!spritePtr) {
+	sprite = g_spriteAppearances.getSprite(sprite_id);
+	if (!sprite) {
 		return false;
 	}
 
-	size = spritePtr->pixels.size();
-	target = spritePtr->pixels.data();
+	size = sprite->pixels.size();
+	target = sprite->pixels.data();
 	return true;
 }
 
@@ -1039,7 +1042,7 @@ uint16_t GameSprite::getDrawHeight() const {
 
 wxPoint GameSprite::getDrawOffset() {
 	if (!isDrawOffsetLoaded && !spriteList.empty()) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID());
+		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID(), false);
 		if (!sheet) {
 			return wxPoint(0, 0);
 		}
@@ -1176,7 +1179,7 @@ void GameSprite::DrawTo(wxDC* dcWindow, SpriteSize spriteSize, int start_x, int
 			return;
 		}
 
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID());
+		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID(), false);
 		if (!sheet) {
 			return;
 		}
@@ -1184,6 +1187,12 @@ void GameSprite::DrawTo(wxDC* dcWindow, SpriteSize spriteSize, int start_x, int
 		sizeWidth = sheet->getSpriteSize().width;
 		sizeHeight = sheet->getSpriteSize().height;
 	}
+
+	// Left blank until the sheet is decoded, every window is repainted then
+	if (!m_wxMemoryDc[spriteSize] && !spriteList.empty() && !g_spriteAppearances.requestSheet(spriteList[0]->id)) {
+		return;
+	}
+
 	wxMemoryDC* sdc = getDC(spriteSize);
 	if (sdc) {
 		dcWindow->Blit(start_x, start_y, sizeWidth, sizeHeight, sdc, 0, 0, wxCOPY, true);
@@ -1220,12 +1229,17 @@ GameSprite::Image::~Image() {
 void GameSprite::Image::createGLTexture(GLuint textureId) {
 	ASSERT(!isGLLoaded);
 
+	// Tried again on a later frame, once the sheet is decoded
+	if (!g_spriteAppearances.requestSheet(textureId)) {
+		return;
+	}
+
 	uint8_t* rgba = getRGBAData();
 	if (!rgba) {
 		return;
 	}
 
-	const auto &sheet = g_spriteAppearances.getSheetBySpriteId(textureId);
+	const auto &sheet = g_spriteAppearances.getSheetBySpriteId(textureId, false);
 	if (!sheet) {
 		return;
 	}
@@ -1233,22 +1247,23 @@ void GameSprite::Image::createGLTexture(GLuint textureId) {
 	auto spriteWidth = sheet->getSpriteSize().width;
 	auto spriteHeight = sheet->getSpriteSize().height;
 	auto invertedBuffer = invertGLColors(spriteHeight, spriteWidth, rgba);
+	const bool uploaded = g_gui.gfx.atlas.insert(textureId, spriteWidth, spriteHeight, invertedBuffer) != nullptr;
+	delete[] invertedBuffer;
+	if (!uploaded) {
+		return;
+	}
 
 	isGLLoaded = true;
 	g_gui.gfx.loaded_textures += 1;
-
-	glBindTexture(GL_TEXTURE_2D, textureId);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Nearest Filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Nearest Filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); // GL_CLAMP_TO_EDGE
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F); // GL_CLAMP_TO_EDGE
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spriteWidth, spriteHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, invertedBuffer);
 }
 
 void GameSprite::Image::unloadGLTexture(GLuint textureId) {
+	if (!isGLLoaded) {
+		return;
+	}
 	isGLLoaded = false;
 	g_gui.gfx.loaded_textures -= 1;
-	glDeleteTextures(1, &textureId);
+	g_gui.gfx.atlas.erase(textureId);
 }
 
 void GameSprite::Image::visit() {
@@ -1269,7 +1284,9 @@ GameSprite::NormalImage::NormalImage() :
 }
 
 GameSprite::NormalImage::~NormalImage() {
+	unloadGLTexture();
 	m_cachedData = nullptr;
+	m_sprite.reset();
 }
 
 void GameSprite::NormalImage::clean(int time) {
@@ -1277,12 +1294,13 @@ void GameSprite::NormalImage::clean(int time) {
 	// We keep dumps around for 5 seconds.
 	if (time - lastaccess > 5) {
 		m_cachedData = nullptr;
+		m_sprite.reset();
 	}
 }
 
 uint8_t* GameSprite::NormalImage::getRGBAData() {
 	if (!m_cachedData) {
-		if (!g_gui.gfx.loadSpriteDump(m_cachedData, size, id)) {
+		if (!g_gui.gfx.loadSpriteDump(m_sprite, m_cachedData, size, id)) {
 			spdlog::error("[GameSprite::NormalImage::getRGBAData] - Failed when parsing sprite id {}", id);
 			return nullptr;
 		}
@@ -1349,17 +1367,15 @@ void GameSprite::EditorImage::createGLTexture(GLuint textureId) {
 		it.OffsetY(data, 1);
 	}
 
-	isGLLoaded = true;
 	id = g_gui.gfx.getFreeTextureID();
-	g_gui.gfx.loaded_textures += 1;
-
-	glBindTexture(GL_TEXTURE_2D, id);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Nearest Filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Nearest Filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); // GL_CLAMP_TO_EDGE
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F); // GL_CLAMP_TO_EDGE
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rme::SpritePixels, rme::SpritePixels, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
+	const bool uploaded = g_gui.gfx.atlas.insert(id, rme::SpritePixels, rme::SpritePixels, imageData) != nullptr;
 	delete[] imageData;
+	if (!uploaded) {
+		return;
+	}
+
+	isGLLoaded = true;
+	g_gui.gfx.loaded_textures += 1;
 }
 
 void GameSprite::EditorImage::unloadGLTexture(GLuint textureId) {
@@ -1374,11 +1390,11 @@ GameSprite::OutfitImage::OutfitImage(GameSprite* initParent, int initSpriteIndex
 	m_outfit(initOutfit) { }
 
 GameSprite::OutfitImage::~OutfitImage() {
-	m_cachedOutfitData = nullptr;
+	unloadGLTexture(0);
 }
 
 void GameSprite::OutfitImage::unloadGLTexture(GLuint) {
-	Image::unloadGLTexture(m_spriteId);
+	Image::unloadGLTexture(m_textureId);
 }
 
 void GameSprite::OutfitImage::colorizePixel(uint8_t color, uint8_t &red, uint8_t &green, uint8_t &blue) {
@@ -1392,8 +1408,8 @@ void GameSprite::OutfitImage::colorizePixel(uint8_t color, uint8_t &red, uint8_t
 }
 
 uint8_t* GameSprite::OutfitImage::getRGBAData() {
-	if (m_cachedOutfitData) {
-		return m_cachedOutfitData;
+	if (!m_cachedOutfitData.empty()) {
+		return m_cachedOutfitData.data();
 	}
 
 	const auto &sprite = g_spriteAppearances.getSprite(m_parent->spriteList[m_spriteIndex]->getHardwareID());
@@ -1408,8 +1424,9 @@ uint8_t* GameSprite::OutfitImage::getRGBAData() {
 		return nullptr;
 	}
 
-	uint8_t* rgbadata = sprite->pixels.data();
-	uint8_t* template_rgbadata = spriteTemplate->pixels.data();
+	m_cachedOutfitData = sprite->pixels;
+	uint8_t* rgbadata = m_cachedOutfitData.data();
+	const uint8_t* template_rgbadata = spriteTemplate->pixels.data();
 
 	if (m_outfit.lookHead > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
 		m_outfit.lookHead = 0;
@@ -1451,17 +1468,16 @@ uint8_t* GameSprite::OutfitImage::getRGBAData() {
 
 	spdlog::debug("outfit name: {}, pattern_x: {}, pattern_y: {}, pattern_z: {}, sprite_phase_size: {}, layers: {}, draw height: {}, drawx: {}, drawy: {}", m_outfit.name, m_parent->pattern_x, m_parent->pattern_y, m_parent->pattern_z, m_parent->sprite_phase_size, m_parent->layers, m_parent->draw_height, m_parent->getDrawOffset().x, m_parent->getDrawOffset().y);
 
-	m_cachedOutfitData = rgbadata;
-	return m_cachedOutfitData;
+	return rgbadata;
 }
 
 GLuint GameSprite::OutfitImage::getHardwareID() {
-	if (!m_isGLLoaded) {
+	if (!isGLLoaded) {
 		if (m_textureId == 0) {
 			m_textureId = g_gui.gfx.getFreeTextureID();
 		}
 		createGLTexture(m_spriteId, m_textureId);
-		if (!m_isGLLoaded) {
+		if (!isGLLoaded) {
 			return 0;
 		}
 	}
@@ -1470,14 +1486,22 @@ GLuint GameSprite::OutfitImage::getHardwareID() {
 }
 
 void GameSprite::OutfitImage::createGLTexture(GLuint spriteId, GLuint textureId) {
-	ASSERT(!m_isGLLoaded);
+	ASSERT(!isGLLoaded);
+
+	// The outfit and its colour template, tried again on a later frame once both are decoded
+	const size_t templateIndex = std::min<size_t>(m_spriteIndex + 1, m_parent->spriteList.size() - 1);
+	const bool outfitReady = g_spriteAppearances.requestSheet(m_parent->spriteList[m_spriteIndex]->id);
+	const bool templateReady = g_spriteAppearances.requestSheet(m_parent->spriteList[templateIndex]->id);
+	if (!outfitReady || !templateReady) {
+		return;
+	}
 
 	uint8_t* rgba = getRGBAData();
 	if (!rgba) {
 		return;
 	}
 
-	const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteId);
+	const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteId, false);
 	if (!sheet) {
 		return;
 	}
@@ -1485,16 +1509,14 @@ void GameSprite::OutfitImage::createGLTexture(GLuint spriteId, GLuint textureId)
 	auto spriteWidth = sheet->getSpriteSize().width;
 	auto spriteHeight = sheet->getSpriteSize().height;
 	auto invertedBuffer = m_parent->invertGLColors(spriteHeight, spriteWidth, rgba);
+	const bool uploaded = g_gui.gfx.atlas.insert(textureId > 0 ? textureId : spriteId, spriteWidth, spriteHeight, invertedBuffer) != nullptr;
+	delete[] invertedBuffer;
+	if (!uploaded) {
+		return;
+	}
 
-	m_isGLLoaded = true;
+	isGLLoaded = true;
 	g_gui.gfx.loaded_textures += 1;
-
-	glBindTexture(GL_TEXTURE_2D, textureId > 0 ? textureId : spriteId);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Nearest Filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Nearest Filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); // GL_CLAMP_TO_EDGE
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F); // GL_CLAMP_TO_EDGE
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spriteWidth, spriteHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, invertedBuffer);
 }
 
 GameSprite* GameSprite::createFromBitmap(const wxArtID &bitmapId) {
@@ -21,6 +21,7 @@
 #include "outfit.h"
 #include "common.h"
 #include "enums.h"
+#include "texture_atlas.h"
 
 #include <wx/artprov.h>
 
@@ -54,6 +55,7 @@ class MapCanvas;
 class GraphicManager;
 class FileReadHandle;
 class Animator;
+struct Sprites;
 
 struct SpriteLight {
 	uint8_t intensity = 0;
@@ -145,12 +147,14 @@ protected:
 		NormalImage();
 		virtual ~NormalImage();
 
-		// We use the sprite id as GL texture id
+		// We use the sprite id as the id of the texture in the atlas
 		uint32_t id;
 
 		// This contains the pixel data
 		uint16_t size;
 		uint8_t* m_cachedData;
+		// Owns m_cachedData, which pins it in the sprite cache
+		std::shared_ptr<Sprites> m_sprite;
 
 		virtual void clean(int time);
 
@@ -189,8 +193,8 @@ protected:
 		GLuint m_spriteId = 0;
 		GameSprite* m_parent = 0;
 		int m_spriteIndex = 0;
-		bool m_isGLLoaded = false;
-		uint8_t* m_cachedOutfitData = nullptr;
+		// Colored copy of the sprite, the cached sprite is left as it is
+		std::vector<uint8_t> m_cachedOutfitData;
 
 		Outfit m_outfit;
 
@@ -324,6 +328,19 @@ public:
 	// Get an unused texture id (this is acquired by simply increasing a value starting from 0x10000000)
 	GLuint getFreeTextureID();
 
+	int getLoadedTextureCount() const noexcept {
+		return loaded_textures;
+	}
+	// Every atlas page counts in full, however many sprites it holds
+	int64_t getLoadedTextureBytes() const noexcept {
+		return atlas.getReservedBytes();
+	}
+
+	// Holds the textures of every sprite, by the ids getHardwareID returns
+	TextureAtlas &getTextureAtlas() noexcept {
+		return atlas;
+	}
+
 	// This is part of the binary
 	bool loadEditorSprites();
 	// Metadata should be loaded first
@@ -351,7 +368,7 @@ private:
 	bool unloaded;
 	// This is used if memcaching is NOT on
 	std::string spritefile;
-	bool loadSpriteDump(uint8_t*&target, uint16_t &size, int sprite_id);
+	bool loadSpriteDump(std::shared_ptr<Sprites> &sprite, uint8_t*&target, uint16_t &size, int sprite_id);
 
 	typedef std::map<int, Sprite*> SpriteMap;
 	SpriteMap sprite_space;
@@ -370,6 +387,7 @@ private:
 
 	int loaded_textures;
 	int lastclean;
+	TextureAtlas atlas;
 
 	wxStopWatch* animation_timer;
 
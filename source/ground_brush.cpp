@@ -630,14 +630,6 @@ const GroundBrush::BorderBlock* GroundBrush::getBrushTo(GroundBrush* first, Grou
 }
 
 void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
-	static const auto extractGroundBrushFromTile = [](BaseMap* map, uint32_t x, uint32_t y, uint32_t z) -> GroundBrush* {
-		Tile* tile = map->getTile(x, y, z);
-		if (tile) {
-			return tile->getGroundBrush();
-		}
-		return nullptr;
-	};
-
 	ASSERT(tile);
 
 	GroundBrush* borderBrush;
@@ -647,52 +639,12 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 		borderBrush = nullptr;
 	}
 
-	const Position &position = tile->getPosition();
-
-	uint32_t x = position.x;
-	uint32_t y = position.y;
-	uint32_t z = position.z;
-
 	// Pair of visited / what border type
+	const TileNeighborhood neighborhood(map, tile->getPosition());
 	std::pair<bool, GroundBrush*> neighbours[8];
-	if (x == 0) {
-		if (y == 0) {
-			neighbours[0] = { false, nullptr };
-			neighbours[1] = { false, nullptr };
-			neighbours[2] = { false, nullptr };
-			neighbours[3] = { false, nullptr };
-			neighbours[4] = { false, extractGroundBrushFromTile(map, x + 1, y, z) };
-			neighbours[5] = { false, nullptr };
-			neighbours[6] = { false, extractGroundBrushFromTile(map, x, y + 1, z) };
-			neighbours[7] = { false, extractGroundBrushFromTile(map, x + 1, y + 1, z) };
-		} else {
-			neighbours[0] = { false, nullptr };
-			neighbours[1] = { false, extractGroundBrushFromTile(map, x, y - 1, z) };
-			neighbours[2] = { false, extractGroundBrushFromTile(map, x + 1, y - 1, z) };
-			neighbours[3] = { false, nullptr };
-			neighbours[4] = { false, extractGroundBrushFromTile(map, x + 1, y, z) };
-			neighbours[5] = { false, nullptr };
-			neighbours[6] = { false, extractGroundBrushFromTile(map, x, y + 1, z) };
-			neighbours[7] = { false, extractGroundBrushFromTile(map, x + 1, y + 1, z) };
-		}
-	} else if (y == 0) {
-		neighbours[0] = { false, nullptr };
-		neighbours[1] = { false, nullptr };
-		neighbours[2] = { false, nullptr };
-		neighbours[3] = { false, extractGroundBrushFromTile(map, x - 1, y, z) };
-		neighbours[4] = { false, extractGroundBrushFromTile(map, x + 1, y, z) };
-		neighbours[5] = { false, extractGroundBrushFromTile(map, x - 1, y + 1, z) };
-		neighbours[6] = { false, extractGroundBrushFromTile(map, x, y + 1, z) };
-		neighbours[7] = { false, extractGroundBrushFromTile(map, x + 1, y + 1, z) };
-	} else {
-		neighbours[0] = { false, extractGroundBrushFromTile(map, x - 1, y - 1, z) };
-		neighbours[1] = { false, extractGroundBrushFromTile(map, x, y - 1, z) };
-		neighbours[2] = { false, extractGroundBrushFromTile(map, x + 1, y - 1, z) };
-		neighbours[3] = { false, extractGroundBrushFromTile(map, x - 1, y, z) };
-		neighbours[4] = { false, extractGroundBrushFromTile(map, x + 1, y, z) };
-		neighbours[5] = { false, extractGroundBrushFromTile(map, x - 1, y + 1, z) };
-		neighbours[6] = { false, extractGroundBrushFromTile(map, x, y + 1, z) };
-		neighbours[7] = { false, extractGroundBrushFromTile(map, x + 1, y + 1, z) };
+	for (int i = 0; i < 8; ++i) {
+		Tile* neighbour = neighborhood.getNeighbor(i);
+		neighbours[i] = { false, neighbour ? neighbour->getGroundBrush() : nullptr };
 	}
 
 	static std::vector<const BorderBlock*> specificList;
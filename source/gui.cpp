@@ -71,6 +71,7 @@ GUI g_gui;
 // GUI class implementation
 GUI::GUI() :
 	aui_manager(nullptr),
+	tabbook(nullptr),
 	root(nullptr),
 	minimap(nullptr),
 	gem(nullptr),
@@ -107,7 +108,9 @@ GUI::GUI() :
 	use_custom_thickness(false),
 	custom_thickness_mod(0.0),
 	progressBar(nullptr),
-	disabled_counter(0) {
+	disabled_counter(0),
+	headless(false),
+	headless_assume_yes(false) {
 	doodad_buffer_map = newd BaseMap();
 }
 
@@ -244,13 +247,14 @@ bool GUI::loadMapWindow(wxString &error, wxArrayString &warnings, bool force /*
 		return true;
 	}
 
-	// There is another version loaded right now, save window layout
-	g_gui.SavePerspective();
-
 	// Disable all rendering so the data is not accessed while reloading
 	UnnamedRenderingLock();
-	DestroyPalettes();
-	DestroyMinimap();
+	if (!headless) {
+		// There is another version loaded right now, save window layout
+		g_gui.SavePerspective();
+		DestroyPalettes();
+		DestroyMinimap();
+	}
 
 	g_spriteAppearances.terminate();
 
@@ -258,7 +262,7 @@ bool GUI::loadMapWindow(wxString &error, wxArrayString &warnings, bool force /*
 	unloadMapWindow();
 
 	bool ret = LoadDataFiles(error, warnings);
-	if (ret) {
+	if (ret && !headless) {
 		g_gui.LoadPerspective();
 	}
 
@@ -406,7 +410,11 @@ void GUI::SaveCurrentMap(FileName filename, bool showdialog) {
 	if (mapTab) {
 		Editor* editor = mapTab->GetEditor();
 		if (editor) {
-			editor->saveMap(filename, showdialog);
+			if (g_settings.getBoolean(Config::BACKGROUND_SAVE)) {
+				editor->saveMapInBackground(filename);
+			} else {
+				editor->saveMap(filename, showdialog);
+			}
 
 			const std::string &filename = editor->getMap().getFilename();
 			const Position &position = mapTab->GetScreenCenterPosition();
@@ -660,6 +668,10 @@ bool GUI::CloseLiveEditors(LiveSocket* sock) {
 }
 
 bool GUI::CloseAllEditors() {
+	if (headless) {
+		return true;
+	}
+
 	for (int i = 0; i < tabbook->GetTabCount(); ++i) {
 		auto* mapTab = dynamic_cast<MapTab*>(tabbook->GetTab(i));
 		if (mapTab) {
@@ -1083,6 +1095,11 @@ void GUI::CreateLoadBar(wxString message, bool canCancel /* = false */) {
 	progressTo = 100;
 	currentProgress = -1;
 
+	if (headless) {
+		spdlog::info("{}", progressText.ToStdString());
+		return;
+	}
+
 	progressBar = newd wxGenericProgressDialog("Loading", progressText + " (0%)", 100, root, wxPD_APP_MODAL | wxPD_SMOOTH | (canCancel ? wxPD_CAN_ABORT : 0));
 	progressBar->SetSize(280, -1);
 	progressBar->Show(true);
@@ -1111,6 +1128,9 @@ bool GUI::SetLoadDone(int32_t done, const wxString &newMessage) {
 
 	if (!newMessage.empty()) {
 		progressText = newMessage;
+		if (headless) {
+			spdlog::info("{}", progressText.ToStdString());
+		}
 	}
 
 	int32_t newProgress = progressFrom + static_cast<int32_t>((done / 100.f) * (progressTo - progressFrom));
@@ -1126,6 +1146,10 @@ bool GUI::SetLoadDone(int32_t done, const wxString &newMessage) {
 		currentProgress = newProgress;
 	}
 
+	if (headless) {
+		return false;
+	}
+
 	for (int32_t index = 0; index < tabbook->GetTabCount(); ++index) {
 		auto* mapTab = dynamic_cast<MapTab*>(tabbook->GetTab(index));
 		if (mapTab && mapTab->GetEditor()) {
@@ -1328,6 +1352,10 @@ void GUI::ChangeFloor(int new_floor) {
 }
 
 void GUI::SetStatusText(wxString text) {
+	if (headless) {
+		spdlog::info("{}", text.ToStdString());
+		return;
+	}
 	g_gui.root->SetStatusText(text, 0);
 }
 
@@ -1847,11 +1875,28 @@ void GUI::FillDoodadPreviewBuffer() {
 	}
 }
 
+void GUI::SetHeadless(bool assume_yes) {
+	headless = true;
+	headless_assume_yes = assume_yes;
+}
+
 long GUI::PopupDialog(wxWindow* parent, wxString title, wxString text, long style, wxString confisavename, uint32_t configsavevalue) {
 	if (text.empty()) {
 		return wxID_ANY;
 	}
 
+	if (headless) {
+		spdlog::warn("{}: {}", title.ToStdString(), text.ToStdString());
+		if ((style & wxYES) && headless_assume_yes) {
+			return wxID_YES;
+		} else if (style & wxCANCEL) {
+			return wxID_CANCEL;
+		} else if (style & wxNO) {
+			return wxID_NO;
+		}
+		return wxID_OK;
+	}
+
 	wxMessageDialog dlg(parent, text, title, style);
 	return dlg.ShowModal();
 }
@@ -1865,6 +1910,13 @@ void GUI::ListDialog(wxWindow* parent, wxString title, const wxArrayString &para
 		return;
 	}
 
+	if (headless) {
+		for (const wxString &item : param_items) {
+			spdlog::warn("{}: {}", title.ToStdString(), item.ToStdString());
+		}
+		return;
+	}
+
 	wxArrayString list_items(param_items);
 
 	// Create the window
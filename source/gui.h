@@ -230,6 +230,13 @@ public:
 	}
 
 	void ShowTextBox(wxWindow* parent, wxString title, wxString contents);
+
+	// Without a display (command line batch mode) no window is ever created, dialogs and lists are
+	// logged instead and questions are answered with yes when assume_yes is set, no or cancel otherwise
+	void SetHeadless(bool assume_yes);
+	bool IsHeadless() const noexcept {
+		return headless;
+	}
 	void ShowTextBox(const wxString &title, const wxString &contents) {
 		ShowTextBox(nullptr, title, contents);
 	}
@@ -501,6 +508,9 @@ protected:
 	wxWindowDisabler* winDisabler;
 	int disabled_counter;
 
+	bool headless;
+	bool headless_assume_yes;
+
 	friend class RenderingLock;
 	friend class IOMinimap;
 	friend MapTab::MapTab(MapTabbook*, Editor*);
@@ -178,6 +178,9 @@ enum EditorActionID {
 	PANE_PROPERTIES,
 	PANE_ADVANCED_GRAPHICS,
 
+	MEMORY_WINDOW_REFRESH,
+	MEMORY_WINDOW_EXPORT,
+
 	PALETTE_DELAYED_REFRESH_TIMER,
 	PALETTE_LAYOUT_FIX_TIMER,
 
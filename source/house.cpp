@@ -51,12 +51,13 @@ void Houses::addHouse(House* new_house) {
 }
 
 void Houses::removeHouse(House* house_to_remove) {
+	// Cleaned while still registered, the tiles of an evicted cell are read back into the house
+	house_to_remove->clean();
+
 	HouseMap::iterator it = houses.find(house_to_remove->id);
 	if (it != houses.end()) {
 		houses.erase(it);
 	}
-
-	house_to_remove->clean();
 	delete house_to_remove;
 }
 
@@ -94,6 +95,7 @@ void House::clean() {
 		Tile* tile = map->getTile(*pos_iter);
 		if (tile) {
 			tile->setHouse(nullptr);
+			map->markTileChanged(tile->getPosition());
 		}
 	}
 
@@ -119,6 +121,7 @@ void House::addTile(Tile* tile) {
 	ASSERT(tile);
 	tile->setHouse(this);
 	tiles.push_back(tile->getPosition());
+	map->markTileChanged(tile->getPosition());
 }
 
 void House::removeTile(Tile* tile) {
@@ -127,6 +130,7 @@ void House::removeTile(Tile* tile) {
 		if (*tile_iter == tile->getPosition()) {
 			tiles.erase(tile_iter);
 			tile->setHouse(nullptr);
+			map->markTileChanged(tile->getPosition());
 			return;
 		}
 	}
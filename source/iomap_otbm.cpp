@@ -18,6 +18,8 @@
 #include "main.h"
 
 #include "iomap_otbm.h"
+#include "block_gzip.h"
+#include "otbm_index.h"
 
 #include "settings.h"
 #include "gui.h" // Loadbar
@@ -27,6 +29,8 @@
 #include "npcs.h"
 #include "npc.h"
 #include "map.h"
+#include "map_pager.h"
+#include "thread_pool.h"
 #include "tile.h"
 #include "item.h"
 #include "complexitem.h"
@@ -466,24 +470,60 @@ bool IOMapOTBM::getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver) {
 	return true;
 }
 
+#if OTGZ_SUPPORT > 0
+namespace {
+	la_ssize_t writeOTGZData(struct archive*, void* client, const void* buffer, size_t length) {
+		BlockGzipWriter* writer = static_cast<BlockGzipWriter*>(client);
+		if (!writer->write(static_cast<const uint8_t*>(buffer), length)) {
+			return -1;
+		}
+		return static_cast<la_ssize_t>(length);
+	}
+
+	la_ssize_t readOTGZData(struct archive*, void* client, const void** buffer) {
+		BlockGzipReader* reader = static_cast<BlockGzipReader*>(client);
+		const uint8_t* data;
+		size_t size;
+		if (!reader->next(data, size)) {
+			return reader->isOk() ? 0 : -1;
+		}
+		*buffer = data;
+		return static_cast<la_ssize_t>(size);
+	}
+}
+#endif
+
 bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 #if OTGZ_SUPPORT > 0
 	if (filename.GetExt() == "otgz") {
+		// Archives saved by the editor are inflated a block at a time on every thread, libarchive
+		// inflates any other gzip file as a single stream
+		BlockGzipReader reader(nstr(filename.GetFullPath()));
+
 		// Open the archive
 		std::shared_ptr<struct archive> a(archive_read_new(), archive_read_free);
 		archive_read_support_filter_all(a.get());
 		archive_read_support_format_all(a.get());
-		if (archive_read_open_filename(a.get(), nstr(filename.GetFullPath()).c_str(), 10240) != ARCHIVE_OK) {
+		const int opened = reader.isBlockFile()
+			? archive_read_open(a.get(), &reader, nullptr, readOTGZData, nullptr)
+			: archive_read_open_filename(a.get(), nstr(filename.GetFullPath()).c_str(), 10240);
+		if (opened != ARCHIVE_OK) {
 			return false;
 		}
 
-		// Memory buffers for the houses & monsters & npcs
-		std::shared_ptr<uint8_t> house_buffer;
-		std::shared_ptr<uint8_t> spawn_monster_buffer;
-		std::shared_ptr<uint8_t> spawn_npc_buffer;
-		size_t house_buffer_size = 0;
-		size_t spawn_monster_buffer_size = 0;
-		size_t spawn_npc_buffer_size = 0;
+		// The xml files come first in archives saved by the editor, they are parsed on other
+		// threads while the map is read
+		const auto readXmlEntry = [&](struct archive_entry* entry, const char* failure) -> PendingDocument {
+			std::vector<uint8_t> buffer(archive_entry_size(entry));
+			if (buffer.empty()) {
+				return {};
+			}
+			if (archive_read_data(a.get(), buffer.data(), buffer.size()) < static_cast<la_ssize_t>(buffer.size())) {
+				warning(failure);
+				return {};
+			}
+			return parseXmlBuffer(std::move(buffer));
+		};
 
 		// See if the otbm file has been loaded
 		bool otbm_loaded = false;
@@ -495,76 +535,31 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 			std::string entryName = archive_entry_pathname(entry);
 
 			if (entryName == "world/map.otbm") {
-				// Read the entire OTBM file into a memory region
-				size_t otbm_size = archive_entry_size(entry);
-				std::shared_ptr<uint8_t> otbm_buffer(new uint8_t[otbm_size], [](uint8_t* p) { delete[] p; });
-
-				// Read from the archive
-				size_t read_bytes = archive_read_data(a.get(), otbm_buffer.get(), otbm_size);
-
-				// Check so it at least contains the 4-byte file id
-				if (read_bytes < 4) {
-					return false;
-				}
-
-				if (read_bytes < otbm_size) {
-					error("Could not read file.");
-					return false;
-				}
-
-				g_gui.SetLoadDone(0, "Loading OTBM map...");
-
-				// Create a read handle on it
-				std::shared_ptr<NodeFileReadHandle> f(
-					new MemoryNodeFileReadHandle(otbm_buffer.get() + 4, otbm_size - 4)
-				);
-
-				// Read the version info
-				if (!loadMap(map, *f.get())) {
+				// The blocks inflated by the reader are handed on as they are, without copying the
+				// whole file into memory first. The editor never writes sparse entries.
+				la_int64_t expected_offset = 0;
+				const auto next = [&](const uint8_t*&data, size_t &size) {
+					const void* block;
+					la_int64_t offset;
+					if (archive_read_data_block(a.get(), &block, &size, &offset) != ARCHIVE_OK || offset != expected_offset) {
+						return false;
+					}
+					expected_offset += static_cast<la_int64_t>(size);
+					data = static_cast<const uint8_t*>(block);
+					return true;
+				};
+				if (!loadStreamedMap(map, next, archive_entry_size(entry))) {
 					error("Could not load OTBM file inside archive");
 					return false;
 				}
 
 				otbm_loaded = true;
 			} else if (entryName == "world/houses.xml") {
-				house_buffer_size = archive_entry_size(entry);
-				house_buffer.reset(new uint8_t[house_buffer_size]);
-
-				// Read from the archive
-				size_t read_bytes = archive_read_data(a.get(), house_buffer.get(), house_buffer_size);
-
-				// Check so it at least contains the 4-byte file id
-				if (read_bytes < house_buffer_size) {
-					house_buffer.reset();
-					house_buffer_size = 0;
-					warning("Failed to decompress houses.");
-				}
+				pending_houses = readXmlEntry(entry, "Failed to decompress houses.");
 			} else if (entryName == "world/monsters.xml") {
-				spawn_monster_buffer_size = archive_entry_size(entry);
-				spawn_monster_buffer.reset(new uint8_t[spawn_monster_buffer_size]);
-
-				// Read from the archive
-				size_t read_bytes = archive_read_data(a.get(), spawn_monster_buffer.get(), spawn_monster_buffer_size);
-
-				// Check so it at least contains the 4-byte file id
-				if (read_bytes < spawn_monster_buffer_size) {
-					spawn_monster_buffer.reset();
-					spawn_monster_buffer_size = 0;
-					warning("Failed to decompress monsters spawns.");
-				}
+				pending_spawns_monster = readXmlEntry(entry, "Failed to decompress monsters spawns.");
 			} else if (entryName == "world/npcs.xml") {
-				spawn_npc_buffer_size = archive_entry_size(entry);
-				spawn_npc_buffer.reset(new uint8_t[spawn_npc_buffer_size]);
-
-				// Read from the archive
-				size_t read_bytes = archive_read_data(a.get(), spawn_npc_buffer.get(), spawn_npc_buffer_size);
-
-				// Check so it at least contains the 4-byte file id
-				if (read_bytes < spawn_npc_buffer_size) {
-					spawn_npc_buffer.reset();
-					spawn_npc_buffer_size = 0;
-					warning("Failed to decompress npcs spawns.");
-				}
+				pending_spawns_npc = readXmlEntry(entry, "Failed to decompress npcs spawns.");
 			}
 		}
 
@@ -573,79 +568,344 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 			return false;
 		}
 
-		// Load the houses from the stored buffer
-		if (house_buffer.get() && house_buffer_size > 0) {
-			pugi::xml_document doc;
-			pugi::xml_parse_result result = doc.load_buffer(house_buffer.get(), house_buffer_size);
-			if (result) {
-				if (!loadHouses(map, doc)) {
-					warning("Failed to load houses.");
-				}
-			} else {
-				warning("Failed to load houses due to XML parse error.");
+		// Load the houses, monsters and npcs parsed from the archive
+		const auto loadDocument = [this, &map](PendingDocument &pending, bool (IOMapOTBM::*load)(Map &, pugi::xml_document &), const char* what) {
+			if (!pending.valid()) {
+				return;
 			}
-		}
-
-		// Load the monster spawns from the stored buffer
-		if (spawn_monster_buffer.get() && spawn_monster_buffer_size > 0) {
-			pugi::xml_document doc;
-			pugi::xml_parse_result result = doc.load_buffer(spawn_monster_buffer.get(), spawn_monster_buffer_size);
-			if (result) {
-				if (!loadSpawnsMonster(map, doc)) {
-					warning("Failed to load monsters spawns.");
+			if (std::unique_ptr<pugi::xml_document> doc = pending.get()) {
+				if (!(this->*load)(map, *doc)) {
+					warning(wxString::Format("Failed to load %s.", what));
 				}
 			} else {
-				warning("Failed to load monsters spawns due to XML parse error.");
+				warning(wxString::Format("Failed to load %s due to XML parse error.", what));
 			}
-		}
-
-		// Load the npcs from the stored buffer
-		if (spawn_npc_buffer.get() && spawn_npc_buffer_size > 0) {
-			pugi::xml_document doc;
-			pugi::xml_parse_result result = doc.load_buffer(spawn_npc_buffer.get(), spawn_npc_buffer_size);
-			if (result) {
-				if (!loadSpawnsNpc(map, doc)) {
-					warning("Failed to load npcs spawns.");
-				}
-			} else {
-				warning("Failed to load npcs spawns due to XML parse error.");
-			}
-		}
+		};
+		loadDocument(pending_houses, &IOMapOTBM::loadHouses, "houses");
+		loadDocument(pending_spawns_monster, &IOMapOTBM::loadSpawnsMonster, "monsters spawns");
+		loadDocument(pending_spawns_npc, &IOMapOTBM::loadSpawnsNpc, "npcs spawns");
 
 		return true;
 	}
 #endif
 
-	DiskNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
-	if (!f.isOk()) {
-		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage())).wc_str());
-		return false;
-	}
-
-	if (!loadMap(map, f)) {
+	side_directory = nstr(filename.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
+	const bool loaded = loadMapFile(map, filename);
+	side_directory.clear();
+	if (!loaded) {
 		return false;
 	}
 
-	// Read auxilliary files
-	if (!loadHouses(map, filename)) {
+	// Read auxilliary files, only adding them to the map had to wait for the tiles
+	const auto takeDocument = [](PendingDocument &pending) -> std::unique_ptr<pugi::xml_document> {
+		return pending.valid() ? pending.get() : nullptr;
+	};
+	if (auto doc = takeDocument(pending_houses); !doc || !loadHouses(map, *doc)) {
 		warning("Failed to load houses.");
 		map.housefile = nstr(filename.GetName()) + "-house.xml";
 	}
-	if (!loadZones(map, filename)) {
+	if (auto doc = takeDocument(pending_zones); !doc || !loadZones(map, *doc)) {
 		warning("Failed to load zones.");
 		map.zonefile = nstr(filename.GetName()) + "-zones.xml";
 	}
-	if (!loadSpawnsMonster(map, filename)) {
+	if (auto doc = takeDocument(pending_spawns_monster); !doc || !loadSpawnsMonster(map, *doc)) {
 		warning("Failed to load monsters spawns.");
 		map.spawnmonsterfile = nstr(filename.GetName()) + "-monster.xml";
 	}
-	if (!loadSpawnsNpc(map, filename)) {
+	if (auto doc = takeDocument(pending_spawns_npc); !doc || !loadSpawnsNpc(map, *doc)) {
 		warning("Failed to load npcs spawns.");
 		map.spawnnpcfile = nstr(filename.GetName()) + "-npc.xml";
 	}
 	return true;
 }
 
+bool IOMapOTBM::loadMapFile(Map &map, const FileName &filename) {
+	const int paged_threshold = g_settings.getInteger(Config::PAGED_MAP_THRESHOLD);
+	if (paged_threshold > 0 && filename.GetSize() >= wxULongLong(paged_threshold) * 1024 * 1024) {
+		return loadPagedMap(map, filename);
+	}
+
+	// Mapping the file avoids copying every node, reading through a cache is the fallback
+	// for when it can not be mapped (e.g. not enough address space)
+	auto mapped = std::make_unique<MappedNodeFileReadHandle>(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+	if (mapped->isOk() && ThreadPool::getInstance().getThreadCount() > 1) {
+		return loadParallelMap(map, *mapped);
+	}
+
+	std::unique_ptr<NodeFileReadHandle> f = std::move(mapped);
+	if (!f->isOk() && f->error_code != FILE_SYNTAX_ERROR) {
+		f = std::make_unique<DiskNodeFileReadHandle>(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+	}
+	if (!f->isOk()) {
+		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f->getErrorMessage())).wc_str());
+		return false;
+	}
+	return loadMap(map, *f);
+}
+
+bool IOMapOTBM::loadMapRegion(Map &map, const FileName &filename, const Position &from, const Position &to) {
+	MappedNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+	if (!f.isOk()) {
+		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage())).wc_str());
+		return false;
+	}
+
+	// An index that is missing or was not written for this version of the file is built again,
+	// the nodes around the tile areas always come from the file
+	OTBMIndex index;
+	std::vector<OTBMAreaScanner::Area> areas;
+	std::vector<uint8_t> skeleton;
+	bool indexed = index.load(nstr(filename.GetFullPath()), f.getDataSize());
+	if (indexed) {
+		areas = index.findAreas(from, to);
+		indexed = OTBMIndex::matches(areas, f.getData(), f.getDataSize()) && index.readSkeleton(f.getData(), f.getDataSize(), skeleton);
+	}
+	if (!indexed) {
+		g_gui.SetLoadDone(0, "Indexing tile areas...");
+		index.clear();
+		index.feed(f.getData(), f.getDataSize());
+		if (!index.finish() || !index.readSkeleton(f.getData(), f.getDataSize(), skeleton)) {
+			error("The tile areas of the map could not be indexed, it is damaged");
+			return false;
+		}
+		areas = index.findAreas(from, to);
+	}
+
+	pending_data = f.getData();
+	pending_areas = std::move(areas);
+
+	MemoryNodeFileReadHandle skeleton_handle(skeleton.data(), skeleton.size());
+	const bool loaded = loadMap(map, skeleton_handle);
+	pending_areas.clear();
+	pending_data = nullptr;
+	return loaded;
+}
+
+bool IOMapOTBM::loadPagedMap(Map &map, const FileName &filename) {
+	g_gui.SetLoadDone(0, "Indexing tile areas...");
+
+	auto pager = std::make_unique<MapPager>(map, nstr(filename.GetFullPath()));
+	std::vector<uint8_t> skeleton;
+	if (!pager->scan(skeleton)) {
+		error("Couldn't index the tile areas of the map, the file is unreadable or damaged.");
+		return false;
+	}
+	map.setPager(std::move(pager));
+
+	// Everything but the tile areas, read like a regular map
+	MemoryNodeFileReadHandle f(skeleton.data(), skeleton.size());
+	if (!loadMap(map, f)) {
+		map.setPager(nullptr);
+		return false;
+	}
+	return true;
+}
+
+bool IOMapOTBM::loadParallelMap(Map &map, MappedNodeFileReadHandle &f) {
+	g_gui.SetLoadDone(0, "Indexing tile areas...");
+
+	std::vector<uint8_t> skeleton;
+	OTBMAreaScanner scanner(skeleton);
+	scanner.feed(f.getData(), f.getDataSize(), 0);
+	if (!scanner.isComplete()) {
+		// Damaged files are read node by node, which recovers whatever it can
+		return loadMap(map, f);
+	}
+
+	pending_data = f.getData();
+	pending_areas = std::move(scanner.getAreas());
+
+	MemoryNodeFileReadHandle skeleton_handle(skeleton.data(), skeleton.size());
+	const bool loaded = loadMap(map, skeleton_handle);
+	pending_areas.clear();
+	pending_data = nullptr;
+	return loaded;
+}
+
+namespace {
+	// The version is the first attribute of the root node, it can be read from the start of the
+	// skeleton before the rest of the stream is there
+	bool readSkeletonVersion(const std::vector<uint8_t> &skeleton, uint32_t &otbm_version) {
+		if (skeleton.empty() || skeleton[0] != NODE_START) {
+			return false;
+		}
+		uint8_t bytes[5];
+		size_t count = 0;
+		bool escaped = false;
+		for (size_t i = 1; i < skeleton.size() && count < 5; ++i) {
+			const uint8_t byte = skeleton[i];
+			if (!escaped && byte == ESCAPE_CHAR) {
+				escaped = true;
+				continue;
+			}
+			if (!escaped && (byte == NODE_START || byte == NODE_END)) {
+				return false;
+			}
+			escaped = false;
+			bytes[count++] = byte;
+		}
+		if (count < 5) {
+			return false;
+		}
+		// After the type byte
+		otbm_version = bytes[1] | (bytes[2] << 8) | (bytes[3] << 16) | (static_cast<uint32_t>(bytes[4]) << 24);
+		return true;
+	}
+}
+
+bool IOMapOTBM::loadStreamedMap(Map &map, const std::function<bool(const uint8_t*&data, size_t &size)> &next, uint64_t size) {
+	g_gui.SetLoadDone(0, "Loading OTBM map...");
+
+	// Bytes held for the areas that wait to be decoded, an area larger than this is still read
+	// whole. The areas are decoded at the latest once loadPendingAreas would link a full batch.
+	constexpr size_t window_bytes = 16 * 1024 * 1024;
+	constexpr size_t batch_areas = 512;
+
+	std::vector<uint8_t> skeleton;
+	OTBMAreaScanner scanner(skeleton);
+	std::vector<OTBMAreaScanner::Area> &areas = scanner.getAreas();
+
+	// The bytes of the stream from window_offset on, offsets do not count the file identifier
+	std::vector<uint8_t> window;
+	uint64_t window_offset = 0;
+	uint64_t offset = 0;
+	size_t identifier_bytes = 0;
+
+	const auto decodeAreas = [&]() {
+		if (!areas.empty()) {
+			uint32_t otbm_version;
+			if (!readSkeletonVersion(skeleton, otbm_version)) {
+				return false;
+			}
+			version.otbm = (MapVersionID)otbm_version;
+
+			pending_data = window.data();
+			pending_areas = std::move(areas);
+			areas.clear();
+			for (OTBMAreaScanner::Area &area : pending_areas) {
+				area.offset -= window_offset;
+			}
+			loadPendingAreas(map, false);
+		}
+		const uint64_t keep = scanner.getOpenAreaOffset(offset);
+		window.erase(window.begin(), window.begin() + (keep - window_offset));
+		window_offset = keep;
+		return true;
+	};
+
+	const uint8_t* data;
+	size_t length;
+	uint64_t read = 0;
+	while (next(data, length)) {
+		read += length;
+		if (size != 0) {
+			g_gui.SetLoadDone(static_cast<int32_t>(100.0 * read / size));
+		}
+
+		// The file identifier is not part of the node stream
+		const size_t skipped = std::min(length, 4 - identifier_bytes);
+		identifier_bytes += skipped;
+		data += skipped;
+		length -= skipped;
+		if (length == 0) {
+			continue;
+		}
+
+		window.insert(window.end(), data, data + length);
+		scanner.feed(data, length, offset);
+		offset += length;
+
+		if ((areas.size() >= batch_areas || window.size() >= window_bytes) && !decodeAreas()) {
+			break;
+		}
+	}
+
+	if (identifier_bytes < 4 || !decodeAreas() || !scanner.isComplete()) {
+		pending_columns.clear();
+		damaged_columns.clear();
+		warning("The map inside the archive is incomplete or damaged.");
+		return false;
+	}
+	window = std::vector<uint8_t>();
+
+	// Everything but the tile areas, read like a regular map
+	MemoryNodeFileReadHandle f(skeleton.data(), skeleton.size());
+	if (!loadMap(map, f)) {
+		pending_columns.clear();
+		damaged_columns.clear();
+		return false;
+	}
+	storePendingColumns(map);
+	return true;
+}
+
+void OTBMAreaScanner::feed(const uint8_t* data, size_t length, uint64_t offset) {
+	// Children of the map data node (depth 3) that turn out to be tile areas are only
+	// reported, every other byte is copied to the skeleton
+	for (size_t i = 0; i < length; ++i) {
+		const uint8_t byte = data[i];
+		const uint64_t position = offset + i;
+
+		if (pending_start) {
+			pending_start = false;
+			if (byte == OTBM_TILE_AREA) {
+				in_area = true;
+				header_length = 0;
+				continue;
+			}
+			skeleton.push_back(NODE_START);
+		}
+
+		if (in_area) {
+			if (escaped) {
+				escaped = false;
+			} else if (byte == ESCAPE_CHAR) {
+				escaped = true;
+				continue;
+			} else if (byte == NODE_START) {
+				++depth;
+				continue;
+			} else if (byte == NODE_END) {
+				if (depth == 3) {
+					in_area = false;
+					Area &area = areas.emplace_back();
+					area.offset = area_start;
+					area.size = position + 1 - area_start;
+					if (header_length == 5) {
+						area.has_base = true;
+						area.base_x = header[0] | (header[1] << 8);
+						area.base_y = header[2] | (header[3] << 8);
+						area.base_z = header[4];
+					}
+				}
+				--depth;
+				continue;
+			}
+			// The base coordinates follow the type byte, before the first tile
+			if (depth == 3 && header_length < 5) {
+				header[header_length++] = byte;
+			}
+			continue;
+		}
+
+		if (escaped) {
+			escaped = false;
+		} else if (byte == ESCAPE_CHAR) {
+			escaped = true;
+		} else if (byte == NODE_START) {
+			if (++depth == 3) {
+				// Held back until the type byte tells whether it is a tile area
+				pending_start = true;
+				area_start = position;
+				continue;
+			}
+		} else if (byte == NODE_END) {
+			--depth;
+		}
+		skeleton.push_back(byte);
+	}
+}
+
 bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	BinaryNode* root = f.getRootNode();
 	if (!root) {
@@ -663,6 +923,10 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	}
 
 	version.otbm = (MapVersionID)u32;
+	// A paged map reads its tile areas later on, with the same version
+	if (MapPager* pager = map.getPager()) {
+		pager->setVersion(version);
+	}
 
 	if (version.otbm > MAP_OTBM_LAST_VERSION) {
 		// Failed to read version
@@ -735,6 +999,20 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 		}
 	}
 
+	if (!side_directory.empty()) {
+		pending_houses = parseXmlFile(side_directory + map.housefile);
+		pending_zones = parseXmlFile(side_directory + map.zonefile);
+		pending_spawns_monster = parseXmlFile(side_directory + map.spawnmonsterfile);
+		pending_spawns_npc = parseXmlFile(side_directory + map.spawnnpcfile);
+	}
+
+	// Tile areas collected by loadParallelMap are decoded with the version read above
+	if (!pending_areas.empty()) {
+		g_gui.SetLoadDone(0, "Loading tile areas...");
+		loadPendingAreas(map, true);
+		storePendingColumns(map);
+	}
+
 	int nodes_loaded = 0;
 
 	for (BinaryNode* mapNode = mapHeaderNode->getChild(); mapNode != nullptr; mapNode = mapNode->advance()) {
@@ -749,130 +1027,7 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 			continue;
 		}
 		if (node_type == OTBM_TILE_AREA) {
-			uint16_t base_x, base_y;
-			uint8_t base_z;
-			if (!mapNode->getU16(base_x) || !mapNode->getU16(base_y) || !mapNode->getU8(base_z)) {
-				warning("Invalid map node, no base coordinate");
-				continue;
-			}
-
-			for (BinaryNode* tileNode = mapNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
-				Tile* tile = nullptr;
-				uint8_t tile_type;
-				if (!tileNode->getByte(tile_type)) {
-					warning("Invalid tile type");
-					continue;
-				}
-				if (tile_type == OTBM_TILE || tile_type == OTBM_HOUSETILE) {
-					// printf("Start\n");
-					uint8_t x_offset, y_offset;
-					if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
-						warning("Could not read position of tile");
-						continue;
-					}
-					const Position pos(base_x + x_offset, base_y + y_offset, base_z);
-
-					if (map.getTile(pos)) {
-						warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
-						continue;
-					}
-
-					tile = map.allocator(map.createTileL(pos));
-					House* house = nullptr;
-					if (tile_type == OTBM_HOUSETILE) {
-						uint32_t house_id;
-						if (!tileNode->getU32(house_id)) {
-							warning("House tile without house data, discarding tile");
-							delete tile;
-							continue;
-						}
-						if (house_id) {
-							house = map.houses.getHouse(house_id);
-							if (!house) {
-								house = newd House(map);
-								house->id = house_id;
-								map.houses.addHouse(house);
-							}
-						} else {
-							warning("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z);
-						}
-					}
-
-					// printf("So far so good\n");
-
-					uint8_t attribute;
-					while (tileNode->getU8(attribute)) {
-						switch (attribute) {
-							case OTBM_ATTR_TILE_FLAGS: {
-								uint32_t flags = 0;
-								if (!tileNode->getU32(flags)) {
-									warning("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->setMapFlags(flags);
-								break;
-							}
-							case OTBM_ATTR_ITEM: {
-								Item* item = Item::Create_OTBM(*this, tileNode);
-								if (item == nullptr) {
-									warning("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->addItem(item);
-								break;
-							}
-							default: {
-								warning("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z);
-								break;
-							}
-						}
-					}
-
-					// printf("Didn't die in loop\n");
-
-					for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
-						Item* item = nullptr;
-						uint8_t node_type;
-						if (!childNode->getByte(node_type)) {
-							warning("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z);
-							continue;
-						}
-						if (node_type == OTBM_ITEM) {
-							item = Item::Create_OTBM(*this, childNode);
-							if (item) {
-								if (!item->unserializeItemNode_OTBM(*this, childNode)) {
-									warning("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								// reform(&map, tile, item);
-								tile->addItem(item);
-							}
-						} else if (node_type == OTBM_TILE_ZONE) {
-							uint16_t zone_count;
-							if (!childNode->getU16(zone_count)) {
-								warning("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z);
-								continue;
-							}
-							for (uint16_t i = 0; i < zone_count; ++i) {
-								uint16_t zone_id;
-								if (!childNode->getU16(zone_id)) {
-									warning("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z);
-									continue;
-								}
-								tile->addZone(zone_id);
-							}
-						} else {
-							warning("Unknown type of tile child node");
-						}
-					}
-
-					tile->update();
-					if (house) {
-						house->addTile(tile);
-					}
-
-					map.setTile(pos.x, pos.y, pos.z, tile);
-				} else {
-					warning("Unknown type of tile node");
-				}
-			}
+			loadTileArea(map, mapNode);
 		} else if (node_type == OTBM_TOWNS) {
 			for (BinaryNode* townNode = mapNode->getChild(); townNode != nullptr; townNode = townNode->advance()) {
 				Town* town = nullptr;
@@ -955,27 +1110,267 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 		}
 	}
 
-	if (!f.isOk()) {
-		warning(wxstr(f.getErrorMessage()).wc_str());
+	if (!f.isOk()) {
+		warning(wxstr(f.getErrorMessage()).wc_str());
+	}
+	return true;
+}
+
+bool IOMapOTBM::loadTileArea(Map &map, BinaryNode* mapNode, bool relink) {
+	OTBMDecodedArea area;
+	const bool decoded = decodeTileArea(mapNode, map.allocator, area);
+	linkTileArea(map, area, relink);
+	return decoded;
+}
+
+void IOMapOTBM::loadPendingAreas(Map &map, bool report_progress) {
+	ThreadPool &pool = ThreadPool::getInstance();
+	const size_t total = pending_areas.size();
+
+	// The areas of a column are kept as they are for the next save, unless one of them was not
+	// aligned to the column or could not be read back exactly
+	const bool fill_cache = g_settings.getBoolean(Config::INCREMENTAL_SAVE);
+
+	// Decoding builds detached tiles and can run anywhere, linking them into the map can not.
+	// Batches keep the decoded tiles that wait for the calling thread bounded.
+	constexpr size_t batch_size = 512;
+	std::vector<OTBMDecodedArea> decoded(std::min(batch_size, total));
+	for (size_t first = 0; first < total; first += batch_size) {
+		const size_t count = std::min(batch_size, total - first);
+		pool.parallelFor(
+			count, 4,
+			[&](size_t begin, size_t end, size_t) {
+				for (size_t i = begin; i < end; ++i) {
+					const OTBMAreaScanner::Area &pending = pending_areas[first + i];
+					MemoryNodeFileReadHandle handle(pending_data + pending.offset, pending.size);
+					BinaryNode* mapNode = handle.getRootNode();
+					uint8_t node_type;
+					if (mapNode && mapNode->getByte(node_type)) {
+						decodeTileArea(mapNode, map.allocator, decoded[i]);
+					} else {
+						decoded[i].warnings.emplace_back("Invalid map node");
+					}
+				}
+			},
+			[&](size_t done, size_t) {
+				if (report_progress) {
+					g_gui.SetLoadDone(static_cast<int32_t>(100.0 * (first + done) / total));
+				}
+			}
+		);
+
+		for (size_t i = 0; i < count; ++i) {
+			const bool exact = linkTileArea(map, decoded[i]);
+			decoded[i].tiles.clear();
+			decoded[i].warnings.clear();
+			if (!fill_cache) {
+				continue;
+			}
+
+			const OTBMAreaScanner::Area &pending = pending_areas[first + i];
+			if (!pending.has_base) {
+				continue;
+			}
+			const uint32_t column = MapSaveCache::getColumnIndex(pending.base_x, pending.base_y);
+			if (!exact || pending.base_x % MapSaveCache::ColumnSize != 0 || pending.base_y % MapSaveCache::ColumnSize != 0) {
+				// Tiles of an unaligned area may lie in the next column over
+				damaged_columns.insert(column);
+				damaged_columns.insert(MapSaveCache::getColumnIndex(pending.base_x + 255, pending.base_y));
+				damaged_columns.insert(MapSaveCache::getColumnIndex(pending.base_x, pending.base_y + 255));
+				damaged_columns.insert(MapSaveCache::getColumnIndex(pending.base_x + 255, pending.base_y + 255));
+				continue;
+			}
+			std::vector<uint8_t> &bytes = pending_columns[column];
+			bytes.insert(bytes.end(), pending_data + pending.offset, pending_data + pending.offset + pending.size);
+		}
+	}
+
+	pending_areas.clear();
+	pending_data = nullptr;
+}
+
+void IOMapOTBM::storePendingColumns(Map &map) {
+	if (g_settings.getBoolean(Config::INCREMENTAL_SAVE)) {
+		map.save_cache.setVersion(version.otbm);
+		for (auto &[column, bytes] : pending_columns) {
+			if (!damaged_columns.contains(column)) {
+				map.save_cache.store(column, std::make_shared<const std::vector<uint8_t>>(std::move(bytes)));
+			}
+		}
+	}
+	pending_columns.clear();
+	damaged_columns.clear();
+}
+
+bool IOMapOTBM::decodeTileArea(BinaryNode* mapNode, MapAllocator &allocator, OTBMDecodedArea &area) const {
+	uint16_t base_x, base_y;
+	uint8_t base_z;
+	if (!mapNode->getU16(base_x) || !mapNode->getU16(base_y) || !mapNode->getU8(base_z)) {
+		area.warnings.emplace_back("Invalid map node, no base coordinate");
+		return false;
+	}
+
+	for (BinaryNode* tileNode = mapNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
+		uint8_t tile_type;
+		if (!tileNode->getByte(tile_type)) {
+			area.warnings.emplace_back("Invalid tile type");
+			continue;
+		}
+		if (tile_type == OTBM_TILE || tile_type == OTBM_HOUSETILE) {
+			uint8_t x_offset, y_offset;
+			if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
+				area.warnings.emplace_back("Could not read position of tile");
+				continue;
+			}
+			const Position pos(base_x + x_offset, base_y + y_offset, base_z);
+
+			uint32_t house_id = 0;
+			if (tile_type == OTBM_HOUSETILE) {
+				if (!tileNode->getU32(house_id)) {
+					area.warnings.emplace_back("House tile without house data, discarding tile");
+					continue;
+				}
+				if (!house_id) {
+					area.warnings.push_back(fmt::format("Invalid house id from tile {}:{}:{}", pos.x, pos.y, pos.z));
+				}
+			}
+
+			// Placed in the map by linkTileArea
+			Tile* tile = allocator.allocateTile(pos.x, pos.y, pos.z);
+
+			uint8_t attribute;
+			while (tileNode->getU8(attribute)) {
+				switch (attribute) {
+					case OTBM_ATTR_TILE_FLAGS: {
+						uint32_t flags = 0;
+						if (!tileNode->getU32(flags)) {
+							area.warnings.push_back(fmt::format("Invalid tile flags of tile on {}:{}:{}", pos.x, pos.y, pos.z));
+						}
+						tile->setMapFlags(flags);
+						break;
+					}
+					case OTBM_ATTR_ITEM: {
+						Item* item = Item::Create_OTBM(*this, tileNode);
+						if (item == nullptr) {
+							area.warnings.push_back(fmt::format("Invalid item at tile {}:{}:{}", pos.x, pos.y, pos.z));
+						}
+						tile->addItem(item);
+						break;
+					}
+					default: {
+						area.warnings.push_back(fmt::format("Unknown tile attribute at {}:{}:{}", pos.x, pos.y, pos.z));
+						break;
+					}
+				}
+			}
+
+			for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
+				uint8_t node_type;
+				if (!childNode->getByte(node_type)) {
+					area.warnings.push_back(fmt::format("Unknown item type {}:{}:{}", pos.x, pos.y, pos.z));
+					continue;
+				}
+				if (node_type == OTBM_ITEM) {
+					Item* item = Item::Create_OTBM(*this, childNode);
+					if (item) {
+						if (!item->unserializeItemNode_OTBM(*this, childNode)) {
+							area.warnings.push_back(fmt::format("Couldn't unserialize item attributes at {}:{}:{}", pos.x, pos.y, pos.z));
+						}
+						// reform(&map, tile, item);
+						tile->addItem(item);
+					}
+				} else if (node_type == OTBM_TILE_ZONE) {
+					uint16_t zone_count;
+					if (!childNode->getU16(zone_count)) {
+						area.warnings.push_back(fmt::format("Invalid zone count at {}:{}:{}", pos.x, pos.y, pos.z));
+						continue;
+					}
+					for (uint16_t i = 0; i < zone_count; ++i) {
+						uint16_t zone_id;
+						if (!childNode->getU16(zone_id)) {
+							area.warnings.push_back(fmt::format("Invalid zone id at {}:{}:{}", pos.x, pos.y, pos.z));
+							continue;
+						}
+						tile->addZone(zone_id);
+					}
+				} else {
+					area.warnings.emplace_back("Unknown type of tile child node");
+				}
+			}
+
+			// Plain items share one record per id and subtype, most of a map is ground and borders
+			tile->compactItems();
+			area.tiles.push_back({ tile, pos, house_id });
+		} else {
+			area.warnings.emplace_back("Unknown type of tile node");
+		}
 	}
 	return true;
 }
 
-bool IOMapOTBM::loadSpawnsMonster(Map &map, const FileName &dir) {
-	std::string fn = (const char*)(dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME).mb_str(wxConvUTF8));
-	fn += map.spawnmonsterfile;
-
-	FileName filename(wxstr(fn));
-	if (!filename.FileExists()) {
-		return false;
+bool IOMapOTBM::linkTileArea(Map &map, OTBMDecodedArea &area, bool relink) {
+	for (const std::string &message : area.warnings) {
+		warnings.push_back(wxstr(message));
 	}
+	bool exact = area.warnings.empty();
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(fn.c_str());
-	if (!result) {
-		return false;
+	for (const OTBMDecodedArea::Entry &entry : area.tiles) {
+		const Position &pos = entry.position;
+		if (map.getTile(pos)) {
+			warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
+			delete entry.tile;
+			exact = false;
+			continue;
+		}
+
+		Tile* tile = entry.tile;
+		tile->setLocation(map.createTileL(pos));
+		tile->update();
+		if (entry.house_id) {
+			House* house = map.houses.getHouse(entry.house_id);
+			if (relink) {
+				// A house removed since is not brought back
+				tile->setHouse(house);
+			} else {
+				if (!house) {
+					house = newd House(map);
+					house->id = entry.house_id;
+					map.houses.addHouse(house);
+				}
+				house->addTile(tile);
+			}
+		}
+
+		if (relink) {
+			map.setPagedTile(pos, tile);
+		} else {
+			map.setTile(pos.x, pos.y, pos.z, tile);
+		}
 	}
-	return loadSpawnsMonster(map, doc);
+	return exact;
+}
+
+IOMapOTBM::PendingDocument IOMapOTBM::parseXmlFile(std::string path) {
+	return std::async(std::launch::async, [path = std::move(path)]() -> std::unique_ptr<pugi::xml_document> {
+		if (!wxFileName::FileExists(wxstr(path))) {
+			return nullptr;
+		}
+		auto doc = std::make_unique<pugi::xml_document>();
+		if (!doc->load_file(path.c_str())) {
+			return nullptr;
+		}
+		return doc;
+	});
+}
+
+IOMapOTBM::PendingDocument IOMapOTBM::parseXmlBuffer(std::vector<uint8_t> buffer) {
+	return std::async(std::launch::async, [buffer = std::move(buffer)]() -> std::unique_ptr<pugi::xml_document> {
+		auto doc = std::make_unique<pugi::xml_document>();
+		if (!doc->load_buffer(buffer.data(), buffer.size())) {
+			return nullptr;
+		}
+		return doc;
+	});
 }
 
 bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
@@ -1111,22 +1506,6 @@ bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
-bool IOMapOTBM::loadHouses(Map &map, const FileName &dir) {
-	std::string fn = (const char*)(dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME).mb_str(wxConvUTF8));
-	fn += map.housefile;
-	FileName filename(wxstr(fn));
-	if (!filename.FileExists()) {
-		return false;
-	}
-
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(fn.c_str());
-	if (!result) {
-		return false;
-	}
-	return loadHouses(map, doc);
-}
-
 bool IOMapOTBM::loadHouses(Map &map, pugi::xml_document &doc) {
 	pugi::xml_node node = doc.child("houses");
 	if (!node) {
@@ -1148,6 +1527,12 @@ bool IOMapOTBM::loadHouses(Map &map, pugi::xml_document &doc) {
 		}
 
 		house = map.houses.getHouse(houseIdAttribute.as_uint());
+		if (!house && map.getPager()) {
+			// The tiles of a paged map are not read yet, so its houses are only known from here
+			house = newd House(map);
+			house->id = houseIdAttribute.as_uint();
+			map.houses.addHouse(house);
+		}
 
 		if (!house) {
 			warnings.push_back(fmt::format("IOMapOTBM::loadHouses: Could not load house #{}", houseIdAttribute.as_uint()));
@@ -1197,22 +1582,6 @@ bool IOMapOTBM::loadHouses(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
-bool IOMapOTBM::loadZones(Map &map, const FileName &dir) {
-	std::string fn = (const char*)(dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME).mb_str(wxConvUTF8));
-	fn += map.zonefile;
-	FileName filename(wxstr(fn));
-	if (!filename.FileExists()) {
-		return false;
-	}
-
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(fn.c_str());
-	if (!result) {
-		return false;
-	}
-	return loadZones(map, doc);
-}
-
 bool IOMapOTBM::loadZones(Map &map, pugi::xml_document &doc) {
 	pugi::xml_node node = doc.child("zones");
 	if (!node) {
@@ -1233,23 +1602,6 @@ bool IOMapOTBM::loadZones(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
-bool IOMapOTBM::loadSpawnsNpc(Map &map, const FileName &dir) {
-	std::string fn = (const char*)(dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME).mb_str(wxConvUTF8));
-	fn += map.spawnnpcfile;
-
-	FileName filename(wxstr(fn));
-	if (!filename.FileExists()) {
-		return false;
-	}
-
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(fn.c_str());
-	if (!result) {
-		return false;
-	}
-	return loadSpawnsNpc(map, doc);
-}
-
 bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 	pugi::xml_node node = doc.child("npcs");
 	if (!node) {
@@ -1379,122 +1731,109 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
+namespace {
+	// An index that is not written again would describe the previous version of the file
+	void saveOTBMIndex(OTBMIndex &index, bool write, const std::string &map_filename) {
+		const std::string filename = OTBMIndex::getFilename(map_filename);
+		if (!write || !index.finish() || !index.save(map_filename)) {
+			std::remove(filename.c_str());
+		}
+	}
+}
+
 bool IOMapOTBM::saveMap(Map &map, const FileName &identifier) {
 #if OTGZ_SUPPORT > 0
 	if (identifier.GetExt() == "otgz") {
+		// The tar stream is compressed a block at a time on every thread while it is written, and
+		// the map is streamed into it column by column instead of being built in memory first
+		BlockGzipWriter writer(nstr(identifier.GetFullPath()));
+		if (!writer.isOk()) {
+			error("Can not open file %s for writing", (const char*)identifier.GetFullPath().mb_str(wxConvUTF8));
+			return false;
+		}
+
 		// Create the archive
 		struct archive* a = archive_write_new();
-		struct archive_entry* entry = nullptr;
-		std::ostringstream streamData;
-
-		archive_write_set_compression_gzip(a);
 		archive_write_set_format_pax_restricted(a);
-		archive_write_open_filename(a, nstr(identifier.GetFullPath()).c_str());
-
-		g_gui.SetLoadDone(0, "Saving monsters...");
-
-		pugi::xml_document spawnDoc;
-		if (saveSpawns(map, spawnDoc)) {
-			// Write the data
-			spawnDoc.save(streamData, "", pugi::format_raw, pugi::encoding_utf8);
-			std::string xmlData = streamData.str();
-
-			// Write to the arhive
-			entry = archive_entry_new();
-			archive_entry_set_pathname(entry, "world/monsters.xml");
-			archive_entry_set_size(entry, xmlData.size());
-			archive_entry_set_filetype(entry, AE_IFREG);
-			archive_entry_set_perm(entry, 0644);
-
-			// Write to the archive
-			archive_write_header(a, entry);
-			archive_write_data(a, xmlData.data(), xmlData.size());
-
-			// Free the entry
-			archive_entry_free(entry);
-			streamData.str("");
-		}
-
-		g_gui.SetLoadDone(0, "Saving houses...");
-
-		pugi::xml_document houseDoc;
-		if (saveHouses(map, houseDoc)) {
-			// Write the data
-			houseDoc.save(streamData, "", pugi::format_raw, pugi::encoding_utf8);
-			std::string xmlData = streamData.str();
-
-			// Write to the arhive
-			entry = archive_entry_new();
-			archive_entry_set_pathname(entry, "world/houses.xml");
-			archive_entry_set_size(entry, xmlData.size());
+		// Nothing follows the archive, the last block does not need padding
+		archive_write_set_bytes_in_last_block(a, 1);
+		archive_write_open(a, &writer, nullptr, writeOTGZData, nullptr);
+
+		const auto addEntry = [&](const char* pathname, uint64_t size) {
+			struct archive_entry* entry = archive_entry_new();
+			archive_entry_set_pathname(entry, pathname);
+			archive_entry_set_size(entry, static_cast<la_int64_t>(size));
 			archive_entry_set_filetype(entry, AE_IFREG);
 			archive_entry_set_perm(entry, 0644);
-
-			// Write to the archive
 			archive_write_header(a, entry);
-			archive_write_data(a, xmlData.data(), xmlData.size());
-
-			// Free the entry
 			archive_entry_free(entry);
-			streamData.str("");
-		}
-
-		g_gui.SetLoadDone(0, "Saving npcs...");
-
-		pugi::xml_document npcDoc;
-		if (saveSpawnsNpc(map, npcDoc)) {
-			// Write the data
-			npcDoc.save(streamData, "", pugi::format_raw, pugi::encoding_utf8);
-			std::string xmlData = streamData.str();
-
-			// Write to the arhive
-			entry = archive_entry_new();
-			archive_entry_set_pathname(entry, "world/npcs.xml");
-			archive_entry_set_size(entry, xmlData.size());
-			archive_entry_set_filetype(entry, AE_IFREG);
-			archive_entry_set_perm(entry, 0644);
-
-			// Write to the archive
-			archive_write_header(a, entry);
-			archive_write_data(a, xmlData.data(), xmlData.size());
+		};
+		const auto addXmlEntry = [&](const char* pathname, const std::string &xmlData) {
+			if (!xmlData.empty()) {
+				addEntry(pathname, xmlData.size());
+				archive_write_data(a, xmlData.data(), xmlData.size());
+			}
+		};
 
-			// Free the entry
-			archive_entry_free(entry);
-			streamData.str("");
-		}
+		// Built while the map is encoded, they still go first in the archive
+		std::future<std::string> spawns = saveSideFile(map, &IOMapOTBM::saveSpawns, true);
+		std::future<std::string> houses = saveSideFile(map, &IOMapOTBM::saveHouses, true);
+		std::future<std::string> npcs = saveSideFile(map, &IOMapOTBM::saveSpawnsNpc, true);
 
+		// The tar header needs the size of the map up front. It is measured by encoding the map once
+		// without keeping any of it, then the map is encoded again straight into the archive. Columns
+		// in the save cache are only copied both times, and so are the areas of a paged map.
 		g_gui.SetLoadDone(0, "Saving OTBM map...");
-
-		MemoryNodeFileWriteHandle otbmWriter;
-		saveMap(map, otbmWriter);
-
-		g_gui.SetLoadDone(75, "Compressing...");
-
-		// Create an archive entry for the otbm file
-		entry = archive_entry_new();
-		archive_entry_set_pathname(entry, "world/map.otbm");
-		archive_entry_set_size(entry, otbmWriter.getSize() + 4); // 4 bytes extra for header
-		archive_entry_set_filetype(entry, AE_IFREG);
-		archive_entry_set_perm(entry, 0644);
-		archive_write_header(a, entry);
-
-		// Write the version header
-		char otbm_identifier[] = "OTBM";
-		archive_write_data(a, otbm_identifier, 4);
-
-		// Write the OTBM data
-		archive_write_data(a, otbmWriter.getMemory(), otbmWriter.getSize());
-		archive_entry_free(entry);
+		StreamNodeFileWriteHandle measure;
+		bool success = saveMap(map, measure);
+		measure.close();
+		const uint64_t otbm_size = 4 + measure.getSize(); // 4 bytes extra for header
+
+		addXmlEntry("world/monsters.xml", spawns.get());
+		addXmlEntry("world/houses.xml", houses.get());
+		addXmlEntry("world/npcs.xml", npcs.get());
+
+		if (success) {
+			g_gui.SetLoadDone(0, "Compressing...");
+			addEntry("world/map.otbm", otbm_size);
+
+			// Write the version header
+			char otbm_identifier[] = "OTBM";
+			archive_write_data(a, otbm_identifier, 4);
+
+			// Write the OTBM data
+			StreamNodeFileWriteHandle stream([a](const uint8_t* data, size_t length) {
+				return archive_write_data(a, data, length) == static_cast<la_ssize_t>(length);
+			});
+			success = saveMap(map, stream);
+			stream.close();
+			if (success && (!stream.isOk() || stream.getSize() != measure.getSize())) {
+				error("Could not write the map to %s", (const char*)identifier.GetFullPath().mb_str(wxConvUTF8));
+				success = false;
+			}
+		}
 
 		// Free / close the archive
 		archive_write_close(a);
 		archive_write_free(a);
 
+		if (!writer.finish() && success) {
+			error("Could not write to %s", (const char*)identifier.GetFullPath().mb_str(wxConvUTF8));
+			success = false;
+		}
+
 		g_gui.DestroyLoadBar();
-		return true;
+		return success;
 	}
 #endif
 
+	// The areas still on disk are copied from the file being replaced, so read them first
+	MapPager* pager = map.getPager();
+	if (pager && FileName(wxstr(pager->getFilename())) == identifier && !pager->detach()) {
+		error("Can not read the tile areas of %s", (const char*)identifier.GetFullPath().mb_str(wxConvUTF8));
+		return false;
+	}
+
 	DiskNodeFileWriteHandle f(
 		nstr(identifier.GetFullPath()),
 		(g_settings.getInteger(Config::SAVE_WITH_OTB_MAGIC_NUMBER) ? "OTBM" : std::string(4, '\0'))
@@ -1505,21 +1844,165 @@ bool IOMapOTBM::saveMap(Map &map, const FileName &identifier) {
 		return false;
 	}
 
+	// The index is built from the node stream as it is written
+	const bool write_index = g_settings.getBoolean(Config::SAVE_OTBM_INDEX);
+	OTBMIndex index;
+	if (write_index) {
+		f.setWriteObserver([&index](const uint8_t* data, size_t length) {
+			index.feed(data, length);
+		});
+	}
+
+	// Built while the map is encoded and written after it
+	std::future<std::string> spawns = saveSideFile(map, &IOMapOTBM::saveSpawns, false);
+	std::future<std::string> houses = saveSideFile(map, &IOMapOTBM::saveHouses, false);
+	std::future<std::string> zones = saveSideFile(map, &IOMapOTBM::saveZones, false);
+	std::future<std::string> npcs = saveSideFile(map, &IOMapOTBM::saveSpawnsNpc, false);
+
 	if (!saveMap(map, f)) {
 		return false;
 	}
+	f.close();
+	saveOTBMIndex(index, write_index, nstr(identifier.GetFullPath()));
+
+	g_gui.SetLoadDone(99, "Saving spawns and houses...");
+
+	// An xml file that can not be written does not fail the map
+	const std::string directory = nstr(identifier.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
+	const auto writeSideFile = [&directory](const std::string &name, const std::string &contents) {
+		if (contents.empty()) {
+			return;
+		}
+		FileWriteHandle file(directory + name);
+		if (!file.isOk() || !file.addRAW(contents)) {
+			spdlog::warn("Could not write {}", directory + name);
+		}
+	};
+	writeSideFile(map.spawnmonsterfile, spawns.get());
+	writeSideFile(map.housefile, houses.get());
+	writeSideFile(map.zonefile, zones.get());
+	writeSideFile(map.spawnnpcfile, npcs.get());
+	return true;
+}
+
+std::future<std::string> IOMapOTBM::saveSideFile(Map &map, bool (IOMapOTBM::*save)(Map &, pugi::xml_document &), bool raw) {
+	const auto serialize = [this, &map, save, raw]() {
+		pugi::xml_document doc;
+		if (!(this->*save)(map, doc)) {
+			return std::string();
+		}
+		std::ostringstream stream;
+		if (raw) {
+			doc.save(stream, "", pugi::format_raw, pugi::encoding_utf8);
+		} else {
+			doc.save(stream, "\t", pugi::format_default, pugi::encoding_utf8);
+		}
+		return stream.str();
+	};
+
+	if (map.getPager()) {
+		std::promise<std::string> built;
+		built.set_value(serialize());
+		return built.get_future();
+	}
+	return std::async(std::launch::async, serialize);
+}
+
+uint64_t OTBMSaveSnapshot::getSize() const {
+	uint64_t size = identifier.size() + head.size() + tail.size();
+	for (const MapSaveCache::Bytes &column : columns) {
+		size += column->size();
+	}
+	for (const auto &[path, contents] : side_files) {
+		size += contents.size();
+	}
+	return size;
+}
+
+bool IOMapOTBM::snapshotMap(Map &map, const FileName &identifier, OTBMSaveSnapshot &snapshot) {
+	// The areas of a paged map that were never read are only in the file that is replaced
+	if (map.getPager()) {
+		error("Paged maps can not be saved in the background");
+		return false;
+	}
+
+	snapshot.filename = nstr(identifier.GetFullPath());
+	snapshot.identifier = g_settings.getInteger(Config::SAVE_WITH_OTB_MAGIC_NUMBER) ? "OTBM" : std::string(4, '\0');
+	snapshot.write_index = g_settings.getBoolean(Config::SAVE_OTBM_INDEX);
+
+	// Built while the tile areas are encoded
+	std::future<std::string> spawns = saveSideFile(map, &IOMapOTBM::saveSpawns, false);
+	std::future<std::string> houses = saveSideFile(map, &IOMapOTBM::saveHouses, false);
+	std::future<std::string> zones = saveSideFile(map, &IOMapOTBM::saveZones, false);
+	std::future<std::string> npcs = saveSideFile(map, &IOMapOTBM::saveSpawnsNpc, false);
+
+	MemoryNodeFileWriteHandle head;
+	saveMapHeader(map, head);
+	snapshot.head.assign(head.getMemory(), head.getMemory() + head.getSize());
+
+	// Only the columns that changed since the last save are encoded, the others are shared with the cache
+	saveTileAreas(map, nullptr, &snapshot.columns);
+
+	MemoryNodeFileWriteHandle tail;
+	saveMapFooter(map, tail);
+	snapshot.tail.assign(tail.getMemory(), tail.getMemory() + tail.getSize());
+
+	const std::string directory = nstr(identifier.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
+	const auto addSideFile = [&](const std::string &name, std::string contents) {
+		if (!contents.empty()) {
+			snapshot.side_files.emplace_back(directory + name, std::move(contents));
+		}
+	};
+	addSideFile(map.spawnmonsterfile, spawns.get());
+	addSideFile(map.housefile, houses.get());
+	addSideFile(map.zonefile, zones.get());
+	addSideFile(map.spawnnpcfile, npcs.get());
+	return true;
+}
+
+bool IOMapOTBM::writeSnapshot(const OTBMSaveSnapshot &snapshot, const std::function<void(uint64_t, uint64_t)> &progress) {
+	const uint64_t total = snapshot.getSize();
+	uint64_t done = snapshot.identifier.size();
 
-	g_gui.SetLoadDone(99, "Saving monster spawns...");
-	saveSpawns(map, identifier);
+	OTBMIndex index;
+	{
+		DiskNodeFileWriteHandle f(snapshot.filename, snapshot.identifier);
+		if (!f.isOk()) {
+			error("Can not open file %s for writing", snapshot.filename.c_str());
+			return false;
+		}
+		if (snapshot.write_index) {
+			f.setWriteObserver([&index](const uint8_t* data, size_t length) {
+				index.feed(data, length);
+			});
+		}
 
-	g_gui.SetLoadDone(99, "Saving houses...");
-	saveHouses(map, identifier);
+		f.addEncodedNode(snapshot.head.data(), snapshot.head.size());
+		done += snapshot.head.size();
 
-	g_gui.SetLoadDone(99, "Saving zones...");
-	saveZones(map, identifier);
+		for (const MapSaveCache::Bytes &column : snapshot.columns) {
+			f.addEncodedNode(column->data(), column->size());
+			done += column->size();
+			progress(done, total);
+		}
+
+		if (!f.addEncodedNode(snapshot.tail.data(), snapshot.tail.size())) {
+			error("Could not write to %s", snapshot.filename.c_str());
+			return false;
+		}
+		done += snapshot.tail.size();
+	}
+	saveOTBMIndex(index, snapshot.write_index, snapshot.filename);
 
-	g_gui.SetLoadDone(99, "Saving npcs spawns...");
-	saveSpawnsNpc(map, identifier);
+	// Like the serial save, an xml file that can not be written does not fail the map
+	for (const auto &[path, contents] : snapshot.side_files) {
+		FileWriteHandle f(path);
+		if (!f.isOk() || !f.addRAW(contents)) {
+			spdlog::warn("Could not write {}", path);
+		}
+		done += contents.size();
+		progress(done, total);
+	}
 	return true;
 }
 
@@ -1535,203 +2018,342 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	 * format.
 	 */
 
-	const IOMapOTBM &self = *this;
+	// Only the tiles in memory are written from the map, the rest is copied from the paged file
+	MapPager::Suspend suspend_paging(map.getPager());
+
+	saveMapHeader(map, f);
+	saveTileAreas(map, &f);
+
+	if (MapPager* pager = map.getPager(); pager && !pager->writeAreas(f)) {
+		error("Could not copy the tile areas from %s", pager->getFilename().c_str());
+		return false;
+	}
+
+	saveMapFooter(map, f);
+	return true;
+}
 
+void IOMapOTBM::saveMapHeader(Map &map, NodeFileWriteHandle &f) {
 	FileName tmpName;
 	f.addNode(0);
-	{
-		const auto mapVersion = map.mapVersion.otbm < MapVersionID::MAP_OTBM_5 ? MapVersionID::MAP_OTBM_5 : map.mapVersion.otbm;
-		f.addU32(mapVersion); // Map version
 
-		f.addU16(map.width);
-		f.addU16(map.height);
+	const auto mapVersion = map.mapVersion.otbm < MapVersionID::MAP_OTBM_5 ? MapVersionID::MAP_OTBM_5 : map.mapVersion.otbm;
+	f.addU32(mapVersion); // Map version
 
-		f.addU32(4); // Major otb version (deprecated)
-		f.addU32(4); // Minor otb version (deprecated)
+	f.addU16(map.width);
+	f.addU16(map.height);
 
-		f.addNode(OTBM_MAP_DATA);
-		{
-			f.addByte(OTBM_ATTR_DESCRIPTION);
-			// Neither SimOne's nor OpenTibia cares for additional description tags
-			f.addString("Saved with Canary's Map Editor " + __RME_VERSION__);
+	f.addU32(4); // Major otb version (deprecated)
+	f.addU32(4); // Minor otb version (deprecated)
 
-			f.addU8(OTBM_ATTR_DESCRIPTION);
-			f.addString(map.description);
+	f.addNode(OTBM_MAP_DATA);
 
-			tmpName.Assign(wxstr(map.spawnmonsterfile));
-			f.addU8(OTBM_ATTR_EXT_SPAWN_MONSTER_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	f.addByte(OTBM_ATTR_DESCRIPTION);
+	// Neither SimOne's nor OpenTibia cares for additional description tags
+	f.addString("Saved with Canary's Map Editor " + __RME_VERSION__);
 
-			tmpName.Assign(wxstr(map.spawnnpcfile));
-			f.addU8(OTBM_ATTR_EXT_SPAWN_NPC_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	f.addU8(OTBM_ATTR_DESCRIPTION);
+	f.addString(map.description);
 
-			tmpName.Assign(wxstr(map.housefile));
-			f.addU8(OTBM_ATTR_EXT_HOUSE_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	tmpName.Assign(wxstr(map.spawnmonsterfile));
+	f.addU8(OTBM_ATTR_EXT_SPAWN_MONSTER_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
 
-			tmpName.Assign(wxstr(map.zonefile));
-			f.addU8(OTBM_ATTR_EXT_ZONE_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	tmpName.Assign(wxstr(map.spawnnpcfile));
+	f.addU8(OTBM_ATTR_EXT_SPAWN_NPC_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
 
-			// Start writing tiles
-			uint32_t tiles_saved = 0;
-			bool first = true;
+	tmpName.Assign(wxstr(map.housefile));
+	f.addU8(OTBM_ATTR_EXT_HOUSE_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
 
-			int local_x = -1, local_y = -1, local_z = -1;
+	tmpName.Assign(wxstr(map.zonefile));
+	f.addU8(OTBM_ATTR_EXT_ZONE_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
+}
 
-			MapIterator map_iterator = map.begin();
-			while (map_iterator != map.end()) {
-				// Update progressbar
-				++tiles_saved;
-				if (tiles_saved % 8192 == 0) {
-					g_gui.SetLoadDone(int(tiles_saved / double(map.getTileCount()) * 100.0));
-				}
+void IOMapOTBM::saveMapFooter(Map &map, NodeFileWriteHandle &f) {
+	f.addNode(OTBM_TOWNS);
+	for (const auto &townEntry : map.towns) {
+		Town* town = townEntry.second;
+		const Position &townPosition = town->getTemplePosition();
+		f.addNode(OTBM_TOWN);
+		f.addU32(town->getID());
+		f.addString(town->getName());
+		f.addU16(townPosition.x);
+		f.addU16(townPosition.y);
+		f.addU8(townPosition.z);
+		f.endNode();
+	}
+	f.endNode();
 
-				// Get tile
-				Tile* save_tile = (*map_iterator)->get();
+	if (version.otbm >= MAP_OTBM_3) {
+		f.addNode(OTBM_WAYPOINTS);
+		for (const auto &waypointEntry : map.waypoints) {
+			Waypoint* waypoint = waypointEntry.second;
+			f.addNode(OTBM_WAYPOINT);
+			f.addString(waypoint->name);
+			f.addU16(waypoint->pos.x);
+			f.addU16(waypoint->pos.y);
+			f.addU8(waypoint->pos.z);
+			f.endNode();
+		}
+		f.endNode();
+	}
 
-				// Is it an empty tile that we can skip? (Leftovers...)
-				if (!save_tile || save_tile->size() == 0) {
-					++map_iterator;
-					continue;
-				}
+	f.endNode(); // OTBM_MAP_DATA
+	f.endNode(); // Root
+}
 
-				const Position &pos = save_tile->getPosition();
+namespace {
+	// Tracks the tile area the serial writer is in, a new one starts whenever a tile falls outside of it
+	struct OTBMAreaCursor {
+		int x = -1;
+		int y = -1;
+		int z = -1;
 
-				// Decide if newd node should be created
-				if (pos.x < local_x || pos.x >= local_x + 256 || pos.y < local_y || pos.y >= local_y + 256 || pos.z != local_z) {
-					// End last node
-					if (!first) {
-						f.endNode();
-					}
-					first = false;
+		bool enter(const Position &pos) noexcept {
+			if (pos.x >= x && pos.x < x + 256 && pos.y >= y && pos.y < y + 256 && pos.z == z) {
+				return false;
+			}
+			x = pos.x & 0xFF00;
+			y = pos.y & 0xFF00;
+			z = pos.z;
+			return true;
+		}
+	};
+}
 
-					// Start newd node
-					f.addNode(OTBM_TILE_AREA);
-					f.addU16(local_x = pos.x & 0xFF00);
-					f.addU16(local_y = pos.y & 0xFF00);
-					f.addU8(local_z = pos.z);
-				}
-				f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+void IOMapOTBM::saveTileAreas(Map &map, NodeFileWriteHandle* f, std::vector<MapSaveCache::Bytes>* column_bytes_out) {
+	// The tree visits every 256x256 column in one go and a new area starts whenever a tile falls
+	// outside the current one, so a run of tiles that begins a new area serialises to the same bytes
+	// on its own as it does in the middle of the file. The columns are cut into parts at such
+	// boundaries, encoded into separate buffers on every thread and appended in order. Columns that
+	// did not change since the last load or save are copied from the save cache instead.
+	constexpr size_t part_tiles = 4096;
+
+	MapSaveCache &cache = map.save_cache;
+	// Paged maps copy the areas they did not read from the file already
+	const bool use_cache = !map.getPager() && g_settings.getBoolean(Config::INCREMENTAL_SAVE);
+	if (use_cache) {
+		cache.setVersion(version.otbm);
+	} else {
+		cache.clear();
+	}
+	// Walking the map to save it does not change any tile
+	MapSaveCache::Suspend suspend_cache(cache);
 
-				f.addU8(save_tile->getX() & 0xFF);
-				f.addU8(save_tile->getY() & 0xFF);
+	if (serial_tile_areas && f) {
+		std::vector<Tile*> tiles;
+		for (MapIterator map_iterator = map.begin(); map_iterator != map.end(); ++map_iterator) {
+			Tile* save_tile = (*map_iterator)->get();
+			if (save_tile && save_tile->size() != 0) {
+				tiles.push_back(save_tile);
+			}
+		}
+		serializeTileAreas(tiles, 0, tiles.size(), *f);
+		return;
+	}
 
-				if (save_tile->isHouseTile()) {
-					f.addU32(save_tile->getHouseID());
-				}
+	// The bytes of the encoded columns are needed for the cache or by the caller
+	const bool keep_bytes = use_cache || column_bytes_out;
 
-				if (save_tile->getMapFlags()) {
-					f.addByte(OTBM_ATTR_TILE_FLAGS);
-					f.addU32(save_tile->getMapFlags());
-				}
+	struct Column {
+		uint32_t index;
+		MapSaveCache::Bytes cached;
+	};
+	struct Part {
+		size_t column;
+		size_t begin;
+		size_t end;
+	};
 
-				if (save_tile->ground) {
-					Item* ground = save_tile->ground;
-					if (ground->isMetaItem()) {
-						// Do nothing, we don't save metaitems...
-					} else if (ground->hasBorderEquivalent()) {
-						bool found = false;
-						for (Item* item : save_tile->items) {
-							if (item->getGroundEquivalent() == ground->getID()) {
-								// Do nothing
-								// Found equivalent
-								found = true;
-								break;
-							}
-						}
+	std::vector<Tile*> tiles;
+	std::vector<Column> columns;
+	std::vector<Part> parts;
 
-						if (!found) {
-							if (ground->getID() == 0) {
-								continue;
-							}
-							ground->serializeItemNode_OTBM(self, f);
-						}
-					} else if (ground->isComplex()) {
-						if (ground->getID() == 0) {
-							continue;
-						}
-						ground->serializeItemNode_OTBM(self, f);
-					} else {
-						f.addByte(OTBM_ATTR_ITEM);
-						if (ground->getID() == 0) {
-							continue;
-						}
-						ground->serializeItemCompact_OTBM(self, f);
-					}
-				}
+	OTBMAreaCursor area;
+	for (MapIterator map_iterator = map.begin(); map_iterator != map.end(); ++map_iterator) {
+		Tile* save_tile = (*map_iterator)->get();
+		// Is it an empty tile that we can skip? (Leftovers...)
+		if (!save_tile || save_tile->size() == 0) {
+			continue;
+		}
 
-				for (Item* item : save_tile->items) {
-					if (!item->isMetaItem()) {
-						if (item->getID() == 0) {
-							continue;
-						}
-						item->serializeItemNode_OTBM(self, f);
-					}
-				}
-				if (!save_tile->zones.empty()) {
-					f.addNode(OTBM_TILE_ZONE);
-					f.addU16(save_tile->zones.size());
-					for (const auto &zoneId : save_tile->zones) {
-						f.addU16(zoneId);
-					}
-					f.endNode();
-				}
+		const Position &pos = save_tile->getPosition();
+		const uint32_t column_index = MapSaveCache::getColumnIndex(pos.x, pos.y);
+		if (columns.empty() || columns.back().index != column_index) {
+			columns.push_back({ column_index, use_cache ? cache.find(column_index) : nullptr });
+		}
+		if (columns.back().cached) {
+			continue;
+		}
 
-				f.endNode();
-				++map_iterator;
+		// The first tile of a column always starts a new area
+		if (area.enter(pos) && (parts.empty() || parts.back().column != columns.size() - 1 || tiles.size() - parts.back().begin >= part_tiles)) {
+			if (!parts.empty()) {
+				parts.back().end = tiles.size();
 			}
+			parts.push_back({ columns.size() - 1, tiles.size(), 0 });
+		}
+		tiles.push_back(save_tile);
+	}
+	if (!parts.empty()) {
+		parts.back().end = tiles.size();
+	}
 
-			// Only close the last node if one has actually been created
-			if (!first) {
-				f.endNode();
+	ThreadPool &pool = ThreadPool::getInstance();
+	// Batches bound the memory held by buffers that wait to be appended
+	const size_t batch_size = pool.getThreadCount() * 4;
+	std::vector<MemoryNodeFileWriteHandle> buffers(std::min(batch_size, parts.size()));
+
+	size_t next_column = 0;
+	std::vector<uint8_t> column_bytes;
+	const auto writeCachedColumns = [&](size_t until) {
+		for (; next_column < until; ++next_column) {
+			const MapSaveCache::Bytes &cached = columns[next_column].cached;
+			if (f) {
+				f->addEncodedNode(cached->data(), cached->size());
 			}
+			if (column_bytes_out) {
+				column_bytes_out->push_back(cached);
+			}
+		}
+	};
 
-			f.addNode(OTBM_TOWNS);
-			for (const auto &townEntry : map.towns) {
-				Town* town = townEntry.second;
-				const Position &townPosition = town->getTemplePosition();
-				f.addNode(OTBM_TOWN);
-				f.addU32(town->getID());
-				f.addString(town->getName());
-				f.addU16(townPosition.x);
-				f.addU16(townPosition.y);
-				f.addU8(townPosition.z);
-				f.endNode();
+	for (size_t first = 0; first < parts.size(); first += batch_size) {
+		const size_t count = std::min(batch_size, parts.size() - first);
+		pool.parallelFor(
+			count, 1,
+			[&](size_t begin, size_t end, size_t) {
+				for (size_t i = begin; i < end; ++i) {
+					buffers[i].reset();
+					serializeTileAreas(tiles, parts[first + i].begin, parts[first + i].end, buffers[i]);
+				}
+			},
+			[&](size_t done, size_t) {
+				g_gui.SetLoadDone(static_cast<int32_t>(100.0 * (first + done) / parts.size()));
+			}
+		);
+
+		for (size_t i = 0; i < count; ++i) {
+			const Part &part = parts[first + i];
+			writeCachedColumns(part.column);
+
+			MemoryNodeFileWriteHandle &buffer = buffers[i];
+			if (f) {
+				f->addEncodedNode(buffer.getMemory(), buffer.getSize());
+			}
+			if (keep_bytes) {
+				column_bytes.insert(column_bytes.end(), buffer.getMemory(), buffer.getMemory() + buffer.getSize());
 			}
-			f.endNode();
 
-			if (version.otbm >= MAP_OTBM_3) {
-				f.addNode(OTBM_WAYPOINTS);
-				for (const auto &waypointEntry : map.waypoints) {
-					Waypoint* waypoint = waypointEntry.second;
-					f.addNode(OTBM_WAYPOINT);
-					f.addString(waypoint->name);
-					f.addU16(waypoint->pos.x);
-					f.addU16(waypoint->pos.y);
-					f.addU8(waypoint->pos.z);
-					f.endNode();
+			const bool last_part = first + i + 1 == parts.size() || parts[first + i + 1].column != part.column;
+			if (last_part) {
+				if (keep_bytes) {
+					MapSaveCache::Bytes bytes = std::make_shared<const std::vector<uint8_t>>(std::move(column_bytes));
+					column_bytes = std::vector<uint8_t>();
+					if (use_cache) {
+						cache.store(columns[part.column].index, bytes);
+					}
+					if (column_bytes_out) {
+						column_bytes_out->push_back(std::move(bytes));
+					}
 				}
+				++next_column;
+			}
+		}
+	}
+	writeCachedColumns(columns.size());
+}
+
+void IOMapOTBM::serializeTileAreas(const std::vector<Tile*> &tiles, size_t begin, size_t end, NodeFileWriteHandle &f) const {
+	OTBMAreaCursor area;
+	for (size_t index = begin; index < end; ++index) {
+		Tile* save_tile = tiles[index];
+
+		// Decide if newd node should be created
+		if (area.enter(save_tile->getPosition())) {
+			// End last node
+			if (index != begin) {
 				f.endNode();
 			}
+
+			// Start newd node
+			f.addNode(OTBM_TILE_AREA);
+			f.addU16(area.x);
+			f.addU16(area.y);
+			f.addU8(area.z);
 		}
+		serializeTile(save_tile, f);
+	}
+
+	// Only close the last node if one has actually been created
+	if (begin != end) {
 		f.endNode();
 	}
-	f.endNode();
-	return true;
 }
 
-bool IOMapOTBM::saveSpawns(Map &map, const FileName &dir) {
-	wxString filepath = dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
-	filepath += wxString(map.spawnmonsterfile.c_str(), wxConvUTF8);
+void IOMapOTBM::serializeTile(Tile* save_tile, NodeFileWriteHandle &f) const {
+	f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+
+	f.addU8(save_tile->getX() & 0xFF);
+	f.addU8(save_tile->getY() & 0xFF);
 
-	// Create the XML file
-	pugi::xml_document doc;
-	if (saveSpawns(map, doc)) {
-		return doc.save_file(filepath.wc_str(), "\t", pugi::format_default, pugi::encoding_utf8);
+	if (save_tile->isHouseTile()) {
+		f.addU32(save_tile->getHouseID());
 	}
-	return false;
+
+	if (save_tile->getMapFlags()) {
+		f.addByte(OTBM_ATTR_TILE_FLAGS);
+		f.addU32(save_tile->getMapFlags());
+	}
+
+	// A ground without id is not written at all
+	if (save_tile->ground && save_tile->ground->getID() != 0) {
+		Item* ground = save_tile->ground;
+		if (ground->isMetaItem()) {
+			// Do nothing, we don't save metaitems...
+		} else if (ground->hasBorderEquivalent()) {
+			bool found = false;
+			for (Item* item : save_tile->items) {
+				if (item->getGroundEquivalent() == ground->getID()) {
+					// Do nothing
+					// Found equivalent
+					found = true;
+					break;
+				}
+			}
+
+			if (!found) {
+				ground->serializeItemNode_OTBM(*this, f);
+			}
+		} else if (ground->isComplex()) {
+			ground->serializeItemNode_OTBM(*this, f);
+		} else {
+			f.addByte(OTBM_ATTR_ITEM);
+			ground->serializeItemCompact_OTBM(*this, f);
+		}
+	}
+
+	for (Item* item : save_tile->items) {
+		if (!item->isMetaItem()) {
+			if (item->getID() == 0) {
+				continue;
+			}
+			item->serializeItemNode_OTBM(*this, f);
+		}
+	}
+	if (!save_tile->zones.empty()) {
+		f.addNode(OTBM_TILE_ZONE);
+		f.addU16(save_tile->zones.size());
+		for (const auto &zoneId : save_tile->zones) {
+			f.addU16(zoneId);
+		}
+		f.endNode();
+	}
+
+	f.endNode();
 }
 
 bool IOMapOTBM::saveSpawns(Map &map, pugi::xml_document &doc) {
@@ -1799,18 +2421,6 @@ bool IOMapOTBM::saveSpawns(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
-bool IOMapOTBM::saveHouses(Map &map, const FileName &dir) {
-	wxString filepath = dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
-	filepath += wxString(map.housefile.c_str(), wxConvUTF8);
-
-	// Create the XML file
-	pugi::xml_document doc;
-	if (saveHouses(map, doc)) {
-		return doc.save_file(filepath.wc_str(), "\t", pugi::format_default, pugi::encoding_utf8);
-	}
-	return false;
-}
-
 bool IOMapOTBM::saveHouses(Map &map, pugi::xml_document &doc) {
 	pugi::xml_node decl = doc.prepend_child(pugi::node_declaration);
 	if (!decl) {
@@ -1845,18 +2455,6 @@ bool IOMapOTBM::saveHouses(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
-bool IOMapOTBM::saveZones(Map &map, const FileName &dir) {
-	wxString filepath = dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
-	filepath += wxString(map.zonefile.c_str(), wxConvUTF8);
-
-	// Create the XML file
-	pugi::xml_document doc;
-	if (saveZones(map, doc)) {
-		return doc.save_file(filepath.wc_str(), "\t", pugi::format_default, pugi::encoding_utf8);
-	}
-	return false;
-}
-
 bool IOMapOTBM::saveZones(Map &map, pugi::xml_document &doc) {
 	pugi::xml_node decl = doc.prepend_child(pugi::node_declaration);
 	if (!decl) {
@@ -1878,18 +2476,6 @@ bool IOMapOTBM::saveZones(Map &map, pugi::xml_document &doc) {
 	return true;
 }
 
-bool IOMapOTBM::saveSpawnsNpc(Map &map, const FileName &dir) {
-	wxString filepath = dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
-	filepath += wxString(map.spawnnpcfile.c_str(), wxConvUTF8);
-
-	// Create the XML file
-	pugi::xml_document doc;
-	if (saveSpawnsNpc(map, doc)) {
-		return doc.save_file(filepath.wc_str(), "\t", pugi::format_default, pugi::encoding_utf8);
-	}
-	return false;
-}
-
 bool IOMapOTBM::saveSpawnsNpc(Map &map, pugi::xml_document &doc) {
 	pugi::xml_node decl = doc.prepend_child(pugi::node_declaration);
 	if (!decl) {
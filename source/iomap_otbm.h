@@ -19,6 +19,13 @@
 #define RME_OTBM_MAP_IO_H_
 
 #include "iomap.h"
+#include "map_save_cache.h"
+#include "position.h"
+
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
 
 enum OTBM_ItemAttribute {
 	OTBM_ATTR_DESCRIPTION = 1,
@@ -110,8 +117,90 @@ struct OTBM_HouseTile_coords {
 
 struct MapVersion;
 class NodeFileReadHandle;
+class MappedNodeFileReadHandle;
 class NodeFileWriteHandle;
+class MapAllocator;
+class BinaryNode;
 class Map;
+class Tile;
+
+// Splits the node stream of an OTBM file into its tile areas and everything else, without decoding
+// a single node. The bytes following the identifier are fed in order, in chunks of any size. Tile
+// areas are only reported, every other byte is copied to the skeleton, which starts at the root
+// node and reads like a map without tiles.
+class OTBMAreaScanner {
+public:
+	struct Area {
+		// Of the NODE_START byte, counted like the offsets given to feed
+		uint64_t offset = 0;
+		// Up to and including the NODE_END byte
+		uint64_t size = 0;
+		// Only valid when the node has a complete base coordinate
+		bool has_base = false;
+		int base_x = 0;
+		int base_y = 0;
+		int base_z = 0;
+	};
+
+	explicit OTBMAreaScanner(std::vector<uint8_t> &skeleton) :
+		skeleton(skeleton) { }
+
+	// Scans length bytes that start at offset in the stream
+	void feed(const uint8_t* data, size_t length, uint64_t offset);
+	// Whether every node that was opened has been closed again
+	bool isComplete() const noexcept {
+		return depth == 0 && !in_area && !pending_start;
+	}
+
+	std::vector<Area> &getAreas() noexcept {
+		return areas;
+	}
+	// Where the area being scanned starts, every byte before it is done with once the areas
+	// that were reported are read. The offset of the next byte when no area is open.
+	uint64_t getOpenAreaOffset(uint64_t next_offset) const noexcept {
+		return in_area || pending_start ? area_start : next_offset;
+	}
+
+private:
+	std::vector<uint8_t> &skeleton;
+	std::vector<Area> areas;
+
+	int depth = 0;
+	bool escaped = false;
+	bool pending_start = false;
+	bool in_area = false;
+	uint64_t area_start = 0;
+	uint8_t header[5] = {};
+	int header_length = 0;
+};
+
+// The tiles of one tile area node, read without touching the map so it can happen on any thread
+struct OTBMDecodedArea {
+	struct Entry {
+		Tile* tile;
+		Position position;
+		uint32_t house_id;
+	};
+
+	std::vector<Entry> tiles;
+	std::vector<std::string> warnings;
+};
+
+// Everything an OTBM map and its xml files are written from, taken on the GUI thread so that
+// the files can be written on another one while the map is being edited
+struct OTBMSaveSnapshot {
+	std::string filename;
+	std::string identifier;
+	// Encoded nodes, the head opens the root and map data nodes that the tail closes again
+	std::vector<uint8_t> head;
+	std::vector<MapSaveCache::Bytes> columns;
+	std::vector<uint8_t> tail;
+	// Full path and contents of each xml file next to the map
+	std::vector<std::pair<std::string, std::string>> side_files;
+	bool write_index = false;
+
+	uint64_t getSize() const;
+};
 
 class IOMapOTBM : public IOMap {
 public:
@@ -122,29 +211,89 @@ public:
 
 	virtual bool loadMap(Map &map, const FileName &identifier);
 	virtual bool saveMap(Map &map, const FileName &identifier);
+	// Reads only the tile areas that may hold tiles within the box, through the index next to the
+	// file when there is a valid one. Every node that is not a tile area is read as usual.
+	bool loadMapRegion(Map &map, const FileName &identifier, const Position &from, const Position &to);
+
+	// Encodes every tile area that changed since the last save, paged maps can not be snapshotted
+	bool snapshotMap(Map &map, const FileName &identifier, OTBMSaveSnapshot &snapshot);
+	// Does not touch the map or the GUI, progress is reported in bytes written
+	bool writeSnapshot(const OTBMSaveSnapshot &snapshot, const std::function<void(uint64_t, uint64_t)> &progress);
+
+	// Writes the tile areas in one pass over the map on the calling thread, without the save cache,
+	// the way they were written before being split in parts. The reference the parts are checked against.
+	void setSerialTileAreas(bool serial) noexcept {
+		serial_tile_areas = serial;
+	}
 
 protected:
 	static bool getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver);
 
 	virtual bool loadMap(Map &map, NodeFileReadHandle &handle);
-	bool loadSpawnsMonster(Map &map, const FileName &dir);
+	// Reads the OTBM file itself, whole, paged or on every thread
+	bool loadMapFile(Map &map, const FileName &identifier);
+	bool loadPagedMap(Map &map, const FileName &identifier);
+	bool loadParallelMap(Map &map, MappedNodeFileReadHandle &handle);
+	// Reads the node stream a block at a time, next returns false once it is exhausted. The tile
+	// areas are decoded as soon as they are complete, only the bytes of the areas that are not
+	// decoded yet are kept.
+	bool loadStreamedMap(Map &map, const std::function<bool(const uint8_t*&data, size_t &size)> &next, uint64_t size);
+	// With relink, the tiles are those of a cell evicted by the MapPager: their unique ids, zones
+	// and house positions are still registered
+	bool loadTileArea(Map &map, BinaryNode* mapNode, bool relink = false);
+	// Decodes the areas collected by loadParallelMap on every thread, then links them in file order.
+	// Their bytes are gathered per column until storePendingColumns adds them to the save cache.
+	void loadPendingAreas(Map &map, bool report_progress);
+	void storePendingColumns(Map &map);
+	// Allocates the tiles from the pool of the map they are linked into, from any thread
+	bool decodeTileArea(BinaryNode* mapNode, MapAllocator &allocator, OTBMDecodedArea &area) const;
+	// Returns false when a tile was discarded or the area had warnings
+	bool linkTileArea(Map &map, OTBMDecodedArea &area, bool relink = false);
 	bool loadSpawnsMonster(Map &map, pugi::xml_document &doc);
-	bool loadHouses(Map &map, const FileName &dir);
 	bool loadHouses(Map &map, pugi::xml_document &doc);
-	bool loadSpawnsNpc(Map &map, const FileName &dir);
 	bool loadSpawnsNpc(Map &map, pugi::xml_document &doc);
-	bool loadZones(Map &map, const FileName &dir);
 	bool loadZones(Map &map, pugi::xml_document &doc);
+	// Reads and parses an xml file next to the map on another thread, null if it can not be read
+	using PendingDocument = std::future<std::unique_ptr<pugi::xml_document>>;
+	static PendingDocument parseXmlFile(std::string path);
+	static PendingDocument parseXmlBuffer(std::vector<uint8_t> buffer);
 
 	virtual bool saveMap(Map &map, NodeFileWriteHandle &handle);
-	bool saveSpawns(Map &map, const FileName &dir);
+	// Opens the root and map data nodes and writes the map attributes
+	void saveMapHeader(Map &map, NodeFileWriteHandle &handle);
+	// Writes the towns and waypoints and closes the nodes opened by saveMapHeader
+	void saveMapFooter(Map &map, NodeFileWriteHandle &handle);
+	// Writes the tiles in memory as tile area nodes, serialised on every thread. Without a handle the
+	// areas are only encoded, the bytes of every column are added to columns when it is given.
+	void saveTileAreas(Map &map, NodeFileWriteHandle* handle, std::vector<MapSaveCache::Bytes>* columns = nullptr);
+	// Writes tiles[begin, end), the first of which starts a new tile area
+	void serializeTileAreas(const std::vector<Tile*> &tiles, size_t begin, size_t end, NodeFileWriteHandle &handle) const;
+	void serializeTile(Tile* tile, NodeFileWriteHandle &handle) const;
 	bool saveSpawns(Map &map, pugi::xml_document &doc);
-	bool saveHouses(Map &map, const FileName &dir);
 	bool saveHouses(Map &map, pugi::xml_document &doc);
-	bool saveSpawnsNpc(Map &map, const FileName &dir);
 	bool saveSpawnsNpc(Map &map, pugi::xml_document &doc);
-	bool saveZones(Map &map, const FileName &dir);
 	bool saveZones(Map &map, pugi::xml_document &doc);
+	// Serializes one of the xml files on another thread, empty when there is nothing to write.
+	// The body encoder never reads what these write, but a paged map is built right away since
+	// only the calling thread may page cells in.
+	std::future<std::string> saveSideFile(Map &map, bool (IOMapOTBM::*save)(Map &, pugi::xml_document &), bool raw);
+
+	bool serial_tile_areas = false;
+
+	// Tile areas of the file being loaded by loadParallelMap, read once the map header is known
+	const uint8_t* pending_data = nullptr;
+	std::vector<OTBMAreaScanner::Area> pending_areas;
+	std::unordered_map<uint32_t, std::vector<uint8_t>> pending_columns;
+	std::unordered_set<uint32_t> damaged_columns;
+	// Directory of the map being loaded from a file, the xml files start loading on other threads
+	// as soon as the map header names them and are added to the map after the tiles
+	std::string side_directory;
+	PendingDocument pending_houses;
+	PendingDocument pending_zones;
+	PendingDocument pending_spawns_monster;
+	PendingDocument pending_spawns_npc;
+
+	friend class MapPager;
 };
 
 #endif
@@ -30,6 +30,10 @@
 #include "table_brush.h"
 #include "wall_brush.h"
 
+#include <limits>
+#include <typeinfo>
+#include <unordered_map>
+
 Item* Item::Create(uint16_t id, uint16_t subtype /*= 0xFFFF*/) {
 	if (id == 0) {
 		return nullptr;
@@ -37,7 +41,7 @@ Item* Item::Create(uint16_t id, uint16_t subtype /*= 0xFFFF*/) {
 
 	const ItemType &type = g_items.getItemType(id);
 	if (type.id == 0) {
-		return newd Item(id, subtype);
+		return new Item(id, subtype);
 	}
 
 	if (!type.sprite) {
@@ -70,6 +74,8 @@ Item::Item(unsigned short _type, unsigned short _count) :
 	id(_type),
 	subtype(1),
 	selected(false),
+	compact_record(false),
+	references(1),
 	frame(0) {
 	if (hasSubtype()) {
 		subtype = _count;
@@ -80,17 +86,96 @@ Item::~Item() {
 	////
 }
 
+using ItemPool = SharedObjectPool<Item>;
+
+void* Item::operator new(size_t size) {
+	if (size == sizeof(Item)) {
+		return ItemPool::allocate();
+	}
+	return ::operator new(size);
+}
+
+void Item::operator delete(void* memory, size_t size) noexcept {
+	if (size == sizeof(Item)) {
+		ItemPool::deallocate(memory);
+	} else {
+		::operator delete(memory);
+	}
+}
+
+void Item::operator delete(Item* item, std::destroying_delete_t, size_t size) noexcept {
+	if (item->references > 1) {
+		--item->references;
+		return;
+	}
+	item->~Item();
+	Item::operator delete(static_cast<void*>(item), size);
+}
+
+MapPoolStatistics Item::getPoolStatistics() {
+	return ItemPool::getStatistics();
+}
+
 Item* Item::deepCopy() const {
 	Item* copy = Create(id, subtype);
 	if (copy) {
 		copy->selected = selected;
 		if (attributes) {
-			copy->attributes = newd ItemAttributeMap(*attributes);
+			// The copy shares the attribute list until one of the items changes it
+			copy->clearAllAttributes();
+			copy->shareAttributes(*this);
 		}
 	}
 	return copy;
 }
 
+Item* Item::share() noexcept {
+	if (references == std::numeric_limits<uint16_t>::max()) {
+		return nullptr;
+	}
+	++references;
+	return this;
+}
+
+bool Item::matches(const Item &other) const {
+	return typeid(*this) == typeid(other) && id == other.id && subtype == other.subtype && selected == other.selected && hasSameAttributes(other);
+}
+
+namespace {
+	// One table per thread, the loader compacts the items of the areas it decodes on the worker
+	// threads. Every record holds a reference of the table, so it stays shared and is never changed.
+	struct CompactItemTable {
+		std::unordered_map<uint32_t, Item*> records;
+
+		~CompactItemTable() {
+			for (const auto &entry : records) {
+				delete entry.second;
+			}
+		}
+	};
+}
+
+Item* Item::compact(Item* item) {
+	if (!item || item->compact_record || item->selected || typeid(*item) != typeid(Item) || (item->attributes && !item->attributes->empty())) {
+		return item;
+	}
+
+	thread_local CompactItemTable table;
+	Item*&record = table.records[(static_cast<uint32_t>(item->id) << 16) | item->subtype];
+	if (record) {
+		if (Item* shared = record->share()) {
+			delete item;
+			return shared;
+		}
+		// Out of references, the tiles keep the old record and this item takes its place
+		delete record;
+	}
+
+	item->compact_record = true;
+	record = item->share();
+	return item;
+}
+
 Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 	if (old_item == nullptr) {
 		return nullptr;
@@ -149,7 +234,9 @@ Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 
 uint32_t Item::memsize() const {
 	uint32_t mem = sizeof(*this);
-	return mem;
+	mem += getAttributesMemsize();
+	// Split between the tiles sharing it, like the attributes
+	return mem / references;
 }
 
 void Item::setID(uint16_t new_id) {
@@ -158,7 +245,7 @@ void Item::setID(uint16_t new_id) {
 
 void Item::setSubtype(uint16_t _subtype) {
 	subtype = _subtype;
-	setAttribute("subtype", subtype);
+	setAttribute(ItemAttributeKey::Subtype, subtype);
 }
 
 bool Item::hasSubtype() const {
@@ -268,19 +355,19 @@ double Item::getWeight() const {
 }
 
 void Item::setUniqueID(unsigned short n) {
-	setAttribute("uid", n);
+	setAttribute(ItemAttributeKey::UniqueId, n);
 }
 
 void Item::setActionID(unsigned short n) {
-	setAttribute("aid", n);
+	setAttribute(ItemAttributeKey::ActionId, n);
 }
 
 void Item::setText(const std::string &str) {
-	setAttribute("text", str);
+	setAttribute(ItemAttributeKey::Text, str);
 }
 
 void Item::setDescription(const std::string &str) {
-	setAttribute("desc", str);
+	setAttribute(ItemAttributeKey::Description, str);
 }
 
 double Item::getWeight() {
@@ -22,6 +22,9 @@
 #include "iomap_otbm.h"
 // #include "iomap_otmm.h"
 #include "item_attributes.h"
+#include "object_pool.h"
+
+#include <new>
 
 enum ITEMPROPERTY {
 	BLOCKSOLID,
@@ -90,9 +93,38 @@ protected:
 public:
 	virtual ~Item();
 
+	// Plain items, by far the most common kind on a map, are carved out of a shared
+	// slab pool instead of getting one heap block each. Complex items use the heap.
+	static void* operator new(size_t size);
+	static void operator delete(void* memory, size_t size) noexcept;
+	// Deleting an item that is shared (see share) only drops a reference, the last one destroys it
+	static void operator delete(Item* item, std::destroying_delete_t, size_t size) noexcept;
+	static MapPoolStatistics getPoolStatistics();
+
 	// Deep copy thingy
 	virtual Item* deepCopy() const;
 
+	// Tiles kept in the undo history refer to the items of the map that did not change instead of
+	// holding copies (see Tile::shareItems). A shared item must not be changed, change a copy of the
+	// tile or call Tile::unshareItems first.
+	bool isShared() const noexcept {
+		return references > 1;
+	}
+	// Returns this item with one more reference, nullptr if it has run out of references
+	Item* share() noexcept;
+	// True if the item is indistinguishable from the other one, so one can stand in for the other
+	virtual bool matches(const Item &other) const;
+
+	// Plain items (no attributes, contents, selection or other state of their own) are kept as one
+	// shared record per id and subtype, a tile only holds its pointer to it. Like any shared item
+	// the record is never changed: tiles are changed through deepCopy, which gives every item its
+	// own copy again, or Tile::unshareItems.
+	// Returns the record for the item and deletes it, or the item itself if it is not plain.
+	static Item* compact(Item* item);
+	bool isCompact() const noexcept {
+		return compact_record;
+	}
+
 	// Get memory footprint size
 	uint32_t memsize() const;
 
@@ -381,6 +413,9 @@ protected:
 	// Subtype is either fluid type, count, subtype or charges
 	uint16_t subtype;
 	bool selected;
+	// These two fit in the padding after selected
+	bool compact_record;
+	uint16_t references;
 	int frame;
 
 private:
@@ -402,7 +437,7 @@ inline int Item::getCount() const {
 }
 
 inline uint16_t Item::getUniqueID() const {
-	const int32_t* a = getIntegerAttribute("uid");
+	const int32_t* a = getIntegerAttribute(ItemAttributeKey::UniqueId);
 	if (a) {
 		return *a;
 	}
@@ -410,7 +445,7 @@ inline uint16_t Item::getUniqueID() const {
 }
 
 inline uint16_t Item::getActionID() const {
-	const int32_t* a = getIntegerAttribute("aid");
+	const int32_t* a = getIntegerAttribute(ItemAttributeKey::ActionId);
 	if (a) {
 		return *a;
 	}
@@ -418,7 +453,7 @@ inline uint16_t Item::getActionID() const {
 }
 
 inline std::string Item::getText() const {
-	const std::string* a = getStringAttribute("text");
+	const std::string* a = getStringAttribute(ItemAttributeKey::Text);
 	if (a) {
 		return *a;
 	}
@@ -426,7 +461,7 @@ inline std::string Item::getText() const {
 }
 
 inline std::string Item::getDescription() const {
-	const std::string* a = getStringAttribute("desc");
+	const std::string* a = getStringAttribute(ItemAttributeKey::Description);
 	if (a) {
 		return *a;
 	}
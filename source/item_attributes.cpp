@@ -20,64 +20,310 @@
 #include "item_attributes.h"
 #include "filehandle.h"
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+	// Immutable view of the registered keys, readers use it without taking any lock
+	struct AttributeKeySnapshot {
+		std::unordered_map<std::string, ItemAttributeKey> ids;
+		std::vector<const std::string*> names;
+	};
+
+	// Names are stored in a deque so references handed out by getName stay valid
+	struct AttributeKeyTable {
+		// Only taken to register a new key
+		std::mutex mutex;
+		std::deque<std::string> names;
+		// Every insert publishes a new snapshot. The old ones are kept, a reader may still be looking at
+		// them, there are only a few dozen keys and they are never removed.
+		std::vector<std::unique_ptr<const AttributeKeySnapshot>> snapshots;
+		std::atomic<const AttributeKeySnapshot*> current { nullptr };
+
+		AttributeKeyTable() {
+			auto snapshot = std::make_unique<AttributeKeySnapshot>();
+			// Must match the order of the well-known keys in ItemAttributeKey
+			for (const char* name : { "aid", "uid", "text", "desc", "subtype" }) {
+				snapshot->ids.emplace(name, static_cast<ItemAttributeKey>(names.size()));
+				snapshot->names.push_back(&names.emplace_back(name));
+			}
+			publish(std::move(snapshot));
+		}
+
+		const AttributeKeySnapshot &get() const noexcept {
+			return *current.load(std::memory_order_acquire);
+		}
+
+		void publish(std::unique_ptr<AttributeKeySnapshot> snapshot) {
+			current.store(snapshot.get(), std::memory_order_release);
+			snapshots.push_back(std::move(snapshot));
+		}
+	};
+
+	AttributeKeyTable &getAttributeKeyTable() {
+		static AttributeKeyTable table;
+		return table;
+	}
+}
+
+ItemAttributeKey ItemAttributeKeys::intern(const std::string &name) {
+	AttributeKeyTable &table = getAttributeKeyTable();
+	if (ItemAttributeKey key = find(name); key != ItemAttributeKey::Invalid) {
+		return key;
+	}
+
+	std::lock_guard<std::mutex> lock(table.mutex);
+	// Another thread may have registered it meanwhile
+	const AttributeKeySnapshot &current = table.get();
+	auto it = current.ids.find(name);
+	if (it != current.ids.end()) {
+		return it->second;
+	}
+
+	ASSERT(table.names.size() < static_cast<size_t>(ItemAttributeKey::Invalid));
+	ItemAttributeKey key = static_cast<ItemAttributeKey>(table.names.size());
+	auto snapshot = std::make_unique<AttributeKeySnapshot>(current);
+	snapshot->ids.emplace(name, key);
+	snapshot->names.push_back(&table.names.emplace_back(name));
+	table.publish(std::move(snapshot));
+	return key;
+}
+
+ItemAttributeKey ItemAttributeKeys::find(const std::string &name) {
+	const AttributeKeySnapshot &snapshot = getAttributeKeyTable().get();
+	auto it = snapshot.ids.find(name);
+	if (it != snapshot.ids.end()) {
+		return it->second;
+	}
+	return ItemAttributeKey::Invalid;
+}
+
+const std::string &ItemAttributeKeys::getName(ItemAttributeKey key) {
+	return *getAttributeKeyTable().get().names.at(static_cast<size_t>(key));
+}
+
+// Attribute list
+
+namespace {
+	struct AttributeKeyLess {
+		bool operator()(const ItemAttributeList::Entry &entry, ItemAttributeKey key) const noexcept {
+			return entry.first < key;
+		}
+	};
+}
+
+ItemAttribute* ItemAttributeList::find(ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, AttributeKeyLess());
+	if (it != entries.end() && it->first == key) {
+		return &it->second;
+	}
+	return nullptr;
+}
+
+const ItemAttribute* ItemAttributeList::find(ItemAttributeKey key) const {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, AttributeKeyLess());
+	if (it != entries.end() && it->first == key) {
+		return &it->second;
+	}
+	return nullptr;
+}
+
+ItemAttribute &ItemAttributeList::operator[](ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, AttributeKeyLess());
+	if (it == entries.end() || it->first != key) {
+		it = entries.emplace(it, key, ItemAttribute());
+	}
+	return it->second;
+}
+
+void ItemAttributeList::erase(ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, AttributeKeyLess());
+	if (it != entries.end() && it->first == key) {
+		entries.erase(it);
+	}
+}
+
+uint32_t ItemAttributeList::memsize() const {
+	uint32_t mem = sizeof(*this) + entries.capacity() * sizeof(Entry);
+	for (const Entry &entry : entries) {
+		if (const std::string* str = entry.second.getString()) {
+			if (str->capacity() > std::string().capacity()) {
+				mem += str->capacity();
+			}
+		}
+	}
+	return mem;
+}
+
+// Item attributes
+
 ItemAttributes::ItemAttributes() :
 	attributes(nullptr) {
 	////
 }
 
-ItemAttributes::ItemAttributes(const ItemAttributes &o) {
-	if (o.attributes) {
-		attributes = newd ItemAttributeMap(*o.attributes);
+ItemAttributes::ItemAttributes(const ItemAttributes &o) :
+	attributes(nullptr) {
+	shareAttributes(o);
+}
+
+ItemAttributes &ItemAttributes::operator=(const ItemAttributes &o) {
+	if (&o != this) {
+		clearAllAttributes();
+		shareAttributes(o);
 	}
+	return *this;
 }
 
 ItemAttributes::~ItemAttributes() {
 	clearAllAttributes();
 }
 
-void ItemAttributes::createAttributes() {
+void ItemAttributes::shareAttributes(const ItemAttributes &o) {
+	ASSERT(!attributes);
+	if (o.attributes) {
+		o.attributes->references.fetch_add(1, std::memory_order_relaxed);
+		attributes = o.attributes;
+	}
+}
+
+ItemAttributeList &ItemAttributes::editAttributes() {
 	if (!attributes) {
-		attributes = newd ItemAttributeMap;
+		attributes = newd ItemAttributeList;
+	} else if (attributes->isShared()) {
+		// Copy on write, the other owners keep the original
+		ItemAttributeList* copy = newd ItemAttributeList(*attributes);
+		clearAllAttributes();
+		attributes = copy;
 	}
+	return *attributes;
 }
 
 void ItemAttributes::clearAllAttributes() {
-	if (attributes) {
+	if (attributes && attributes->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
 		delete attributes;
 	}
 	attributes = nullptr;
 }
 
+bool ItemAttributes::hasSameAttributes(const ItemAttributes &o) const {
+	if (attributes == o.attributes) {
+		return true;
+	}
+
+	const bool empty = !attributes || attributes->empty();
+	const bool other_empty = !o.attributes || o.attributes->empty();
+	if (empty || other_empty) {
+		return empty == other_empty;
+	}
+	return attributes->entries == o.attributes->entries;
+}
+
+uint32_t ItemAttributes::getAttributesMemsize(bool amortized) const {
+	if (!attributes) {
+		return 0;
+	}
+	if (!amortized) {
+		return attributes->memsize();
+	}
+	return attributes->memsize() / attributes->getReferenceCount();
+}
+
 ItemAttributeMap ItemAttributes::getAttributes() const {
+	ItemAttributeMap map;
 	if (attributes) {
-		return *attributes;
+		for (const auto &entry : *attributes) {
+			map.emplace(ItemAttributeKeys::getName(entry.first), entry.second);
+		}
+	}
+	return map;
+}
+
+void ItemAttributes::setAttribute(ItemAttributeKey key, const ItemAttribute &value) {
+	editAttributes()[key] = value;
+}
+
+void ItemAttributes::setAttribute(ItemAttributeKey key, const std::string &value) {
+	editAttributes()[key].set(value);
+}
+
+void ItemAttributes::setAttribute(ItemAttributeKey key, int32_t value) {
+	editAttributes()[key].set(value);
+}
+
+void ItemAttributes::setAttribute(ItemAttributeKey key, double value) {
+	editAttributes()[key].set(value);
+}
+
+void ItemAttributes::setAttribute(ItemAttributeKey key, bool value) {
+	editAttributes()[key].set(value);
+}
+
+void ItemAttributes::eraseAttribute(ItemAttributeKey key) {
+	if (!attributes || !attributes->find(key)) {
+		return;
 	}
-	return ItemAttributeMap();
+
+	editAttributes().erase(key);
+}
+
+const std::string* ItemAttributes::getStringAttribute(ItemAttributeKey key) const {
+	if (!attributes) {
+		return nullptr;
+	}
+
+	const ItemAttribute* attribute = attributes->find(key);
+	return attribute ? attribute->getString() : nullptr;
+}
+
+const int32_t* ItemAttributes::getIntegerAttribute(ItemAttributeKey key) const {
+	if (!attributes) {
+		return nullptr;
+	}
+
+	const ItemAttribute* attribute = attributes->find(key);
+	return attribute ? attribute->getInteger() : nullptr;
+}
+
+const double* ItemAttributes::getFloatAttribute(ItemAttributeKey key) const {
+	if (!attributes) {
+		return nullptr;
+	}
+
+	const ItemAttribute* attribute = attributes->find(key);
+	return attribute ? attribute->getFloat() : nullptr;
+}
+
+const bool* ItemAttributes::getBooleanAttribute(ItemAttributeKey key) const {
+	if (!attributes) {
+		return nullptr;
+	}
+
+	const ItemAttribute* attribute = attributes->find(key);
+	return attribute ? attribute->getBoolean() : nullptr;
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const ItemAttribute &value) {
-	createAttributes();
-	(*attributes)[key] = value;
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const std::string &value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, int32_t value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, double value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, bool value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::eraseAttribute(const std::string &key) {
@@ -85,10 +331,9 @@ void ItemAttributes::eraseAttribute(const std::string &key) {
 		return;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-
-	if (iter != attributes->end()) {
-		attributes->erase(iter);
+	ItemAttributeKey id = ItemAttributeKeys::find(key);
+	if (id != ItemAttributeKey::Invalid) {
+		eraseAttribute(id);
 	}
 }
 
@@ -97,11 +342,11 @@ const std::string* ItemAttributes::getStringAttribute(const std::string &key) co
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getString();
+	ItemAttributeKey id = ItemAttributeKeys::find(key);
+	if (id == ItemAttributeKey::Invalid) {
+		return nullptr;
 	}
-	return nullptr;
+	return getStringAttribute(id);
 }
 
 const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const {
@@ -109,11 +354,11 @@ const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getInteger();
+	ItemAttributeKey id = ItemAttributeKeys::find(key);
+	if (id == ItemAttributeKey::Invalid) {
+		return nullptr;
 	}
-	return nullptr;
+	return getIntegerAttribute(id);
 }
 
 const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
@@ -121,11 +366,11 @@ const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getFloat();
+	ItemAttributeKey id = ItemAttributeKeys::find(key);
+	if (id == ItemAttributeKey::Invalid) {
+		return nullptr;
 	}
-	return nullptr;
+	return getFloatAttribute(id);
 }
 
 const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
@@ -133,11 +378,11 @@ const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getBoolean();
+	ItemAttributeKey id = ItemAttributeKeys::find(key);
+	if (id == ItemAttributeKey::Invalid) {
+		return nullptr;
 	}
-	return nullptr;
+	return getBooleanAttribute(id);
 }
 
 bool ItemAttributes::hasStringAttribute(const std::string &key) const {
@@ -213,6 +458,25 @@ ItemAttribute &ItemAttribute::operator=(const ItemAttribute &o) {
 	return *this;
 }
 
+bool ItemAttribute::operator==(const ItemAttribute &o) const {
+	if (type != o.type) {
+		return false;
+	}
+
+	if (type == STRING) {
+		return *reinterpret_cast<const std::string*>(&data) == *reinterpret_cast<const std::string*>(&o.data);
+	} else if (type == INTEGER) {
+		return *reinterpret_cast<const int32_t*>(&data) == *reinterpret_cast<const int32_t*>(&o.data);
+	} else if (type == FLOAT) {
+		return *reinterpret_cast<const float*>(&data) == *reinterpret_cast<const float*>(&o.data);
+	} else if (type == DOUBLE) {
+		return *reinterpret_cast<const double*>(&data) == *reinterpret_cast<const double*>(&o.data);
+	} else if (type == BOOLEAN) {
+		return *reinterpret_cast<const bool*>(&data) == *reinterpret_cast<const bool*>(&o.data);
+	}
+	return true;
+}
+
 ItemAttribute::~ItemAttribute() {
 	clear();
 }
@@ -279,7 +543,7 @@ const bool* ItemAttribute::getBoolean() const {
 bool ItemAttributes::unserializeAttributeMap(const IOMap &maphandle, BinaryNode* stream) {
 	uint16_t n;
 	if (stream->getU16(n)) {
-		createAttributes();
+		ItemAttributeList &list = editAttributes();
 
 		std::string key;
 		ItemAttribute attrib;
@@ -291,27 +555,38 @@ bool ItemAttributes::unserializeAttributeMap(const IOMap &maphandle, BinaryNode*
 			if (!attrib.unserialize(maphandle, stream)) {
 				return false;
 			}
-			(*attributes)[key] = attrib;
+			list[ItemAttributeKeys::intern(key)] = attrib;
 		}
 	}
 	return true;
 }
 
 void ItemAttributes::serializeAttributeMap(const IOMap &maphandle, NodeFileWriteHandle &f) const {
+	// Attributes are written ordered by name, the same order the old name keyed map had,
+	// so saved files do not depend on the order keys were interned in
+	std::vector<std::pair<const std::string*, const ItemAttribute*>> sorted;
+	sorted.reserve(attributes->size());
+	for (const auto &entry : *attributes) {
+		sorted.emplace_back(&ItemAttributeKeys::getName(entry.first), &entry.second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+		return *a.first < *b.first;
+	});
+
 	// Maximum of 65535 attributes per item
-	f.addU16(std::min((size_t)0xFFFF, attributes->size()));
+	f.addU16(std::min((size_t)0xFFFF, sorted.size()));
 
-	ItemAttributeMap::const_iterator attribute = attributes->begin();
+	auto attribute = sorted.begin();
 	int i = 0;
-	while (attribute != attributes->end() && i <= 0xFFFF) {
-		const std::string &key = attribute->first;
+	while (attribute != sorted.end() && i <= 0xFFFF) {
+		const std::string &key = *attribute->first;
 		if (key.size() > 0xFFFF) {
 			f.addString(key.substr(0, 65535));
 		} else {
 			f.addString(key);
 		}
 
-		attribute->second.serialize(maphandle, f);
+		attribute->second->serialize(maphandle, f);
 		++attribute, ++i;
 	}
 }
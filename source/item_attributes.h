@@ -18,8 +18,10 @@
 #ifndef RME_ITEM_ATTRIBUTES_H_
 #define RME_ITEM_ATTRIBUTES_H_
 
+#include <atomic>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "filehandle.h"
 
@@ -40,6 +42,8 @@ public:
 	ItemAttribute &operator=(const ItemAttribute &o);
 	~ItemAttribute();
 
+	bool operator==(const ItemAttribute &o) const;
+
 	enum Type {
 		STRING = 1,
 		INTEGER = 2,
@@ -65,15 +69,82 @@ public:
 	const bool* getBoolean() const;
 
 private:
-	char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
+	alignas(std::string) alignas(double) char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
 };
 
 typedef std::map<std::string, ItemAttribute> ItemAttributeMap;
 
+// Attribute names are interned into a global table and items only store the small id
+enum class ItemAttributeKey : uint16_t {
+	// Well-known keys, registered in this order when the table is created
+	ActionId = 0,
+	UniqueId,
+	Text,
+	Description,
+	Subtype,
+
+	Invalid = 0xFFFF
+};
+
+class ItemAttributeKeys {
+public:
+	// Returns the id of the key, registering it if it is not known yet
+	static ItemAttributeKey intern(const std::string &name);
+	// Returns ItemAttributeKey::Invalid if the key has never been registered
+	static ItemAttributeKey find(const std::string &name);
+	static const std::string &getName(ItemAttributeKey key);
+};
+
+// Attributes of one item, kept sorted by key id in a single contiguous block
+// Copies of an item share the list until one of them changes it (see ItemAttributes)
+class ItemAttributeList {
+public:
+	using Entry = std::pair<ItemAttributeKey, ItemAttribute>;
+
+	ItemAttributeList() = default;
+	ItemAttributeList(const ItemAttributeList &other) :
+		entries(other.entries) { }
+	ItemAttributeList &operator=(const ItemAttributeList &) = delete;
+
+	ItemAttribute* find(ItemAttributeKey key);
+	const ItemAttribute* find(ItemAttributeKey key) const;
+	ItemAttribute &operator[](ItemAttributeKey key);
+	void erase(ItemAttributeKey key);
+
+	size_t size() const noexcept {
+		return entries.size();
+	}
+	bool empty() const noexcept {
+		return entries.empty();
+	}
+	std::vector<Entry>::const_iterator begin() const noexcept {
+		return entries.begin();
+	}
+	std::vector<Entry>::const_iterator end() const noexcept {
+		return entries.end();
+	}
+
+	bool isShared() const noexcept {
+		return references.load(std::memory_order_acquire) > 1;
+	}
+	uint32_t getReferenceCount() const noexcept {
+		return references.load(std::memory_order_relaxed);
+	}
+	uint32_t memsize() const;
+
+private:
+	std::vector<Entry> entries;
+	std::atomic<uint32_t> references { 1 };
+
+	friend class ItemAttributes;
+};
+
 class ItemAttributes {
 public:
 	ItemAttributes();
+	// Copies share the attribute list of the original until either side changes it
 	ItemAttributes(const ItemAttributes &i);
+	ItemAttributes &operator=(const ItemAttributes &i);
 	virtual ~ItemAttributes();
 
 	// Save / load
@@ -81,6 +152,21 @@ public:
 	bool unserializeAttributeMap(const IOMap &maphandle, BinaryNode* node);
 
 public:
+	// Fast path, keyed by interned id
+	void setAttribute(ItemAttributeKey key, const ItemAttribute &attr);
+	void setAttribute(ItemAttributeKey key, const std::string &value);
+	void setAttribute(ItemAttributeKey key, int32_t value);
+	void setAttribute(ItemAttributeKey key, double value);
+	void setAttribute(ItemAttributeKey key, bool set);
+
+	const std::string* getStringAttribute(ItemAttributeKey key) const;
+	const int32_t* getIntegerAttribute(ItemAttributeKey key) const;
+	const double* getFloatAttribute(ItemAttributeKey key) const;
+	const bool* getBooleanAttribute(ItemAttributeKey key) const;
+
+	void eraseAttribute(ItemAttributeKey key);
+
+	// String keyed interface, kept for compatibility
 	void setAttribute(const std::string &key, const ItemAttribute &attr);
 	void setAttribute(const std::string &key, const std::string &value);
 	void setAttribute(const std::string &key, int32_t value);
@@ -102,12 +188,23 @@ public:
 	void eraseAttribute(const std::string &key);
 
 	void clearAllAttributes();
+	// True if both have the same attributes, whether or not they share the list
+	bool hasSameAttributes(const ItemAttributes &o) const;
+	// Copy of all attributes keyed by name
 	ItemAttributeMap getAttributes() const;
 
+	// Memory used by the attributes. When amortized, a list shared by several items is split evenly by
+	// its current reference count, an estimate that changes as other items share or release it.
+	// Otherwise the whole list is counted, which counts a shared list once per item.
+	uint32_t getAttributesMemsize(bool amortized = true) const;
+
 protected:
-	ItemAttributeMap* attributes;
+	// Never modified through this pointer while shared, use editAttributes
+	ItemAttributeList* attributes;
 
-	void createAttributes();
+	// Makes the attribute list exclusive to this item, creating it if needed, and returns it
+	ItemAttributeList &editAttributes();
+	void shareAttributes(const ItemAttributes &other);
 };
 
 #endif
@@ -22,6 +22,8 @@
 #include "preferences.h"
 #include "about_window.h"
 #include "minimap_window.h"
+#include "memory_window.h"
+#include "map_statistics.h"
 #include "dat_debug_view.h"
 #include "result_window.h"
 #include "find_item_window.h"
@@ -123,6 +125,8 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(MAP_CLEAN_HOUSE_ITEMS, wxITEM_NORMAL, OnMapCleanHouseItems);
 	MAKE_ACTION(MAP_PROPERTIES, wxITEM_NORMAL, OnMapProperties);
 	MAKE_ACTION(MAP_STATISTICS, wxITEM_NORMAL, OnMapStatistics);
+	MAKE_ACTION(MEMORY_USAGE, wxITEM_NORMAL, OnMemoryUsage);
+	MAKE_ACTION(RENDERING_BENCHMARK, wxITEM_NORMAL, OnRenderingBenchmark);
 
 	MAKE_ACTION(VIEW_TOOLBARS_BRUSHES, wxITEM_CHECK, OnToolbars);
 	MAKE_ACTION(VIEW_TOOLBARS_POSITION, wxITEM_CHECK, OnToolbars);
@@ -392,6 +396,7 @@ void MainMenuBar::Update() {
 	EnableItem(MAP_CLEANUP, is_local);
 	EnableItem(MAP_PROPERTIES, is_local);
 	EnableItem(MAP_STATISTICS, is_local);
+	EnableItem(RENDERING_BENCHMARK, has_map);
 
 	EnableItem(NEW_VIEW, has_map);
 	EnableItem(ZOOM_IN, has_map);
@@ -1764,225 +1769,14 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 	}
 
 	g_gui.CreateLoadBar("Collecting data...");
-
-	Map* map = &g_gui.GetCurrentMap();
-
-	int load_counter = 0;
-
-	uint64_t tile_count = 0;
-	uint64_t detailed_tile_count = 0;
-	uint64_t blocking_tile_count = 0;
-	uint64_t walkable_tile_count = 0;
-	double percent_pathable = 0.0;
-	double percent_detailed = 0.0;
-	uint64_t spawn_monster_count = 0;
-	uint64_t spawn_npc_count = 0;
-	uint64_t monster_count = 0;
-	uint64_t npc_count = 0;
-	double monsters_per_spawn = 0.0;
-	double npcs_per_spawn = 0.0;
-
-	uint64_t item_count = 0;
-	uint64_t loose_item_count = 0;
-	uint64_t depot_count = 0;
-	uint64_t action_item_count = 0;
-	uint64_t unique_item_count = 0;
-	uint64_t container_count = 0; // Only includes containers containing more than 1 item
-
-	int town_count = map->towns.count();
-	int house_count = map->houses.count();
-	std::map<uint32_t, uint32_t> town_sqm_count;
-	const Town* largest_town = nullptr;
-	uint64_t largest_town_size = 0;
-	uint64_t total_house_sqm = 0;
-	const House* largest_house = nullptr;
-	uint64_t largest_house_size = 0;
-	double houses_per_town = 0.0;
-	double sqm_per_house = 0.0;
-	double sqm_per_town = 0.0;
-
-	for (MapIterator mit = map->begin(); mit != map->end(); ++mit) {
-		Tile* tile = (*mit)->get();
-		if (load_counter % 8192 == 0) {
-			g_gui.SetLoadDone((unsigned int)(int64_t(load_counter) * 95ll / int64_t(map->getTileCount())));
-		}
-
-		if (tile->empty()) {
-			continue;
-		}
-
-		tile_count += 1;
-
-		bool is_detailed = false;
-#define ANALYZE_ITEM(_item)                                             \
-	{                                                                   \
-		item_count += 1;                                                \
-		if (!(_item)->isGroundTile() && !(_item)->isBorder()) {         \
-			is_detailed = true;                                         \
-			const ItemType &it = g_items.getItemType((_item)->getID()); \
-			if (it.moveable) {                                          \
-				loose_item_count += 1;                                  \
-			}                                                           \
-			if (it.isDepot()) {                                         \
-				depot_count += 1;                                       \
-			}                                                           \
-			if ((_item)->getActionID() > 0) {                           \
-				action_item_count += 1;                                 \
-			}                                                           \
-			if ((_item)->getUniqueID() > 0) {                           \
-				unique_item_count += 1;                                 \
-			}                                                           \
-			if (Container* c = dynamic_cast<Container*>((_item))) {     \
-				if (c->getVector().size()) {                            \
-					container_count += 1;                               \
-				}                                                       \
-			}                                                           \
-		}                                                               \
-	}
-		if (tile->ground) {
-			ANALYZE_ITEM(tile->ground);
-		}
-
-		for (Item* item : tile->items) {
-			ANALYZE_ITEM(item);
-		}
-#undef ANALYZE_ITEM
-
-		if (tile->spawnMonster) {
-			spawn_monster_count += 1;
-		}
-
-		if (tile->spawnNpc) {
-			spawn_npc_count += 1;
-		}
-
-		monster_count += tile->monsters.size();
-
-		if (tile->npc) {
-			npc_count += 1;
-		}
-
-		if (tile->isBlocking()) {
-			blocking_tile_count += 1;
-		} else {
-			walkable_tile_count += 1;
-		}
-
-		if (is_detailed) {
-			detailed_tile_count += 1;
-		}
-
-		load_counter += 1;
-	}
-
-	monsters_per_spawn = (spawn_monster_count != 0 ? double(monster_count) / double(spawn_monster_count) : -1.0);
-	npcs_per_spawn = (spawn_npc_count != 0 ? double(npc_count) / double(spawn_npc_count) : -1.0);
-	percent_pathable = 100.0 * (tile_count != 0 ? double(walkable_tile_count) / double(tile_count) : -1.0);
-	percent_detailed = 100.0 * (tile_count != 0 ? double(detailed_tile_count) / double(tile_count) : -1.0);
-
-	load_counter = 0;
-	Houses &houses = map->houses;
-	for (HouseMap::const_iterator hit = houses.begin(); hit != houses.end(); ++hit) {
-		const House* house = hit->second;
-
-		if (load_counter % 64) {
-			g_gui.SetLoadDone((unsigned int)(95ll + int64_t(load_counter) * 5ll / int64_t(house_count)));
-		}
-
-		if (house->size() > largest_house_size) {
-			largest_house = house;
-			largest_house_size = house->size();
-		}
-		total_house_sqm += house->size();
-		town_sqm_count[house->townid] += house->size();
-	}
-
-	houses_per_town = (town_count != 0 ? double(house_count) / double(town_count) : -1.0);
-	sqm_per_house = (house_count != 0 ? double(total_house_sqm) / double(house_count) : -1.0);
-	sqm_per_town = (town_count != 0 ? double(total_house_sqm) / double(town_count) : -1.0);
-
-	Towns &towns = map->towns;
-	for (std::map<uint32_t, uint32_t>::iterator town_iter = town_sqm_count.begin();
-		 town_iter != town_sqm_count.end();
-		 ++town_iter) {
-		// No load bar for this, load is non-existant
-		uint32_t town_id = town_iter->first;
-		uint32_t town_sqm = town_iter->second;
-		Town* town = towns.getTown(town_id);
-		if (town && town_sqm > largest_town_size) {
-			largest_town = town;
-			largest_town_size = town_sqm;
-		} else {
-			// Non-existant town!
-		}
-	}
-
+	const std::string report = GetMapStatisticsReport(g_gui.GetCurrentMap(), g_gui.GetCurrentEditor()->getHistoryActions(), [](int32_t progress) {
+		g_gui.SetLoadDone(progress);
+	});
 	g_gui.DestroyLoadBar();
 
-	std::ostringstream os;
-	os.setf(std::ios::fixed, std::ios::floatfield);
-	os.precision(2);
-	os << "Map statistics for the map \"" << map->getMapDescription() << "\"\n";
-	os << "\tTile data:\n";
-	os << "\t\tTotal number of tiles: " << tile_count << "\n";
-	os << "\t\tNumber of pathable tiles: " << walkable_tile_count << "\n";
-	os << "\t\tNumber of unpathable tiles: " << blocking_tile_count << "\n";
-	if (percent_pathable >= 0.0) {
-		os << "\t\tPercent walkable tiles: " << percent_pathable << "%\n";
-	}
-	os << "\t\tDetailed tiles: " << detailed_tile_count << "\n";
-	if (percent_detailed >= 0.0) {
-		os << "\t\tPercent detailed tiles: " << percent_detailed << "%\n";
-	}
-
-	os << "\tItem data:\n";
-	os << "\t\tTotal number of items: " << item_count << "\n";
-	os << "\t\tNumber of moveable tiles: " << loose_item_count << "\n";
-	os << "\t\tNumber of depots: " << depot_count << "\n";
-	os << "\t\tNumber of containers: " << container_count << "\n";
-	os << "\t\tNumber of items with Action ID: " << action_item_count << "\n";
-	os << "\t\tNumber of items with Unique ID: " << unique_item_count << "\n";
-
-	os << "\tMonster data:\n";
-	os << "\t\tTotal monster count: " << monster_count << "\n";
-	os << "\t\tTotal monster spawn count: " << spawn_monster_count << "\n";
-	os << "\t\tTotal npc count: " << npc_count << "\n";
-	os << "\t\tTotal npc spawn count: " << spawn_npc_count << "\n";
-	if (monsters_per_spawn >= 0) {
-		os << "\t\tMean monsters per spawn: " << monsters_per_spawn << "\n";
-	}
-
-	if (npcs_per_spawn >= 0) {
-		os << "\t\tMean npcs per spawn: " << npcs_per_spawn << "\n";
-	}
-
-	os << "\tTown/House data:\n";
-	os << "\t\tTotal number of towns: " << town_count << "\n";
-	os << "\t\tTotal number of houses: " << house_count << "\n";
-	if (houses_per_town >= 0) {
-		os << "\t\tMean houses per town: " << houses_per_town << "\n";
-	}
-	os << "\t\tTotal amount of housetiles: " << total_house_sqm << "\n";
-	if (sqm_per_house >= 0) {
-		os << "\t\tMean tiles per house: " << sqm_per_house << "\n";
-	}
-	if (sqm_per_town >= 0) {
-		os << "\t\tMean tiles per town: " << sqm_per_town << "\n";
-	}
-
-	if (largest_town) {
-		os << "\t\tLargest Town: \"" << largest_town->getName() << "\" (" << largest_town_size << " sqm)\n";
-	}
-	if (largest_house) {
-		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
-	}
-
-	os << "\n";
-	os << "Generated by Canary's Map Editor version " + __RME_VERSION__ + "\n";
-
 	wxDialog* dg = newd wxDialog(frame, wxID_ANY, "Map Statistics", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX);
 	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
-	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(os.str()), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
+	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(report), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
 	text_field->SetMinSize(wxSize(400, 300));
 	topsizer->Add(text_field, wxSizerFlags(5).Expand());
 
@@ -2004,6 +1798,32 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 	}
 }
 
+void MainMenuBar::OnMemoryUsage(wxCommandEvent &WXUNUSED(event)) {
+	MemoryWindow dialog(frame);
+	dialog.ShowModal();
+}
+
+void MainMenuBar::OnRenderingBenchmark(wxCommandEvent &WXUNUSED(event)) {
+	if (!g_gui.IsEditorOpen()) {
+		return;
+	}
+
+	wxBusyCursor busy;
+	const MapCanvas::RenderBenchmark result = g_gui.GetCurrentMapTab()->GetView()->GetCanvas()->BenchmarkRendering(100);
+	const std::string text = fmt::format(
+		"Drawing the current view, {} frames of {} quads\n"
+		"Immediate: {:.2f} ms per frame, {} draw calls\n"
+		"Batched: {:.2f} ms per frame, {} draw calls\n"
+		"Speedup: {:.2f}x",
+		result.frames, result.quads,
+		result.immediate_ms, result.immediate_draw_calls,
+		result.batched_ms, result.batched_draw_calls,
+		result.batched_ms > 0.0 ? result.immediate_ms / result.batched_ms : 0.0
+	);
+	spdlog::info("{}", text);
+	g_gui.PopupDialog("Rendering benchmark", wxstr(text), wxOK);
+}
+
 void MainMenuBar::OnMapCleanup(wxCommandEvent &WXUNUSED(event)) {
 	int ok = g_gui.PopupDialog("Clean map", "Do you want to remove all invalid items from the map?", wxYES | wxNO);
 
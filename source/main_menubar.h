@@ -89,6 +89,8 @@ namespace MenuBar {
 		MAP_CLEAN_HOUSE_ITEMS,
 		MAP_PROPERTIES,
 		MAP_STATISTICS,
+		MEMORY_USAGE,
+		RENDERING_BENCHMARK,
 		VIEW_TOOLBARS_BRUSHES,
 		VIEW_TOOLBARS_POSITION,
 		VIEW_TOOLBARS_SIZES,
@@ -267,6 +269,8 @@ public:
 	void OnMapCleanup(wxCommandEvent &event);
 	void OnMapProperties(wxCommandEvent &event);
 	void OnMapStatistics(wxCommandEvent &event);
+	void OnMemoryUsage(wxCommandEvent &event);
+	void OnRenderingBenchmark(wxCommandEvent &event);
 
 	// View Menu
 	void OnToolbars(wxCommandEvent &event);
@@ -129,7 +129,7 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 
 	// std::ofstream conversions("converted_items.txt");
 
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
+	for (MapIterator miter = beginMutable(); miter != end(); ++miter) {
 		Tile* tile = (*miter)->get();
 		ASSERT(tile);
 
@@ -137,6 +137,8 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			continue;
 		}
 
+		memory.removeTile(tile);
+
 		// id_list try MTM conversion
 		id_list.clear();
 
@@ -239,6 +241,9 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			}
 		}
 
+		tile->compactItems();
+		memory.addTile(tile);
+
 		++tiles_done;
 		if (showdialog && tiles_done % 0x10000 == 0) {
 			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
@@ -259,7 +264,7 @@ void Map::cleanInvalidTiles(bool showdialog) {
 
 	uint64_t tiles_done = 0;
 
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
+	for (MapIterator miter = beginMutable(); miter != end(); ++miter) {
 		Tile* tile = (*miter)->get();
 		ASSERT(tile);
 
@@ -267,6 +272,7 @@ void Map::cleanInvalidTiles(bool showdialog) {
 			continue;
 		}
 
+		memory.removeTile(tile);
 		for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 			if (g_items.isValidID((*item_iter)->getID())) {
 				++item_iter;
@@ -275,6 +281,7 @@ void Map::cleanInvalidTiles(bool showdialog) {
 				item_iter = tile->items.erase(item_iter);
 			}
 		}
+		memory.addTile(tile);
 
 		++tiles_done;
 		if (showdialog && tiles_done % 0x10000 == 0) {
@@ -288,32 +295,35 @@ void Map::cleanInvalidTiles(bool showdialog) {
 }
 
 void Map::cleanDeletedZones(bool showdialog) {
+	// Only the tiles of zones that are no longer registered are visited
+	auto deleted = zones.takeDeletedTileIndexes();
+	if (deleted.empty()) {
+		return;
+	}
+
 	if (showdialog) {
 		g_gui.CreateLoadBar("Removing deleted zones...");
 	}
 
-	uint64_t tiles_done = 0;
-
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
-			continue;
-		}
+	uint64_t tiles_total = 0;
+	for (const auto &[zoneId, index] : deleted) {
+		tiles_total += index.size();
+	}
 
-		for (auto iter = tile->zones.begin(); iter != tile->zones.end();) {
-			if (zones.hasZone(*iter)) {
-				++iter;
-			} else {
-				iter = tile->zones.erase(iter);
+	uint64_t tiles_done = 0;
+	for (const auto &[zoneId, index] : deleted) {
+		index.forEach([&](const Position &position) {
+			if (Tile* tile = getTile(position)) {
+				tile->removeZone(zoneId);
+				// Changed in place, the save cache or the pager would bring the old zones back
+				markTileChanged(position);
 			}
-		}
 
-		++tiles_done;
-		if (showdialog && tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
-		}
+			++tiles_done;
+			if (showdialog && tiles_done % 0x10000 == 0) {
+				g_gui.SetLoadDone(int(tiles_done / double(tiles_total) * 100.0));
+			}
+		});
 	}
 
 	if (showdialog) {
@@ -323,25 +333,30 @@ void Map::cleanDeletedZones(bool showdialog) {
 
 Position Map::getZonePosition(unsigned int zoneId) {
 	Position pos;
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
+	const ZoneTileIndex* index = zones.getTileIndex(zoneId);
+	if (!index) {
+		return pos;
+	}
 
-		if (tile->size() == 0) {
-			continue;
+	bool found = false;
+	index->forEach([&](const Position &position) {
+		if (found) {
+			return;
 		}
 
-		if (tile->zones.find(zoneId) != tile->zones.end()) {
-			pos = tile->getPosition();
-			break;
+		const Tile* tile = getTile(position);
+		if (tile && tile->hasZone(zoneId)) {
+			pos = position;
+			found = true;
 		}
-	}
+	});
 	return pos;
 }
 
 bool Map::doChange() {
 	bool doupdate = !has_changed;
 	has_changed = true;
+	++change_count;
 	return doupdate;
 }
 
@@ -799,6 +814,15 @@ bool Map::exportMinimap(FileName filename, int floor /*= rme::MapGroundLayer*/,
 	return true;
 }
 
+void Map::updateZones(const Position &position, Tile* old_tile, Tile* new_tile) {
+	if (old_tile && old_tile->hasZone()) {
+		zones.removeTileZones(position, old_tile->zones);
+	}
+	if (new_tile && new_tile->hasZone()) {
+		zones.addTileZones(position, new_tile->zones);
+	}
+}
+
 void Map::updateUniqueIds(Tile* old_tile, Tile* new_tile) {
 	if (old_tile && old_tile->hasUniqueItem()) {
 		if (old_tile->ground) {
@@ -862,7 +886,7 @@ int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly) {
 	int64_t done = 0;
 	int64_t removed = 0;
 
-	MapIterator it = map.begin();
+	MapIterator it = map.beginMutable();
 	MapIterator end = map.end();
 
 	while (it != end) {
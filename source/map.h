@@ -28,6 +28,7 @@
 #include "zones.h"
 #include "templates.h"
 #include "spawn_npc.h"
+#include "thread_pool.h"
 
 class Map : public BaseMap {
 public:
@@ -58,6 +59,10 @@ public:
 	bool doChange();
 	// Clears any changes
 	bool clearChanges();
+	// Counts every change made, to tell whether the map changed while a snapshot of it was saved
+	uint64_t getChangeCount() const noexcept {
+		return change_count;
+	}
 
 	// Errors/warnings
 	bool hasWarnings() const {
@@ -183,10 +188,12 @@ public:
 
 protected:
 	void updateUniqueIds(Tile* old_tile, Tile* new_tile) override;
+	void updateZones(const Position &position, Tile* old_tile, Tile* new_tile) override;
 	void addUniqueId(uint16_t uid);
 	void removeUniqueId(uint16_t uid);
 
 	bool has_changed; // If the map has changed
+	uint64_t change_count = 0;
 	bool unnamed; // If the map has yet to receive a name
 
 	friend class IOMapOTBM;
@@ -201,6 +208,7 @@ private:
 	std::vector<uint16_t> uniqueIds;
 };
 
+// The foreach walks only read the tiles, changes go through actions or the remove walks below
 template <typename ForeachType>
 inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles) {
 	MapIterator tileiter = map.begin();
@@ -261,9 +269,73 @@ inline void foreach_TileOnMap(Map &map, ForeachType &foreach) {
 	}
 }
 
+// Parallel traversal
+// The map is split into disjoint ranges of leaves (4x4 columns of tiles on all floors) which run on the
+// thread pool. Visitors may read anything and may modify the tiles of the leaf they are given, but must
+// not add or remove tiles (setTile, swapTile, createTile) since that updates shared map state.
+
+// Number of leaves handed to a thread at a time
+constexpr size_t ParallelLeafGrain = 64;
+
+// Calls visitor(leaf, worker) for every leaf of the map, worker is in [0, ThreadPool::getThreadCount())
+template <typename LeafVisitor>
+inline void parallel_foreach_LeafOnMap(BaseMap &map, LeafVisitor &&visitor, const ThreadPool::ProgressFunction &progress = nullptr) {
+	const std::vector<QTreeNode*> leaves = map.getLeaves();
+	ThreadPool::getInstance().parallelFor(
+		leaves.size(), ParallelLeafGrain, [&](size_t begin, size_t end, size_t worker) {
+			for (size_t i = begin; i < end; ++i) {
+				visitor(leaves[i], worker);
+			}
+		},
+		progress
+	);
+}
+
+// Calls visitor(tile, worker) for every tile of the map
+template <typename TileVisitor>
+inline void parallel_foreach_TileOnMap(BaseMap &map, TileVisitor &&visitor, const ThreadPool::ProgressFunction &progress = nullptr) {
+	parallel_foreach_LeafOnMap(
+		map, [&](QTreeNode* leaf, size_t worker) {
+			Floor** floors = leaf->getFloors();
+			for (int z = 0; z < rme::MapLayers; ++z) {
+				if (Floor* floor = floors[z]) {
+					for (TileLocation &location : floor->locs) {
+						if (Tile* tile = location.get()) {
+							visitor(tile, worker);
+						}
+					}
+				}
+			}
+		},
+		progress
+	);
+}
+
+// Folds every tile into one Result per thread with visitor(result, tile), then merges the per thread
+// results into the first one with merge(into, from) on the calling thread
+template <typename Result, typename TileVisitor, typename Merge>
+inline Result parallel_reduce_TileOnMap(BaseMap &map, const Result &initial, TileVisitor &&visitor, Merge &&merge, const ThreadPool::ProgressFunction &progress = nullptr) {
+	// Padded so threads do not share cache lines
+	struct alignas(64) Slot {
+		Result value;
+	};
+	std::vector<Slot> results(ThreadPool::getInstance().getThreadCount(), Slot { initial });
+	parallel_foreach_TileOnMap(
+		map, [&](Tile* tile, size_t worker) {
+			visitor(results[worker].value, tile);
+		},
+		progress
+	);
+
+	for (size_t i = 1; i < results.size(); ++i) {
+		merge(results[0].value, results[i].value);
+	}
+	return std::move(results[0].value);
+}
+
 template <typename RemoveIfType>
 inline long long remove_if_TileOnMap(Map &map, RemoveIfType &remove_if) {
-	MapIterator tileiter = map.begin();
+	MapIterator tileiter = map.beginMutable();
 	MapIterator end = map.end();
 	long long done = 0;
 	long long removed = 0;
@@ -287,7 +359,7 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 	int64_t done = 0;
 	int64_t removed = 0;
 
-	MapIterator it = map.begin();
+	MapIterator it = map.beginMutable();
 	MapIterator end = map.end();
 
 	while (it != end) {
@@ -298,6 +370,7 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 			continue;
 		}
 
+		map.memory.removeTile(tile);
 		if (tile->ground) {
 			if (condition(map, tile->ground, removed, done)) {
 				delete tile->ground;
@@ -316,6 +389,7 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 				++iit;
 			}
 		}
+		map.memory.addTile(tile);
 		++it;
 	}
 	return removed;
@@ -329,7 +403,7 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 	int64_t done = 0;
 	int64_t removed = 0;
 
-	MapIterator it = map.begin();
+	MapIterator it = map.beginMutable();
 	MapIterator end = map.end();
 
 	while (it != end) {
@@ -340,6 +414,7 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 			continue;
 		}
 
+		map.memory.removeTile(tile);
 		if (tile->ground) {
 			if (condition(map, tile, tile->ground, removed, done)) {
 				delete tile->ground;
@@ -358,6 +433,7 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 				++iit;
 			}
 		}
+		map.memory.addTile(tile);
 		++it;
 	}
 	return removed;
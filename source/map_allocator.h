@@ -20,9 +20,21 @@
 
 #include "tile.h"
 #include "map_region.h"
+#include "object_pool.h"
 
 class BaseMap;
 
+// Tiles created outside of a map (brushes, copy buffer, doodad preview) come from this
+// process wide pool through Tile::operator new. Tiles of a map come from its MapAllocator.
+// Both are SlabPools, so a plain delete returns any tile to the slab it was carved from.
+using TilePool = SharedObjectPool<Tile>;
+
+struct MapAllocatorStatistics {
+	MapPoolStatistics tiles;
+	MapPoolStatistics floors;
+	MapPoolStatistics nodes;
+};
+
 class MapAllocator {
 
 public:
@@ -38,9 +50,12 @@ public:
 		freeTile(t);
 	}
 
-	//
+	// Safe to call from several threads at once (see IOMapOTBM::decodeTileArea)
 	Tile* allocateTile(TileLocation* location) {
-		return newd Tile(*location);
+		return new (tiles.allocate()) Tile(*location);
+	}
+	Tile* allocateTile(int x, int y, int z) {
+		return new (tiles.allocate()) Tile(x, y, z);
 	}
 	void freeTile(Tile* t) {
 		delete t;
@@ -48,19 +63,41 @@ public:
 
 	//
 	Floor* allocateFloor(int x, int y, int z) {
-		return newd Floor(x, y, z);
+		return floors.create(x, y, z);
 	}
 	void freeFloor(Floor* f) {
-		delete f;
+		floors.destroy(f);
 	}
 
 	//
 	QTreeNode* allocateNode(BaseMap &map) {
-		return newd QTreeNode(map);
+		return nodes.create(map);
 	}
 	void freeNode(QTreeNode* qt) {
-		delete qt;
+		nodes.destroy(qt);
 	}
+
+	// Hands every floor and node slab back at once, the caller must have
+	// destroyed the objects first (see QTreeNode::releaseChildren).
+	// Tile slabs still in use (tiles kept by undo actions) are freed with their last tile.
+	void releasePools() noexcept {
+		tiles.release();
+		floors.release();
+		nodes.release();
+	}
+
+	MapAllocatorStatistics getStatistics() const {
+		MapAllocatorStatistics stats;
+		stats.tiles = tiles.getStatistics();
+		stats.floors = floors.getStatistics();
+		stats.nodes = nodes.getStatistics();
+		return stats;
+	}
+
+private:
+	ShardedSlabPool<Tile> tiles;
+	MapObjectPool<Floor, 1024> floors;
+	MapObjectPool<QTreeNode, 1024> nodes;
 };
 
 #endif
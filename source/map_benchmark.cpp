@@ -0,0 +1,608 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_benchmark.h"
+#include "map.h"
+#include "iomap_otbm.h"
+#include "otbm_index.h"
+#include "monster.h"
+#include "settings.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <numeric>
+#include <zlib.h>
+
+TileLookupBenchmarkResult BenchmarkTileLookup(BaseMap &map, uint64_t lookups, uint32_t seed) {
+	TileLookupBenchmarkResult result;
+	result.tiles = map.size();
+	result.lookups = lookups;
+	result.directory_bytes = map.getLeafDirectory().memsize();
+
+	// Find the area covered by the map, positions are drawn from a slightly larger box so some of them miss
+	int max_x = 0, max_y = 0;
+	for (MapIterator it = map.begin(); it != map.end(); ++it) {
+		max_x = std::max(max_x, (*it)->getX());
+		max_y = std::max(max_y, (*it)->getY());
+	}
+
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<int> x_distribution(0, max_x + max_x / 8 + 4);
+	std::uniform_int_distribution<int> y_distribution(0, max_y + max_y / 8 + 4);
+	std::uniform_int_distribution<int> z_distribution(rme::MapGroundLayer - 1, rme::MapGroundLayer + 1);
+
+	std::vector<Position> positions;
+	positions.reserve(lookups);
+	for (uint64_t i = 0; i < lookups; ++i) {
+		positions.emplace_back(x_distribution(generator), y_distribution(generator), z_distribution(generator));
+	}
+
+	using Clock = std::chrono::steady_clock;
+	std::vector<TileLocation*> tree_results(positions.size());
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < positions.size(); ++i) {
+		const Position &pos = positions[i];
+		TileLocation* location = nullptr;
+		if (QTreeNode* leaf = map.getLeafFromTree(pos.x, pos.y)) {
+			location = leaf->getTile(pos.x, pos.y, pos.z);
+		}
+		tree_results[i] = location;
+	}
+	result.tree_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (size_t i = 0; i < positions.size(); ++i) {
+		const Position &pos = positions[i];
+		if (map.getTileL(pos.x, pos.y, pos.z) != tree_results[i]) {
+			++result.mismatches;
+		}
+	}
+	result.directory_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	return result;
+}
+
+std::string FormatTileLookupBenchmark(const TileLookupBenchmarkResult &result) {
+	const auto perLookup = [&result](double ms) {
+		return result.lookups == 0 ? 0.0 : ms * 1e6 / double(result.lookups);
+	};
+
+	return fmt::format(
+		"Tile lookup benchmark: {} tiles, {} lookups\n"
+		"\tHextree descent: {:.2f} ms ({:.1f} ns/lookup)\n"
+		"\tLeaf directory: {:.2f} ms ({:.1f} ns/lookup, {} KB)\n"
+		"\tSpeedup: {:.2f}x, mismatches: {}",
+		result.tiles, result.lookups,
+		result.tree_ms, perLookup(result.tree_ms),
+		result.directory_ms, perLookup(result.directory_ms), result.directory_bytes / 1024,
+		result.directory_ms > 0.0 ? result.tree_ms / result.directory_ms : 0.0, result.mismatches
+	);
+}
+
+namespace {
+	uint64_t getTraversalChecksum(const Tile* tile) {
+		const Position &pos = tile->getPosition();
+		return (uint64_t(pos.x) * 73856093u) ^ (uint64_t(pos.y) * 19349663u) ^ (uint64_t(pos.z) * 83492791u);
+	}
+
+	bool benchmarkFilesEqual(const std::string &first, const std::string &second) {
+		std::ifstream a(first, std::ios::binary), b(second, std::ios::binary);
+		if (!a || !b) {
+			return false;
+		}
+
+		std::vector<char> a_buffer(1 << 16), b_buffer(1 << 16);
+		while (a && b) {
+			a.read(a_buffer.data(), a_buffer.size());
+			b.read(b_buffer.data(), b_buffer.size());
+			if (a.gcount() != b.gcount() || !std::equal(a_buffer.begin(), a_buffer.begin() + a.gcount(), b_buffer.begin())) {
+				return false;
+			}
+		}
+		return a.eof() && b.eof();
+	}
+
+	// The tile area nodes of an OTBM file, as they are in the file
+	bool readBenchmarkTileAreas(const std::string &filename, std::vector<uint8_t> &areas) {
+		MappedNodeFileReadHandle handle(filename, StringVector(1, "OTBM"));
+		if (!handle.isOk()) {
+			return false;
+		}
+		std::vector<uint8_t> skeleton;
+		OTBMAreaScanner scanner(skeleton);
+		scanner.feed(handle.getData(), handle.getDataSize(), 0);
+		if (!scanner.isComplete()) {
+			return false;
+		}
+		for (const OTBMAreaScanner::Area &area : scanner.getAreas()) {
+			areas.insert(areas.end(), handle.getData() + area.offset, handle.getData() + area.offset + area.size);
+		}
+		return true;
+	}
+
+	// The golden file is gzipped, zlib reads an uncompressed one as it is
+	bool readBenchmarkGolden(const std::string &golden, std::vector<uint8_t> &bytes) {
+		gzFile file = gzopen(golden.c_str(), "rb");
+		if (!file) {
+			return false;
+		}
+		uint8_t buffer[1 << 16];
+		int read;
+		while ((read = gzread(file, buffer, sizeof(buffer))) > 0) {
+			bytes.insert(bytes.end(), buffer, buffer + read);
+		}
+		return gzclose(file) == Z_OK && read == 0 && !bytes.empty();
+	}
+
+	bool benchmarkMatchesGolden(const std::string &filename, const std::string &golden) {
+		std::vector<uint8_t> expected;
+		if (!readBenchmarkGolden(golden, expected)) {
+			spdlog::error("Could not read {}", golden);
+			return false;
+		}
+
+		std::vector<uint8_t> areas;
+		if (!readBenchmarkTileAreas(filename, areas)) {
+			spdlog::error("Could not read the tile areas of {}", filename);
+			return false;
+		}
+		if (areas != expected) {
+			const auto mismatch = std::mismatch(areas.begin(), areas.end(), expected.begin(), expected.end());
+			spdlog::error("The tile areas of {} differ from {} at byte {} ({} and {} bytes)", filename, golden, mismatch.first - areas.begin(), areas.size(), expected.size());
+			return false;
+		}
+		return true;
+	}
+
+	// Sets a preference for the length of the benchmark and puts the user's value back afterwards
+	class ScopedBenchmarkSetting {
+	public:
+		ScopedBenchmarkSetting(uint32_t key, int value) :
+			key(key), previous(g_settings.getInteger(key)) {
+			g_settings.setInteger(key, value);
+		}
+		~ScopedBenchmarkSetting() {
+			g_settings.setInteger(key, previous);
+		}
+
+		ScopedBenchmarkSetting(const ScopedBenchmarkSetting &) = delete;
+		ScopedBenchmarkSetting &operator=(const ScopedBenchmarkSetting &) = delete;
+
+	private:
+		uint32_t key;
+		int previous;
+	};
+
+	// Tiles and items inside the box, on the floors from.z to to.z
+	std::pair<uint64_t, uint64_t> countBenchmarkRegion(Map &map, const Position &from, const Position &to) {
+		uint64_t tiles = 0, items = 0;
+		for (int z = from.z; z <= to.z; ++z) {
+			for (int x = from.x; x <= to.x; ++x) {
+				for (int y = from.y; y <= to.y; ++y) {
+					if (const Tile* tile = map.getTile(x, y, z)) {
+						++tiles;
+						items += tile->items.size() + (tile->ground ? 1 : 0);
+					}
+				}
+			}
+		}
+		return { tiles, items };
+	}
+
+	// Writes the index of the file like a save with SAVE_OTBM_INDEX does, checks that it is accepted
+	// and reads the box through it
+	bool benchmarkRegionLoad(Map &map, const FileName &filename, const Position &from, const Position &to, MapBenchmarkResult &result) {
+		const std::string path = nstr(filename.GetFullPath());
+		{
+			MappedNodeFileReadHandle handle(path, StringVector(1, "OTBM"));
+			OTBMIndex index;
+			index.feed(handle.getData(), handle.getDataSize());
+			if (!handle.isOk() || !index.finish() || !index.save(path) || !index.load(path, handle.getDataSize())) {
+				spdlog::error("Could not index {}", path);
+				return false;
+			}
+		}
+
+		using Clock = std::chrono::steady_clock;
+		const auto start = Clock::now();
+		Map region;
+		IOMapOTBM loader(region.getVersion());
+		if (!loader.loadMapRegion(region, filename, from, to)) {
+			spdlog::error("Could not read a region of {}: {}", path, nstr(loader.getError()));
+			return false;
+		}
+		result.region_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		const std::pair<uint64_t, uint64_t> expected = countBenchmarkRegion(map, from, to);
+		const std::pair<uint64_t, uint64_t> found = countBenchmarkRegion(region, from, to);
+		result.region_tiles = found.first;
+		return found == expected && region.towns.count() == map.towns.count();
+	}
+
+	uint64_t countBenchmarkZoneTiles(Map &map, unsigned int zone) {
+		return parallel_reduce_TileOnMap(
+			map, uint64_t(0), [zone](uint64_t &count, const Tile* tile) { count += tile->hasZone(zone) ? 1 : 0; }, [](uint64_t &into, uint64_t from) { into += from; }
+		);
+	}
+
+	// Deletes a zone, saves the map to filename and checks that none of the tiles of the loaded file has it
+	bool benchmarkZoneDeletion(Map &map, const FileName &filename, unsigned int zone, uint64_t &zone_tiles) {
+		zone_tiles = countBenchmarkZoneTiles(map, zone);
+		map.zones.removeZone(fmt::format("Zone {}", zone));
+		map.cleanDeletedZones(false);
+
+		IOMapOTBM saver(map.getVersion());
+		if (!saver.saveMap(map, filename)) {
+			spdlog::error("Could not save {}: {}", nstr(filename.GetFullPath()), nstr(saver.getError()));
+			return false;
+		}
+
+		Map loaded;
+		IOMapOTBM loader(loaded.getVersion());
+		if (!loader.loadMap(loaded, filename)) {
+			spdlog::error("Could not load {}: {}", nstr(filename.GetFullPath()), nstr(loader.getError()));
+			return false;
+		}
+		return countBenchmarkZoneTiles(loaded, zone) == 0;
+	}
+}
+
+TraversalBenchmarkResult BenchmarkTraversal(BaseMap &map) {
+	TraversalBenchmarkResult result;
+	result.tiles = map.size();
+	result.threads = ThreadPool::getInstance().getThreadCount();
+
+	using Clock = std::chrono::steady_clock;
+
+	auto start = Clock::now();
+	for (MapIterator it = map.begin(); it != map.end(); ++it) {
+		result.serial_checksum += getTraversalChecksum((*it)->get());
+	}
+	result.serial_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	result.parallel_checksum = parallel_reduce_TileOnMap(
+		map, uint64_t(0), [](uint64_t &checksum, const Tile* tile) { checksum += getTraversalChecksum(tile); }, [](uint64_t &into, uint64_t from) { into += from; }
+	);
+	result.parallel_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	return result;
+}
+
+std::string FormatTraversalBenchmark(const TraversalBenchmarkResult &result) {
+	return fmt::format(
+		"Traversal benchmark: {} tiles, {} threads\n"
+		"\tMapIterator: {:.2f} ms\n"
+		"\tParallel leaves: {:.2f} ms\n"
+		"\tSpeedup: {:.2f}x, checksums {}",
+		result.tiles, result.threads,
+		result.serial_ms,
+		result.parallel_ms,
+		result.parallel_ms > 0.0 ? result.serial_ms / result.parallel_ms : 0.0,
+		result.serial_checksum == result.parallel_checksum ? "match" : "DIFFER"
+	);
+}
+
+void GenerateBenchmarkMap(Map &map, const BenchmarkMapOptions &options) {
+	// Only the raw numbers of the generator are used, the standard fixes those but leaves the
+	// distributions to the library. The golden file of the serial writer depends on it.
+	std::mt19937 generator(options.seed);
+	const auto chance = [](std::mt19937 &from) {
+		return from() / 4294967296.0;
+	};
+	const auto below = [&generator](uint32_t bound) {
+		return static_cast<int>(generator() % bound);
+	};
+
+	map.setWidth(options.width);
+	map.setHeight(options.height);
+	map.setMapDescription("Synthetic benchmark map");
+	map.setHouseFilename("benchmark-house.xml");
+	map.setSpawnMonsterFilename("benchmark-monster.xml");
+	map.setSpawnNpcFilename("benchmark-npc.xml");
+	map.setZoneFilename("benchmark-zones.xml");
+
+	// Zones draw from a generator of their own, so the rest of the map does not depend on them
+	std::mt19937 zone_generator(options.seed + 1);
+	for (int i = 1; i <= options.zones; ++i) {
+		map.zones.addZone(fmt::format("Zone {}", i), i);
+	}
+
+	const int width = map.getWidth();
+	const int height = map.getHeight();
+	const int last_floor = std::min(rme::MapGroundLayer + std::max(options.floors, 1), rme::MapLayers) - 1;
+	const int whole_items = int(options.item_density);
+	const double extra_item = options.item_density - whole_items;
+
+	uint16_t next_unique_id = 1000;
+	const auto addItem = [&](Tile* tile, uint16_t id) {
+		Item* item = Item::Create(id);
+		if (chance(generator) < options.attribute_ratio) {
+			switch (generator() % 3) {
+				case 0:
+					item->setActionID(100 + below(9900));
+					break;
+				case 1:
+					if (next_unique_id < 0xFFFF) {
+						item->setUniqueID(next_unique_id++);
+					}
+					break;
+				default:
+					item->setText(fmt::format("Benchmark text {}", generator() % 10000));
+					break;
+			}
+		}
+		tile->addItem(item);
+	};
+
+	for (int z = rme::MapGroundLayer; z <= last_floor; ++z) {
+		for (int x = 0; x < width; ++x) {
+			for (int y = 0; y < height; ++y) {
+				Tile* tile = map.allocator(map.createTileL(x, y, z));
+				addItem(tile, 100 + below(64));
+
+				const int items = whole_items + (chance(generator) < extra_item ? 1 : 0);
+				for (int i = 0; i < items; ++i) {
+					addItem(tile, 1000 + below(1000));
+				}
+				if (chance(generator) < 0.05) {
+					tile->setMapFlags(TILESTATE_PROTECTIONZONE);
+				}
+				if (options.zones > 0 && chance(zone_generator) < options.zone_ratio) {
+					tile->addZone(1 + zone_generator() % options.zones);
+				}
+				map.setTile(x, y, z, tile);
+			}
+		}
+	}
+
+	// Drawn one after the other, the arguments of a call are evaluated in any order
+	const auto randomPosition = [&]() {
+		const int x = below(width);
+		const int y = below(height);
+		return Position(x, y, rme::MapGroundLayer);
+	};
+
+	for (int i = 1; i <= options.towns; ++i) {
+		Town* town = newd Town(i);
+		town->setName(fmt::format("Town {}", i));
+		town->setTemplePosition(randomPosition());
+		map.towns.addTown(town);
+	}
+
+	// Every house gets a block of the ground floor of its own, so that no two houses share a tile
+	constexpr int HouseBlock = 8;
+	const int blocks_x = width / HouseBlock;
+	const int blocks_y = height / HouseBlock;
+	std::vector<int> blocks(size_t(blocks_x) * blocks_y);
+	std::iota(blocks.begin(), blocks.end(), 0);
+	for (size_t i = blocks.size(); i > 1; --i) {
+		std::swap(blocks[i - 1], blocks[below(i)]);
+	}
+
+	const size_t houses = std::min<size_t>(std::max(options.houses, 0), blocks.size());
+	for (size_t i = 0; i < houses; ++i) {
+		const int base_x = (blocks[i] % blocks_x) * HouseBlock;
+		const int base_y = (blocks[i] / blocks_x) * HouseBlock;
+
+		House* house = newd House(map);
+		house->id = i + 1;
+		house->name = fmt::format("House {}", house->id);
+		house->rent = 100 * (1 + generator() % 50);
+		house->townid = options.towns > 0 ? 1 + generator() % options.towns : 0;
+		map.houses.addHouse(house);
+
+		const int house_width = 2 + below(HouseBlock - 3);
+		const int house_height = 2 + below(HouseBlock - 3);
+		for (int x = base_x; x < base_x + house_width; ++x) {
+			for (int y = base_y; y < base_y + house_height; ++y) {
+				if (Tile* tile = map.getTile(x, y, rme::MapGroundLayer)) {
+					house->addTile(tile);
+				}
+			}
+		}
+		house->setExit(Position(base_x + house_width / 2, base_y + house_height, rme::MapGroundLayer));
+	}
+
+	static const char* const monster_names[] = { "Rat", "Cave Rat", "Troll", "Orc", "Dragon" };
+	for (int i = 0; i < options.spawns; ++i) {
+		Tile* tile = map.getTile(randomPosition());
+		if (!tile || tile->spawnMonster) {
+			continue;
+		}
+
+		tile->spawnMonster = newd SpawnMonster(3);
+		map.addSpawnMonster(tile);
+
+		const int monsters = 1 + generator() % 3;
+		for (int j = 0; j < monsters; ++j) {
+			const std::string name = monster_names[generator() % std::size(monster_names)];
+			Tile* monster_tile = map.getTile(tile->getX() + j, tile->getY(), rme::MapGroundLayer);
+			if (monster_tile && !monster_tile->isMonsterRepeated(name)) {
+				Monster* monster = newd Monster(name);
+				monster->setSpawnMonsterTime(60);
+				monster_tile->monsters.push_back(monster);
+			}
+		}
+	}
+}
+
+MapBenchmarkResult RunMapBenchmark(const BenchmarkMapOptions &options, const std::string &directory, uint64_t lookups, const std::string &golden) {
+	using Clock = std::chrono::steady_clock;
+	const auto elapsed = [](Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+
+	MapBenchmarkResult result;
+	result.options = options;
+	result.threads = ThreadPool::getInstance().getThreadCount();
+
+	// The zone deletion round trip goes through the save cache, which is off by default
+	const ScopedBenchmarkSetting incremental_save(Config::INCREMENTAL_SAVE, 1);
+
+	const FileName filename(wxstr(directory), "benchmark.otbm");
+	const FileName serial_filename(wxstr(directory), "benchmark-serial.otbm");
+	const FileName resave_filename(wxstr(directory), "benchmark-resave.otbm");
+
+	{
+		Map map;
+		auto start = Clock::now();
+		GenerateBenchmarkMap(map, options);
+		result.generate_ms = elapsed(start);
+		result.tiles = map.size();
+		result.items = map.memory.getItemCount();
+
+		start = Clock::now();
+		IOMapOTBM saver(map.getVersion());
+		if (!saver.saveMap(map, filename)) {
+			spdlog::error("Could not save {}: {}", nstr(filename.GetFullPath()), nstr(saver.getError()));
+			return result;
+		}
+		result.save_ms = elapsed(start);
+
+		start = Clock::now();
+		IOMapOTBM serial_saver(map.getVersion());
+		serial_saver.setSerialTileAreas(true);
+		if (!serial_saver.saveMap(map, serial_filename)) {
+			spdlog::error("Could not save {}: {}", nstr(serial_filename.GetFullPath()), nstr(serial_saver.getError()));
+			return result;
+		}
+		result.serial_save_ms = elapsed(start);
+	}
+	result.file_bytes = filename.GetSize().GetValue();
+	result.matches_serial = benchmarkFilesEqual(nstr(filename.GetFullPath()), nstr(serial_filename.GetFullPath()));
+	if (!golden.empty()) {
+		result.golden_checked = true;
+		result.matches_golden = benchmarkMatchesGolden(nstr(serial_filename.GetFullPath()), golden);
+	}
+
+	Map map;
+	auto start = Clock::now();
+	IOMapOTBM loader(map.getVersion());
+	result.loaded = loader.loadMap(map, filename);
+	result.load_ms = elapsed(start);
+	if (!result.loaded) {
+		spdlog::error("Could not load {}: {}", nstr(filename.GetFullPath()), nstr(loader.getError()));
+		return result;
+	}
+
+	const MapAllocatorStatistics allocator = map.allocator.getStatistics();
+	result.memory_bytes = allocator.floors.reservedBytes() + allocator.nodes.reservedBytes() + map.getLeafDirectory().memsize();
+	result.memory_bytes += map.memory.getTileBytes() + map.memory.getItemBytes() + map.memory.getAttributeBytes();
+
+	const Position region_from(options.width / 4, options.height / 4, rme::MapGroundLayer);
+	const Position region_to(options.width / 2 - 1, options.height / 2 - 1, rme::MapMaxLayer);
+	result.region_matches = benchmarkRegionLoad(map, filename, region_from, region_to, result);
+
+	// Encode every tile again rather than copying the bytes the load left in the cache
+	map.save_cache.clear();
+	start = Clock::now();
+	IOMapOTBM resaver(map.getVersion());
+	const bool resaved = resaver.saveMap(map, resave_filename);
+	result.resave_ms = elapsed(start);
+	result.round_trip_identical = resaved && benchmarkFilesEqual(nstr(filename.GetFullPath()), nstr(resave_filename.GetFullPath()));
+
+	// Deleting a zone changes its tiles in place, the columns the resave left in the save cache must not
+	// bring it back. The lookups and the traversal below only read, so they leave the cache as it is.
+	result.deleted_zone_gone = benchmarkZoneDeletion(map, FileName(wxstr(directory), "benchmark-zone-deleted.otbm"), 1, result.deleted_zone_tiles);
+
+	result.lookup = BenchmarkTileLookup(map, lookups, options.seed);
+	result.traversal = BenchmarkTraversal(map);
+
+	return result;
+}
+
+nlohmann::json MapBenchmarkResult::toJson() const {
+	return {
+		{ "version", __RME_VERSION__ },
+		{ "options", {
+			{ "width", options.width },
+			{ "height", options.height },
+			{ "floors", options.floors },
+			{ "item_density", options.item_density },
+			{ "attribute_ratio", options.attribute_ratio },
+			{ "towns", options.towns },
+			{ "houses", options.houses },
+			{ "spawns", options.spawns },
+			{ "zones", options.zones },
+			{ "zone_ratio", options.zone_ratio },
+			{ "seed", options.seed },
+		} },
+		{ "tiles", tiles },
+		{ "items", items },
+		{ "threads", threads },
+		{ "generate_ms", generate_ms },
+		{ "save_ms", save_ms },
+		{ "serial_save_ms", serial_save_ms },
+		{ "load_ms", load_ms },
+		{ "resave_ms", resave_ms },
+		{ "file_bytes", file_bytes },
+		{ "loaded", loaded },
+		{ "matches_serial", matches_serial },
+		{ "matches_golden", golden_checked ? nlohmann::json(matches_golden) : nlohmann::json() },
+		{ "round_trip_identical", round_trip_identical },
+		{ "memory_bytes", memory_bytes },
+		{ "region_ms", region_ms },
+		{ "region_tiles", region_tiles },
+		{ "region_matches", region_matches },
+		{ "deleted_zone_tiles", deleted_zone_tiles },
+		{ "deleted_zone_gone", deleted_zone_gone },
+		{ "lookup", {
+			{ "lookups", lookup.lookups },
+			{ "mismatches", lookup.mismatches },
+			{ "tree_ms", lookup.tree_ms },
+			{ "directory_ms", lookup.directory_ms },
+			{ "directory_bytes", lookup.directory_bytes },
+		} },
+		{ "traversal", {
+			{ "serial_ms", traversal.serial_ms },
+			{ "parallel_ms", traversal.parallel_ms },
+			{ "checksums_match", traversal.serial_checksum == traversal.parallel_checksum },
+		} },
+	};
+}
+
+std::string FormatMapBenchmark(const MapBenchmarkResult &result) {
+	return fmt::format(
+		"Map benchmark: {}x{}, {} floors, {} tiles, {} items, {} threads\n"
+		"\tGenerate: {:.2f} ms\n"
+		"\tSave: {:.2f} ms ({} KB)\n"
+		"\tSerial save: {:.2f} ms ({}, golden file {})\n"
+		"\tLoad: {:.2f} ms ({})\n"
+		"\tResave: {:.2f} ms (round trip {})\n"
+		"\tMemory: {} KB\n"
+		"\tRegion: {:.2f} ms ({} tiles, {})\n"
+		"\tZone deleted from {} tiles: {}\n"
+		"{}\n"
+		"{}",
+		result.options.width, result.options.height, result.options.floors, result.tiles, result.items, result.threads,
+		result.generate_ms,
+		result.save_ms, result.file_bytes / 1024,
+		result.serial_save_ms, result.matches_serial ? "identical" : "DIFFERS", !result.golden_checked ? "not given" : result.matches_golden ? "identical" : "DIFFERS",
+		result.load_ms, result.loaded ? "ok" : "FAILED",
+		result.resave_ms, result.round_trip_identical ? "identical" : "DIFFERS",
+		result.memory_bytes / 1024,
+		result.region_ms, result.region_tiles, result.region_matches ? "match" : "DIFFER",
+		result.deleted_zone_tiles, result.deleted_zone_gone ? "gone after reload" : "STILL SAVED",
+		FormatTileLookupBenchmark(result.lookup),
+		FormatTraversalBenchmark(result.traversal)
+	);
+}
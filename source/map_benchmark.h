@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_BENCHMARK_H_
+#define RME_MAP_BENCHMARK_H_
+
+#include "basemap.h"
+
+#include <nlohmann/json.hpp>
+
+class Map;
+
+struct TileLookupBenchmarkResult {
+	uint64_t tiles = 0;
+	uint64_t lookups = 0;
+	uint64_t mismatches = 0; // Lookups where the directory and the tree disagree, should always be 0
+	double tree_ms = 0.0;
+	double directory_ms = 0.0;
+	size_t directory_bytes = 0;
+};
+
+// Resolves the same set of random positions (hits and misses) through the hextree descent
+// and through the leaf directory and times both
+TileLookupBenchmarkResult BenchmarkTileLookup(BaseMap &map, uint64_t lookups, uint32_t seed = 0x52'4D'45);
+
+std::string FormatTileLookupBenchmark(const TileLookupBenchmarkResult &result);
+
+struct TraversalBenchmarkResult {
+	uint64_t tiles = 0;
+	size_t threads = 0;
+	uint64_t serial_checksum = 0;
+	uint64_t parallel_checksum = 0; // Must match serial_checksum
+	double serial_ms = 0.0;
+	double parallel_ms = 0.0;
+};
+
+// Walks every tile once with MapIterator and once with parallel_reduce_TileOnMap, folding the
+// tile positions into a checksum, and times both
+TraversalBenchmarkResult BenchmarkTraversal(BaseMap &map);
+
+std::string FormatTraversalBenchmark(const TraversalBenchmarkResult &result);
+
+struct BenchmarkMapOptions {
+	int width = 1024;
+	int height = 1024;
+	int floors = 3; // From the ground floor down
+	double item_density = 1.5; // Mean number of items on a tile besides its ground
+	double attribute_ratio = 0.05; // Share of the items given an action id, unique id or text
+	int towns = 8;
+	int houses = 2000;
+	int spawns = 2000;
+	int zones = 4;
+	double zone_ratio = 0.02; // Share of the tiles given a zone
+	uint32_t seed = 0x52'4D'45;
+};
+
+// Fills an empty map with a world that only depends on the options: grounds, stacked items, item
+// attributes, tile flags, towns, houses and monster spawns. The item ids are made up, so no client
+// assets are needed, and every item is a plain item stored as a node of its own
+void GenerateBenchmarkMap(Map &map, const BenchmarkMapOptions &options);
+
+struct MapBenchmarkResult {
+	BenchmarkMapOptions options;
+	uint64_t tiles = 0;
+	uint64_t items = 0;
+	size_t threads = 0;
+	double generate_ms = 0.0;
+	double save_ms = 0.0;
+	double serial_save_ms = 0.0; // The same map through the serial tile area writer
+	double load_ms = 0.0;
+	double resave_ms = 0.0;
+	uint64_t file_bytes = 0;
+	bool loaded = false;
+	bool matches_serial = false; // The parallel writer wrote the same bytes as the serial one
+	bool golden_checked = false;
+	bool matches_golden = false; // The serial writer wrote the tile areas of the golden file
+	bool round_trip_identical = false; // The loaded map was saved to the same bytes it was loaded from
+	int64_t memory_bytes = 0; // Tree, tiles, items and attributes of the loaded map
+	double region_ms = 0.0; // Reading a quarter of the map through the index of the saved file
+	uint64_t region_tiles = 0;
+	bool region_matches = false; // The index was accepted and the region holds the same tiles as the whole map
+	uint64_t deleted_zone_tiles = 0; // Tiles of the zone deleted after loading
+	bool deleted_zone_gone = false; // None of them had it once the map was saved with the save cache and loaded again
+	TileLookupBenchmarkResult lookup;
+	TraversalBenchmarkResult traversal;
+
+	nlohmann::json toJson() const;
+};
+
+// Generates a map and saves it to directory with the parallel and the serial tile area writers,
+// loads it back and saves it again without the save cache, then times tile lookups and traversal
+// on the loaded map. A region is read through the index of the file and compared with the loaded map.
+// Last, a zone is deleted, the map saved through the save cache and loaded again.
+// Given a golden file, the tile areas of the serial save are compared with it. It holds the tile
+// area nodes the serial writer of the editor wrote for the same options before the writer was split
+// in parts, the rest of the file names the version of the editor.
+MapBenchmarkResult RunMapBenchmark(const BenchmarkMapOptions &options, const std::string &directory, uint64_t lookups, const std::string &golden = std::string());
+
+std::string FormatMapBenchmark(const MapBenchmarkResult &result);
+
+#endif
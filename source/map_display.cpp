@@ -29,6 +29,7 @@
 #include "palette_window.h"
 #include "map_display.h"
 #include "map_drawer.h"
+#include "map_pager.h"
 #include "application.h"
 #include "live_server.h"
 #include "browse_tile_window.h"
@@ -47,6 +48,8 @@
 #include "spawn_npc_brush.h"
 #include "npc_brush.h"
 
+#include <chrono>
+
 BEGIN_EVENT_TABLE(MapCanvas, wxGLCanvas)
 EVT_KEY_DOWN(MapCanvas::OnKeyDown)
 EVT_KEY_DOWN(MapCanvas::OnKeyUp)
@@ -242,6 +245,11 @@ void MapCanvas::OnPaint(wxPaintEvent &event) {
 		}
 
 		drawer->Release();
+
+		// Drop the areas of a paged map that went out of view once it grows past its budget
+		if (MapPager* pager = editor.getMap().getPager()) {
+			pager->evict(int64_t(g_settings.getInteger(Config::PAGED_MAP_MEMORY_BUDGET)) * 1024 * 1024);
+		}
 	}
 
 	// Clean unused textures
@@ -263,6 +271,43 @@ void MapCanvas::ShowPositionIndicator(const Position &position) {
 	}
 }
 
+MapCanvas::RenderBenchmark MapCanvas::BenchmarkRendering(int frames) {
+	using Clock = std::chrono::steady_clock;
+
+	SetCurrent(*g_gui.GetGLContext(this));
+
+	RenderBenchmark result;
+	result.frames = std::max(frames, 1);
+
+	SpriteBatch &batch = drawer->getSpriteBatch();
+	const auto drawFrame = [this]() {
+		drawer->SetupVars();
+		drawer->SetupGL();
+		drawer->Draw();
+		drawer->Release();
+		glFinish();
+	};
+	const auto timeFrames = [&](bool batched, double &milliseconds, size_t &draw_calls) {
+		batch.setEnabled(batched);
+		// Loads the textures of the view before timing
+		drawFrame();
+
+		const auto start = Clock::now();
+		for (int frame = 0; frame < result.frames; ++frame) {
+			drawFrame();
+		}
+		milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.frames;
+		draw_calls = batch.getDrawCallCount();
+		result.quads = batch.getQuadCount();
+	};
+
+	timeFrames(false, result.immediate_ms, result.immediate_draw_calls);
+	timeFrames(true, result.batched_ms, result.batched_draw_calls);
+
+	Refresh();
+	return result;
+}
+
 void MapCanvas::TakeScreenshot(wxFileName path, wxString format) {
 	int screensize_x, screensize_y;
 	GetViewBox(&view_scroll_x, &view_scroll_y, &screensize_x, &screensize_y);
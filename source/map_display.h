@@ -33,6 +33,15 @@ class MapDrawer;
 
 class MapCanvas : public wxGLCanvas {
 public:
+	struct RenderBenchmark {
+		int frames = 0;
+		size_t quads = 0; // Per frame
+		double immediate_ms = 0.0; // Per frame
+		double batched_ms = 0.0;
+		size_t immediate_draw_calls = 0; // Per frame
+		size_t batched_draw_calls = 0;
+	};
+
 	MapCanvas(MapWindow* parent, Editor &editor, int* attriblist);
 	virtual ~MapCanvas();
 	void Reset();
@@ -126,6 +135,9 @@ public:
 
 	void ShowPositionIndicator(const Position &position);
 	void TakeScreenshot(wxFileName path, wxString format);
+	// Draws the current view into the back buffer, first drawing every sprite on its own and then
+	// with the sprite batch, and waits for each frame to finish. Nothing is shown on screen.
+	RenderBenchmark BenchmarkRendering(int frames);
 
 protected:
 	void getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, PositionVector* tilestodraw, PositionVector* tilestoborder, bool fill = false);
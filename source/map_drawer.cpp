@@ -26,6 +26,7 @@
 #include "sprites.h"
 #include "map_drawer.h"
 #include "map_display.h"
+#include "map_pager.h"
 #include "copybuffer.h"
 #include "live_socket.h"
 #include "graphics.h"
@@ -134,7 +135,7 @@ bool DrawingOptions::isTooltips() const noexcept {
 }
 
 MapDrawer::MapDrawer(MapCanvas* canvas) :
-	canvas(canvas), editor(canvas->editor) {
+	canvas(canvas), editor(canvas->editor), batch(g_gui.gfx.getTextureAtlas()) {
 	light_drawer = std::make_shared<LightDrawer>();
 }
 
@@ -176,6 +177,11 @@ void MapDrawer::SetupVars() {
 
 	end_x = start_x + screensize_x / tile_size + 2;
 	end_y = start_y + screensize_y / tile_size + 2;
+
+	// Floors above the current one are drawn shifted, so the margin covers every floor offset
+	if (MapPager* pager = editor.getMap().getPager()) {
+		pager->pageIn(Position(start_x - rme::MapLayers, start_y - rme::MapLayers, superend_z), Position(end_x + rme::MapLayers, end_y + rme::MapLayers, start_z));
+	}
 }
 
 void MapDrawer::SetupGL() {
@@ -215,10 +221,17 @@ void MapDrawer::Release() {
 }
 
 void MapDrawer::Draw() {
+	// Other canvases and the light texture bind textures behind the atlas' back
+	TextureAtlas &atlas = g_gui.gfx.getTextureAtlas();
+	atlas.resetBinding();
+	batch.resetStatistics();
+
 	DrawBackground();
 	DrawMap();
 	if (options.show_lights) {
+		batch.flush();
 		light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y);
+		atlas.resetBinding();
 	}
 	DrawDraggingShadow();
 	DrawHigherFloors();
@@ -236,6 +249,7 @@ void MapDrawer::Draw() {
 	if (options.isTooltips()) {
 		DrawTooltips();
 	}
+	batch.flush();
 }
 
 void MapDrawer::DrawBackground() {
@@ -262,6 +276,8 @@ inline int getFloorAdjustment(int floor) {
 
 void MapDrawer::DrawShade(int map_z) {
 	if (map_z == end_z && start_z != end_z) {
+		batch.flush();
+
 		bool only_colors = options.isOnlyColors();
 		if (!only_colors) {
 			glDisable(GL_TEXTURE_2D);
@@ -354,6 +370,7 @@ void MapDrawer::DrawMap() {
 						int cy = (nd_map_y)*rme::TileSize - view_scroll_y - getFloorAdjustment(floor);
 						int cx = (nd_map_x)*rme::TileSize - view_scroll_x - getFloorAdjustment(floor);
 
+						batch.flush();
 						glColor4ub(255, 0, 255, 128);
 						glBegin(GL_QUADS);
 						glVertex2f(cx, cy + rme::TileSize * 4);
@@ -551,6 +568,7 @@ void MapDrawer::DrawIngameBox() {
 }
 
 void MapDrawer::DrawGrid() {
+	batch.flush();
 	glDisable(GL_TEXTURE_2D);
 	glColor4ub(255, 255, 255, 128);
 	glBegin(GL_LINES);
@@ -711,6 +729,7 @@ void MapDrawer::DrawSelectionBox() {
 	lines[3][2] = last_click_rx;
 	lines[3][3] = last_click_ry;
 
+	batch.flush();
 	glDisable(GL_TEXTURE_2D);
 	glEnable(GL_LINE_STIPPLE);
 	glLineStipple(2, 0xAAAA);
@@ -731,6 +750,8 @@ void MapDrawer::DrawLiveCursors() {
 		return;
 	}
 
+	batch.flush();
+
 	LiveSocket &live = editor.GetLive();
 	for (LiveCursor &cursor : live.getCursorList()) {
 		if (cursor.pos.z <= rme::MapGroundLayer && floor > rme::MapGroundLayer) {
@@ -775,6 +796,8 @@ void MapDrawer::DrawBrush() {
 		return;
 	}
 
+	batch.flush();
+
 	Brush* brush = g_gui.GetCurrentBrush();
 
 	BrushColor brushColor = COLOR_BLANK;
@@ -1123,9 +1146,7 @@ void MapDrawer::DrawBrush() {
 void MapDrawer::BlitItem(int &draw_x, int &draw_y, const Tile* tile, const Item* item, bool ephemeral, int red, int green, int blue, int alpha) {
 	const ItemType &type = g_items.getItemType(item->getID());
 	if (type.id == 0) {
-		glDisable(GL_TEXTURE_2D);
 		glBlitSquare(draw_x, draw_y, *wxRED);
-		glEnable(GL_TEXTURE_2D);
 		return;
 	}
 
@@ -1137,14 +1158,10 @@ void MapDrawer::BlitItem(int &draw_x, int &draw_y, const Tile* tile, const Item*
 
 	// Ugly hacks. :)
 	if (type.id == ITEM_STAIRS && !options.ingame) {
-		glDisable(GL_TEXTURE_2D);
 		glBlitSquare(draw_x, draw_y, red, green, 0, alpha / 3 * 2);
-		glEnable(GL_TEXTURE_2D);
 		return;
 	} else if (type.id == ITEM_NOTHING_SPECIAL && !options.ingame) {
-		glDisable(GL_TEXTURE_2D);
 		glBlitSquare(draw_x, draw_y, red, 0, 0, alpha / 3 * 2);
-		glEnable(GL_TEXTURE_2D);
 		return;
 	}
 
@@ -1234,14 +1251,10 @@ void MapDrawer::BlitItem(int &draw_x, int &draw_y, const Position &pos, const It
 	}
 
 	if (type.id == ITEM_STAIRS && !options.ingame) { // Ugly hack yes?
-		glDisable(GL_TEXTURE_2D);
 		glBlitSquare(draw_x, draw_y, red, green, 0, alpha / 3 * 2);
-		glEnable(GL_TEXTURE_2D);
 		return;
 	} else if (type.id == ITEM_NOTHING_SPECIAL && !options.ingame) { // Ugly hack yes?
-		glDisable(GL_TEXTURE_2D);
 		glBlitSquare(draw_x, draw_y, red, 0, 0, alpha / 3 * 2);
-		glEnable(GL_TEXTURE_2D);
 		return;
 	}
 
@@ -1541,14 +1554,12 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		}
 
 		if (only_colors) {
-			glDisable(GL_TEXTURE_2D);
 			if (options.show_as_minimap) {
 				wxColor color = colorFromEightBit(tile->getMiniMapColor());
 				glBlitSquare(draw_x, draw_y, color);
 			} else if (r != 255 || g != 255 || b != 255) {
 				glBlitSquare(draw_x, draw_y, r, g, b, 128);
 			}
-			glEnable(GL_TEXTURE_2D);
 		} else {
 			if (options.show_preview && zoom <= 2.0) {
 				tile->ground->animate();
@@ -1623,6 +1634,8 @@ void MapDrawer::DrawBrushIndicator(int x, int y, Brush* brush, uint8_t r, uint8_
 		{ -15, -20 }, // 0
 	};
 
+	batch.flush();
+
 	// circle
 	glBegin(GL_TRIANGLE_FAN);
 	glColor4ub(0x00, 0x00, 0x00, 0x50);
@@ -1653,6 +1666,7 @@ void MapDrawer::DrawBrushIndicator(int x, int y, Brush* brush, uint8_t r, uint8_
 }
 
 void MapDrawer::DrawHookIndicator(int x, int y, const ItemType &type) {
+	batch.flush();
 	glDisable(GL_TEXTURE_2D);
 	glColor4ub(uint8_t(0), uint8_t(0), uint8_t(255), uint8_t(200));
 	glBegin(GL_QUADS);
@@ -1690,10 +1704,8 @@ void MapDrawer::DrawLightStrength(int x, int y, const Item*&item) {
 
 	const int startOffset = std::max<int>(16, 32 - light.intensity);
 	const int sqSize = rme::TileSize - startOffset;
-	glDisable(GL_TEXTURE_2D);
 	glBlitSquare(x + startOffset - 2, y + startOffset - 2, 0, 0, 0, byteA, sqSize + 2);
 	glBlitSquare(x + startOffset - 1, y + startOffset - 1, byteR, byteG, byteB, byteA, sqSize);
-	glEnable(GL_TEXTURE_2D);
 }
 
 void MapDrawer::DrawTileIndicators(TileLocation* location) {
@@ -1802,6 +1814,7 @@ void MapDrawer::DrawTooltips() {
 		return;
 	}
 
+	batch.flush();
 	glDisable(GL_TEXTURE_2D);
 
 	for (MapTooltip* tooltip : tooltips) {
@@ -1914,6 +1927,7 @@ void MapDrawer::DrawTooltips() {
 void MapDrawer::DrawLight() const {
 	// draw in-game light
 	light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y);
+	g_gui.gfx.getTextureAtlas().resetBinding();
 }
 
 void MapDrawer::MakeTooltip(int screenx, int screeny, const std::string &text, uint8_t r, uint8_t g, uint8_t b) {
@@ -1989,11 +2003,17 @@ void MapDrawer::glBlitTexture(int sx, int sy, int textureId, int red, int green,
 		return;
 	}
 
+	TextureAtlas &atlas = g_gui.gfx.getTextureAtlas();
+	const TextureAtlas::Region* region = atlas.find(textureId);
+	if (!region) {
+		return;
+	}
+
 	auto width = rme::TileSize;
 	auto height = rme::TileSize;
 	// Adjusts the offset of normal sprites
 	if (!isEditorSprite) {
-		SpriteSheetPtr sheet = g_spriteAppearances.getSheetBySpriteId(spriteId > 0 ? spriteId : textureId);
+		SpriteSheetPtr sheet = g_spriteAppearances.getSheetBySpriteId(spriteId > 0 ? spriteId : textureId, false);
 		if (!sheet) {
 			return;
 		}
@@ -2032,46 +2052,15 @@ void MapDrawer::glBlitTexture(int sx, int sy, int textureId, int red, int green,
 		spdlog::debug("Blitting outfit {} at ({}, {})", outfit.name, sx, sy);
 	}
 
-	glBindTexture(GL_TEXTURE_2D, textureId);
-	glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.f, 0.f);
-	glVertex2f(sx, sy);
-	glTexCoord2f(1.f, 0.f);
-	glVertex2f(sx + width, sy);
-	glTexCoord2f(1.f, 1.f);
-	glVertex2f(sx + width, sy + height);
-	glTexCoord2f(0.f, 1.f);
-	glVertex2f(sx, sy + height);
-	glEnd();
+	batch.add(*region, sx, sy, width, height, uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
 }
 
-void MapDrawer::glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size /* = rme::TileSize */) const {
-	const auto dx = static_cast<double>(x);
-	const auto dy = static_cast<double>(y);
-	const auto dSize = static_cast<double>(size);
-
-	glColor4ub(red, green, blue, alpha);
-	glBegin(GL_QUADS);
-	glVertex2f(dx, dy);
-	glVertex2f(dx + dSize, dy);
-	glVertex2f(dx + dSize, dy + dSize);
-	glVertex2f(dx, dy + dSize);
-	glEnd();
+void MapDrawer::glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size /* = rme::TileSize */) {
+	batch.addSquare(x, y, size, red, green, blue, alpha);
 }
 
-void MapDrawer::glBlitSquare(int x, int y, const wxColor &color, int size /* = rme::TileSize */) const {
-	const auto dx = static_cast<double>(x);
-	const auto dy = static_cast<double>(y);
-	const auto dSize = static_cast<double>(size);
-
-	glColor4ub(color.Red(), color.Green(), color.Blue(), color.Alpha());
-	glBegin(GL_QUADS);
-	glVertex2f(dx, dy);
-	glVertex2f(dx + dSize, dy);
-	glVertex2f(dx + dSize, dy + dSize);
-	glVertex2f(dx, dy + dSize);
-	glEnd();
+void MapDrawer::glBlitSquare(int x, int y, const wxColor &color, int size /* = rme::TileSize */) {
+	batch.addSquare(x, y, size, color.Red(), color.Green(), color.Blue(), color.Alpha());
 }
 
 void MapDrawer::glColor(const wxColor &color) {
@@ -2134,6 +2123,7 @@ void MapDrawer::glColorCheck(Brush* brush, const Position &pos) {
 }
 
 void MapDrawer::drawRect(int x, int y, int w, int h, const wxColor &color, int width) {
+	batch.flush();
 	glLineWidth(width);
 	glColor4ub(color.Red(), color.Green(), color.Blue(), color.Alpha());
 	glBegin(GL_LINE_STRIP);
@@ -2146,6 +2136,7 @@ void MapDrawer::drawRect(int x, int y, int w, int h, const wxColor &color, int w
 }
 
 void MapDrawer::drawFilledRect(int x, int y, int w, int h, const wxColor &color) {
+	batch.flush();
 	glColor4ub(color.Red(), color.Green(), color.Blue(), color.Alpha());
 	glBegin(GL_QUADS);
 	glVertex2f(x, y);
@@ -18,6 +18,8 @@
 #ifndef RME_MAP_DRAWER_H_
 #define RME_MAP_DRAWER_H_
 
+#include "sprite_batch.h"
+
 class GameSprite;
 
 struct MapTooltip {
@@ -96,6 +98,7 @@ class MapDrawer {
 	Editor &editor;
 	DrawingOptions options;
 	std::shared_ptr<LightDrawer> light_drawer;
+	SpriteBatch batch; // Sprites and squares, flushed before anything is drawn with plain GL calls
 
 	float zoom;
 
@@ -155,6 +158,9 @@ public:
 	DrawingOptions &getOptions() noexcept {
 		return options;
 	}
+	SpriteBatch &getSpriteBatch() noexcept {
+		return batch;
+	}
 
 protected:
 	void BlitItem(int &screenx, int &screeny, const Tile* tile, const Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255);
@@ -191,8 +197,8 @@ protected:
 
 	void getColor(Brush* brush, const Position &position, uint8_t &r, uint8_t &g, uint8_t &b);
 	void glBlitTexture(int x, int y, int textureId, int red, int green, int blue, int alpha, bool adjustZoom = false, bool isEditorSprite = false, const Outfit &outfit = {}, int spriteId = 0);
-	void glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size = rme::TileSize) const;
-	void glBlitSquare(int x, int y, const wxColor &color, int size = rme::TileSize) const;
+	void glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size = rme::TileSize);
+	void glBlitSquare(int x, int y, const wxColor &color, int size = rme::TileSize);
 	void glColor(const wxColor &color);
 	void glColor(BrushColor color);
 	void glColorCheck(Brush* brush, const Position &pos);
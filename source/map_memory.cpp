@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_memory.h"
+#include "tile.h"
+#include "complexitem.h"
+#include "monster.h"
+
+void MapMemoryCounters::addTile(const Tile* tile) {
+	updateTile(tile, 1);
+}
+
+void MapMemoryCounters::removeTile(const Tile* tile) {
+	updateTile(tile, -1);
+}
+
+void MapMemoryCounters::clear() {
+	tile_count = 0;
+	tile_bytes = 0;
+	item_count = 0;
+	item_bytes = 0;
+	attribute_bytes = 0;
+	item_types.clear();
+}
+
+void MapMemoryCounters::updateTile(const Tile* tile, int sign) {
+	if (!tile) {
+		return;
+	}
+
+	tile_count += sign;
+	tile_bytes += sign * int64_t(sizeof(Tile) + tile->items.capacity() * sizeof(Item*) + tile->monsters.capacity() * sizeof(Monster*));
+
+	if (tile->ground) {
+		updateItem(tile->ground, sign);
+	}
+	for (const Item* item : tile->items) {
+		updateItem(item, sign);
+	}
+}
+
+void MapMemoryCounters::updateItem(const Item* item, int sign) {
+	// A shared record costs the tile its pointer only, which is counted with the tile
+	int64_t bytes = item->isCompact() ? 0 : sizeof(Item);
+	if (const Container* container = dynamic_cast<const Container*>(item)) {
+		bytes = sizeof(Container) + container->getItemCount() * sizeof(Item*);
+		for (size_t i = 0; i < container->getItemCount(); ++i) {
+			updateItem(container->getItem(i), sign);
+		}
+	}
+
+	item_count += sign;
+	item_bytes += sign * bytes;
+	attribute_bytes += sign * int64_t(item->getAttributesMemsize(false));
+
+	const uint16_t id = item->getID();
+	if (id >= item_types.size()) {
+		item_types.resize(id + 1);
+	}
+	item_types[id].count += sign;
+	item_types[id].bytes += sign * bytes;
+}
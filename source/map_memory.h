@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_MEMORY_H_
+#define RME_MAP_MEMORY_H_
+
+#include <vector>
+
+class Tile;
+class Item;
+
+// Byte counts of the tiles placed on one map, kept up to date as tiles enter and leave it
+// Code that changes the contents of a tile while it stays on the map must remove it before
+// the change and add it back afterwards
+class MapMemoryCounters {
+public:
+	struct ItemTypeUsage {
+		int64_t count = 0;
+		int64_t bytes = 0;
+	};
+
+	void addTile(const Tile* tile);
+	void removeTile(const Tile* tile);
+	void clear();
+
+	int64_t getTileCount() const noexcept {
+		return tile_count;
+	}
+	// Tile objects and their item/monster vectors
+	int64_t getTileBytes() const noexcept {
+		return tile_bytes;
+	}
+	int64_t getItemCount() const noexcept {
+		return item_count;
+	}
+	// Item objects, including the contents of containers
+	int64_t getItemBytes() const noexcept {
+		return item_bytes;
+	}
+	// Attribute lists, a list shared with the undo history is counted in full here
+	int64_t getAttributeBytes() const noexcept {
+		return attribute_bytes;
+	}
+	// Indexed by item id
+	const std::vector<ItemTypeUsage> &getItemTypeUsage() const noexcept {
+		return item_types;
+	}
+
+private:
+	void updateTile(const Tile* tile, int sign);
+	void updateItem(const Item* item, int sign);
+
+	int64_t tile_count = 0;
+	int64_t tile_bytes = 0;
+	int64_t item_count = 0;
+	int64_t item_bytes = 0;
+	int64_t attribute_bytes = 0;
+	std::vector<ItemTypeUsage> item_types;
+};
+
+#endif
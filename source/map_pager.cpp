@@ -0,0 +1,319 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_pager.h"
+#include "map.h"
+#include "iomap_otbm.h"
+#include "gui.h"
+
+namespace {
+	constexpr size_t PagerScanChunkSize = 1024 * 1024;
+}
+
+MapPager::MapPager(Map &map, const std::string &filename) :
+	map(map),
+	filename(filename),
+	file(filename) {
+	////
+}
+
+MapPager::~MapPager() {
+	file.close();
+}
+
+bool MapPager::scan(std::vector<uint8_t> &skeleton) {
+	if (!file.isOk()) {
+		return false;
+	}
+
+	const size_t file_size = file.size();
+	char identifier[4];
+	if (file_size < 4 || !file.getRAW(reinterpret_cast<uint8_t*>(identifier), 4)) {
+		return false;
+	}
+	if (memcmp(identifier, "OTBM", 4) != 0 && memcmp(identifier, "\0\0\0\0", 4) != 0) {
+		return false;
+	}
+
+	std::vector<uint8_t> chunk(PagerScanChunkSize);
+	OTBMAreaScanner scanner(skeleton);
+	uint64_t offset = 4;
+	while (offset < file_size) {
+		const size_t length = std::min<uint64_t>(chunk.size(), file_size - offset);
+		if (!file.getRAW(chunk.data(), length)) {
+			return false;
+		}
+		g_gui.SetLoadDone(static_cast<int32_t>(100.0 * offset / file_size));
+
+		scanner.feed(chunk.data(), length, offset);
+		offset += length;
+	}
+	if (!scanner.isComplete()) {
+		return false;
+	}
+
+	for (const OTBMAreaScanner::Area &area : scanner.getAreas()) {
+		if (area.has_base) {
+			addNode(area.offset, area.size, area.base_x, area.base_y, area.base_z);
+		}
+	}
+	return true;
+}
+
+void MapPager::addNode(uint64_t offset, uint64_t size, int base_x, int base_y, int base_z) {
+	if (base_z < rme::MapMinLayer || base_z > rme::MapMaxLayer) {
+		return;
+	}
+
+	const uint32_t node_index = static_cast<uint32_t>(nodes.size());
+	Node &node = nodes.emplace_back();
+	node.offset = offset;
+	node.size = size;
+
+	// The tiles of an area lie within 256 tiles of its base, which only matches one cell when the base is aligned
+	const int last_x = std::min(base_x + 255, 0xFFFF);
+	const int last_y = std::min(base_y + 255, 0xFFFF);
+	const bool shared = (base_x / CellSize != last_x / CellSize) || (base_y / CellSize != last_y / CellSize);
+	for (int x = base_x / CellSize; x <= last_x / CellSize; ++x) {
+		for (int y = base_y / CellSize; y <= last_y / CellSize; ++y) {
+			const uint32_t index = getCellIndex(x * CellSize, y * CellSize, base_z);
+			auto [slot, inserted] = cell_slots.try_emplace(index, static_cast<uint32_t>(cells.size()));
+			if (inserted) {
+				cells.emplace_back().index = index;
+				++pending_cells;
+			}
+			Cell &cell = cells[slot->second];
+			cell.nodes.push_back(node_index);
+			cell.shared = cell.shared || shared;
+		}
+	}
+}
+
+void MapPager::pageInCell(int x, int y, int z, bool write) {
+	if (x < 0 || y < 0 || x > 0xFFFF || y > 0xFFFF || z < rme::MapMinLayer || z > rme::MapMaxLayer) {
+		return;
+	}
+
+	Cell* cell = findCell(getCellIndex(x, y, z));
+	if (!cell) {
+		return;
+	}
+
+	if (!cell->loaded) {
+		loadCell(*cell);
+	}
+	if (write) {
+		cell->edited = true;
+	}
+}
+
+void MapPager::pageIn(const Position &from, const Position &to) {
+	++tick;
+	const int first_x = std::max(0, std::min(from.x, to.x)) / CellSize;
+	const int first_y = std::max(0, std::min(from.y, to.y)) / CellSize;
+	const int last_x = std::min(0xFFFF, std::max(from.x, to.x)) / CellSize;
+	const int last_y = std::min(0xFFFF, std::max(from.y, to.y)) / CellSize;
+	const int first_z = std::max(rme::MapMinLayer, std::min(from.z, to.z));
+	const int last_z = std::min(rme::MapMaxLayer, std::max(from.z, to.z));
+
+	for (int z = first_z; z <= last_z; ++z) {
+		for (int x = first_x; x <= last_x; ++x) {
+			for (int y = first_y; y <= last_y; ++y) {
+				Cell* cell = findCell(getCellIndex(x * CellSize, y * CellSize, z));
+				if (!cell) {
+					continue;
+				}
+				if (!cell->loaded && busy == 0) {
+					loadCell(*cell);
+				}
+				cell->last_used = tick;
+			}
+		}
+	}
+}
+
+void MapPager::pageInAll(bool write) {
+	if (busy != 0) {
+		return;
+	}
+
+	for (Cell &cell : cells) {
+		if (!cell.loaded) {
+			loadCell(cell);
+		}
+		if (write) {
+			cell.edited = true;
+		}
+	}
+}
+
+void MapPager::loadCell(Cell &cell) {
+	Suspend suspend(this);
+
+	IOMapOTBM loader(version);
+	std::vector<uint8_t> buffer;
+	for (uint32_t node_index : cell.nodes) {
+		Node &node = nodes[node_index];
+		if (node.loaded) {
+			continue;
+		}
+		node.loaded = true;
+
+		if (!readNode(node, buffer)) {
+			spdlog::warn("Could not read the tile area at offset {} of {}", node.offset, filename);
+			continue;
+		}
+
+		MemoryNodeFileReadHandle handle(buffer.data(), buffer.size());
+		BinaryNode* area = handle.getRootNode();
+		uint8_t type;
+		if (area && area->getByte(type) && type == OTBM_TILE_AREA) {
+			loader.loadTileArea(map, area, cell.evicted);
+		}
+	}
+
+	for (const wxString &warning : loader.getWarnings()) {
+		spdlog::warn("{}", nstr(warning));
+	}
+
+	cell.loaded = true;
+	cell.last_used = tick;
+	--pending_cells;
+}
+
+bool MapPager::readNode(Node &node, std::vector<uint8_t> &buffer) {
+	if (!node.data.empty()) {
+		buffer = node.data;
+		return true;
+	}
+
+	buffer.resize(node.size);
+	return file.seek(node.offset) && file.getRAW(buffer.data(), buffer.size());
+}
+
+void MapPager::evict(int64_t budget) {
+	const MapMemoryCounters &memory = map.memory;
+	const auto residentBytes = [&memory]() {
+		return memory.getTileBytes() + memory.getItemBytes() + memory.getAttributeBytes();
+	};
+	if (busy != 0 || residentBytes() <= budget) {
+		return;
+	}
+
+	// Cells drawn in the last frame are never candidates
+	std::vector<uint32_t> candidates;
+	for (uint32_t index = 0; index < cells.size(); ++index) {
+		const Cell &cell = cells[index];
+		if (cell.loaded && !cell.edited && !cell.shared && cell.last_used < tick) {
+			candidates.push_back(index);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+		return cells[a].last_used < cells[b].last_used;
+	});
+
+	for (uint32_t index : candidates) {
+		if (!evictCell(index)) {
+			// Holds something the file does not, keep it for good
+			cells[index].edited = true;
+			continue;
+		}
+		if (residentBytes() <= budget) {
+			break;
+		}
+	}
+}
+
+bool MapPager::evictCell(uint32_t index) {
+	const uint32_t key = cells[index].index;
+
+	const int base_x = (key & 0xFF) * CellSize;
+	const int base_y = ((key >> 8) & 0xFF) * CellSize;
+	const int z = key >> 16;
+
+	std::vector<Tile*> tiles;
+	for (int x = base_x; x < base_x + CellSize; x += 4) {
+		for (int y = base_y; y < base_y + CellSize; y += 4) {
+			QTreeNode* leaf = map.getLeaf(x, y);
+			Floor* floor = leaf ? leaf->getFloor(z) : nullptr;
+			if (!floor) {
+				continue;
+			}
+			for (TileLocation &location : floor->locs) {
+				Tile* tile = location.get();
+				if (!tile) {
+					continue;
+				}
+				// State that is not stored in the area, or that someone may still point at
+				if (tile->isSelected() || tile->isModified() || tile->spawnMonster || tile->spawnNpc || tile->npc || !tile->monsters.empty()) {
+					return false;
+				}
+				tiles.push_back(tile);
+			}
+		}
+	}
+
+	// Houses keep the positions of their tiles, so their size is still known
+	Suspend suspend(this);
+	for (Tile* tile : tiles) {
+		map.setPagedTile(tile->getPosition(), nullptr);
+	}
+
+	Cell &cell = cells[index];
+	cell.evicted = true;
+	for (uint32_t node_index : cell.nodes) {
+		nodes[node_index].loaded = false;
+	}
+	cell.loaded = false;
+	++pending_cells;
+	return true;
+}
+
+bool MapPager::writeAreas(NodeFileWriteHandle &writer) {
+	std::vector<uint8_t> buffer;
+	for (Node &node : nodes) {
+		if (node.loaded) {
+			continue;
+		}
+		if (!readNode(node, buffer)) {
+			return false;
+		}
+		writer.addEncodedNode(buffer.data(), buffer.size());
+	}
+	return true;
+}
+
+bool MapPager::detach() {
+	// The areas in the map can not be read back once the file is gone
+	for (Cell &cell : cells) {
+		if (cell.loaded) {
+			cell.edited = true;
+		}
+	}
+	for (Node &node : nodes) {
+		if (node.loaded || !node.data.empty()) {
+			continue;
+		}
+		if (!readNode(node, node.data)) {
+			return false;
+		}
+	}
+	file.close();
+	return true;
+}
@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_PAGER_H_
+#define RME_MAP_PAGER_H_
+
+#include "client_assets.h"
+#include "filehandle.h"
+#include "position.h"
+
+#include <unordered_map>
+
+class Map;
+class NodeFileWriteHandle;
+
+// Keeps the tile areas of a large OTBM file on disk until they are needed.
+// Opening a map only scans the file for the offsets of its OTBM_TILE_AREA nodes, every other node
+// is collected into a small skeleton that goes through the regular loader. The map is split in
+// cells of CellSize x CellSize tiles on one floor, and the areas of a cell are read into the map the
+// first time a position inside it is looked up, drawn or edited. Cells that have not been edited
+// since they were read can be dropped again to keep the map under a memory budget. The unique ids,
+// zones and house positions of their tiles stay registered meanwhile. Tiles changed in place must
+// go through BaseMap::markTileChanged, which marks their cell edited.
+class MapPager {
+public:
+	// Tile areas written by the editor cover exactly one cell
+	static constexpr int CellSize = 256;
+
+	MapPager(Map &map, const std::string &filename);
+	~MapPager();
+
+	MapPager(const MapPager &) = delete;
+	MapPager &operator=(const MapPager &) = delete;
+
+	// Indexes the tile areas of the file and returns the remaining nodes in skeleton,
+	// starting at the root node so it can be read through a MemoryNodeFileReadHandle
+	bool scan(std::vector<uint8_t> &skeleton);
+	// The version the areas are read with, known once the root node of the skeleton is read
+	void setVersion(const MapVersion &new_version) {
+		version = new_version;
+	}
+
+	// Makes sure the cell holding the position is in the map, a write also keeps it from being evicted
+	void pageIn(int x, int y, int z, bool write = false) {
+		if (busy == 0 && (write || pending_cells != 0)) {
+			pageInCell(x, y, z, write);
+		}
+	}
+	// Loads every cell intersecting the box and marks them as the most recently used
+	void pageIn(const Position &from, const Position &to);
+	// Loads the whole map, when write is set nothing is evictable afterwards
+	void pageInAll(bool write);
+
+	// Drops the least recently used cells that were not edited until the tiles fit in budget bytes
+	void evict(int64_t budget);
+
+	// Writes the areas that are not in the map, verbatim, into the current node of the writer
+	bool writeAreas(NodeFileWriteHandle &writer);
+	// Reads the areas that are not in the map into memory, so the file can be overwritten
+	bool detach();
+
+	const std::string &getFilename() const noexcept {
+		return filename;
+	}
+	size_t getCellCount() const noexcept {
+		return cells.size();
+	}
+	size_t getPendingCellCount() const noexcept {
+		return pending_cells;
+	}
+
+	// While alive, lookups do not load anything and writes do not mark cells as edited
+	class Suspend {
+	public:
+		explicit Suspend(MapPager* pager) :
+			pager(pager) {
+			if (pager) {
+				++pager->busy;
+			}
+		}
+		~Suspend() {
+			if (pager) {
+				--pager->busy;
+			}
+		}
+
+		Suspend(const Suspend &) = delete;
+		Suspend &operator=(const Suspend &) = delete;
+
+	private:
+		MapPager* pager;
+	};
+
+private:
+	// One OTBM_TILE_AREA node, as stored in the file
+	struct Node {
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		bool loaded = false;
+		// Filled by detach(), the node is read from here instead of the file
+		std::vector<uint8_t> data;
+	};
+
+	struct Cell {
+		uint32_t index = 0;
+		std::vector<uint32_t> nodes;
+		uint64_t last_used = 0;
+		bool loaded = false;
+		bool edited = false;
+		// Evicted before, the unique ids, zones and house positions of its tiles are still registered
+		bool evicted = false;
+		// Holds a node that is not aligned to the cell grid and spills into a neighbour
+		bool shared = false;
+	};
+
+	static uint32_t getCellIndex(int x, int y, int z) noexcept {
+		return (static_cast<uint32_t>(z) << 16) | (static_cast<uint32_t>(y / CellSize) << 8) | static_cast<uint32_t>(x / CellSize);
+	}
+
+	Cell* findCell(uint32_t index) noexcept {
+		auto it = cell_slots.find(index);
+		return it != cell_slots.end() ? &cells[it->second] : nullptr;
+	}
+
+	void addNode(uint64_t offset, uint64_t size, int base_x, int base_y, int base_z);
+	void pageInCell(int x, int y, int z, bool write);
+	void loadCell(Cell &cell);
+	bool evictCell(uint32_t index);
+	bool readNode(Node &node, std::vector<uint8_t> &buffer);
+
+	Map &map;
+	std::string filename;
+	FileReadHandle file;
+	MapVersion version;
+
+	std::vector<Node> nodes;
+	std::vector<Cell> cells;
+	// Position of every cell the file has tiles in, keyed by getCellIndex
+	std::unordered_map<uint32_t, uint32_t> cell_slots;
+	size_t pending_cells = 0;
+	uint64_t tick = 0;
+	int busy = 0;
+};
+
+#endif
@@ -70,6 +70,35 @@ Floor::Floor(int sx, int sy, int z) {
 	}
 }
 
+//**************** Leaf Directory **********************
+
+void LeafDirectory::set(int x, int y, QTreeNode* leaf) {
+	if (!pages) {
+		pages = std::make_unique<std::unique_ptr<Page>[]>(PagesPerRow * PagesPerRow);
+	}
+
+	const uint32_t cx = static_cast<uint32_t>(x) & 0xFFFF;
+	const uint32_t cy = static_cast<uint32_t>(y) & 0xFFFF;
+	std::unique_ptr<Page> &page = pages[(cx >> PageShift) * PagesPerRow + (cy >> PageShift)];
+	if (!page) {
+		page = std::make_unique<Page>();
+		++page_count;
+	}
+	page->leaves[((cx & (PageTiles - 1)) >> 2) * PageLeaves + ((cy & (PageTiles - 1)) >> 2)] = leaf;
+}
+
+void LeafDirectory::clear() noexcept {
+	pages.reset();
+	page_count = 0;
+}
+
+size_t LeafDirectory::memsize() const noexcept {
+	if (!pages) {
+		return 0;
+	}
+	return PagesPerRow * PagesPerRow * sizeof(std::unique_ptr<Page>) + page_count * sizeof(Page);
+}
+
 //**************** QTreeNode **********************
 
 QTreeNode::QTreeNode(BaseMap &map) :
@@ -85,11 +114,43 @@ QTreeNode::QTreeNode(BaseMap &map) :
 QTreeNode::~QTreeNode() {
 	if (isLeaf) {
 		for (int i = 0; i < rme::MapLayers; ++i) {
-			delete array[i];
+			map.allocator.freeFloor(array[i]);
+		}
+	} else {
+		for (int i = 0; i < rme::MapLayers; ++i) {
+			map.allocator.freeNode(child[i]);
+		}
+	}
+}
+
+void QTreeNode::releaseChildren() {
+	if (isLeaf) {
+		for (int i = 0; i < rme::MapLayers; ++i) {
+			if (array[i]) {
+				std::destroy_at(array[i]);
+				array[i] = nullptr;
+			}
 		}
 	} else {
 		for (int i = 0; i < rme::MapLayers; ++i) {
-			delete child[i];
+			if (QTreeNode* node = child[i]) {
+				node->releaseChildren();
+				std::destroy_at(node);
+				child[i] = nullptr;
+			}
+		}
+	}
+}
+
+void QTreeNode::collectLeaves(std::vector<QTreeNode*> &leaves) {
+	if (isLeaf) {
+		leaves.push_back(this);
+		return;
+	}
+
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		if (QTreeNode* node = child[i]) {
+			node->collectLeaves(leaves);
 		}
 	}
 }
@@ -129,11 +190,11 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 
 		} else {
 			if (level == 0) {
-				qt = newd QTreeNode(map);
+				qt = map.allocator.allocateNode(map);
 				qt->isLeaf = true;
 				return qt;
 			} else {
-				qt = newd QTreeNode(map);
+				qt = map.allocator.allocateNode(map);
 			}
 		}
 		node = node->child[index];
@@ -148,7 +209,7 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 Floor* QTreeNode::createFloor(int x, int y, int z) {
 	ASSERT(isLeaf);
 	if (!array[z]) {
-		array[z] = newd Floor(x, y, z);
+		array[z] = map.allocator.allocateFloor(x, y, z);
 	}
 	return array[z];
 }
@@ -260,6 +321,8 @@ void QTreeNode::clearTile(int x, int y, int z) {
 	int offset_y = y & 3;
 
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
+	map.memory.removeTile(tmp->tile);
 	delete tmp->tile;
 	tmp->tile = map.allocator(tmp);
+	map.memory.addTile(tmp->tile);
 }
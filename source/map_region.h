@@ -21,6 +21,9 @@
 #include "const.h"
 #include "position.h"
 
+#include <memory>
+#include <vector>
+
 class Tile;
 class Floor;
 class BaseMap;
@@ -113,6 +116,46 @@ public:
 	TileLocation locs[rme::MapLayers];
 };
 
+// Direct-indexed directory of the hextree leaves, it resolves a position to its 4x4 leaf with
+// two table reads instead of walking down the seven levels of the tree.
+class LeafDirectory {
+public:
+	static constexpr uint32_t PageShift = 8; // A page covers 256x256 tiles
+	static constexpr uint32_t PageTiles = 1 << PageShift;
+	static constexpr uint32_t PageLeaves = PageTiles / 4;
+	static constexpr uint32_t PagesPerRow = 0x10000 >> PageShift;
+
+	// Coordinates wrap at 16 bits, just like they do in the hextree
+	QTreeNode* get(int x, int y) const noexcept {
+		if (!pages) {
+			return nullptr;
+		}
+		const uint32_t cx = static_cast<uint32_t>(x) & 0xFFFF;
+		const uint32_t cy = static_cast<uint32_t>(y) & 0xFFFF;
+		const Page* page = pages[(cx >> PageShift) * PagesPerRow + (cy >> PageShift)].get();
+		if (!page) {
+			return nullptr;
+		}
+		return page->leaves[((cx & (PageTiles - 1)) >> 2) * PageLeaves + ((cy & (PageTiles - 1)) >> 2)];
+	}
+
+	void set(int x, int y, QTreeNode* leaf);
+	void clear() noexcept;
+
+	size_t getPageCount() const noexcept {
+		return page_count;
+	}
+	size_t memsize() const noexcept;
+
+private:
+	struct Page {
+		QTreeNode* leaves[PageLeaves * PageLeaves] = {};
+	};
+
+	std::unique_ptr<std::unique_ptr<Page>[]> pages;
+	size_t page_count = 0;
+};
+
 // This is not a QuadTree, but a HexTree (16 child nodes to every node), so the name is abit misleading
 class QTreeNode {
 public:
@@ -125,6 +168,12 @@ public:
 	QTreeNode* getLeaf(int x, int y); // Might return nullptr
 	QTreeNode* getLeafForce(int x, int y); // Will never return nullptr, it will create the node if it's not there
 
+	// Destroys all floors and nodes below this one without returning them to the allocator,
+	// used right before the map allocator drops its pools in bulk
+	void releaseChildren();
+	// Appends all leaves below this node, in the same order MapIterator visits them
+	void collectLeaves(std::vector<QTreeNode*> &leaves);
+
 	// Coordinates are NOT relative
 	TileLocation* createTile(int x, int y, int z);
 	TileLocation* getTile(int x, int y, int z);
@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_save_cache.h"
+
+namespace {
+	constexpr size_t SaveCacheColumnCount = size_t(65536 / MapSaveCache::ColumnSize) * size_t(65536 / MapSaveCache::ColumnSize);
+}
+
+void MapSaveCache::setVersion(uint32_t new_version) {
+	if (version != new_version) {
+		clear();
+		version = new_version;
+	}
+}
+
+void MapSaveCache::markAllDirty() {
+	if (busy == 0 && clean_columns != 0) {
+		clear();
+	}
+}
+
+void MapSaveCache::clear() {
+	columns.clear();
+	columns.shrink_to_fit();
+	clean_columns = 0;
+	memory_usage = 0;
+}
+
+MapSaveCache::Bytes MapSaveCache::find(uint32_t column) const {
+	if (column >= columns.size()) {
+		return nullptr;
+	}
+	return columns[column];
+}
+
+void MapSaveCache::store(uint32_t column, Bytes bytes) {
+	ASSERT(column < SaveCacheColumnCount);
+	ASSERT(bytes);
+	if (columns.empty()) {
+		columns.resize(SaveCacheColumnCount);
+	}
+
+	Bytes &entry = columns[column];
+	if (entry) {
+		memory_usage -= static_cast<int64_t>(entry->capacity());
+	} else {
+		++clean_columns;
+	}
+	entry = std::move(bytes);
+	memory_usage += static_cast<int64_t>(entry->capacity());
+}
+
+void MapSaveCache::markColumnDirty(uint32_t column) {
+	if (column >= columns.size() || !columns[column]) {
+		return;
+	}
+
+	memory_usage -= static_cast<int64_t>(columns[column]->capacity());
+	columns[column].reset();
+	--clean_columns;
+}
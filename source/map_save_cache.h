@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_SAVE_CACHE_H_
+#define RME_MAP_SAVE_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The serialised OTBM tile areas of every 256x256 column of the map, all floors together, as of
+// the last load or save. The writer visits a column in one go, so a column that has not changed
+// since can be copied into the next save as it is instead of being encoded again.
+// Anything that changes a tile in place must mark its column dirty, the map does so for tiles that
+// are set, swapped or created and marks everything dirty when it is walked with begin().
+// The bytes of a column are shared and never changed, a save written in the background keeps the
+// columns it was given alive after they are marked dirty here.
+class MapSaveCache {
+public:
+	static constexpr int ColumnSize = 256;
+
+	using Bytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+	static uint32_t getColumnIndex(int x, int y) noexcept {
+		return (static_cast<uint32_t>(y / ColumnSize) << 8) | static_cast<uint32_t>(x / ColumnSize);
+	}
+
+	// The OTBM version the cached bytes were encoded with, changing it empties the cache
+	void setVersion(uint32_t new_version);
+	uint32_t getVersion() const noexcept {
+		return version;
+	}
+
+	void markDirty(int x, int y) {
+		if (busy == 0 && clean_columns != 0) {
+			markColumnDirty(getColumnIndex(x, y));
+		}
+	}
+	void markAllDirty();
+	// Drops everything, even while suspended
+	void clear();
+
+	// The bytes of a column that is still clean, nullptr if it has to be encoded again
+	Bytes find(uint32_t column) const;
+	void store(uint32_t column, Bytes bytes);
+
+	size_t getCleanColumnCount() const noexcept {
+		return clean_columns;
+	}
+	int64_t getMemoryUsage() const noexcept {
+		return memory_usage;
+	}
+
+	// While alive, nothing is marked dirty, for walks over the map that do not change any tile
+	class Suspend {
+	public:
+		explicit Suspend(MapSaveCache &cache) :
+			cache(cache) {
+			++cache.busy;
+		}
+		~Suspend() {
+			--cache.busy;
+		}
+
+		Suspend(const Suspend &) = delete;
+		Suspend &operator=(const Suspend &) = delete;
+
+	private:
+		MapSaveCache &cache;
+	};
+
+private:
+	void markColumnDirty(uint32_t column);
+
+	// Allocated on first use, indexed by getColumnIndex, nullptr for dirty columns
+	std::vector<Bytes> columns;
+	size_t clean_columns = 0;
+	int64_t memory_usage = 0;
+	uint32_t version = 0;
+	int busy = 0;
+};
+
+#endif
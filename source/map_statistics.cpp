@@ -0,0 +1,289 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_statistics.h"
+#include "map.h"
+#include "items.h"
+#include "complexitem.h"
+#include "action.h"
+
+std::string GetMapStatisticsReport(Map &map, const ActionQueue* history, const std::function<void(int32_t)> &progress) {
+	int load_counter = 0;
+
+	struct TileStatistics {
+		uint64_t tile_count = 0;
+		uint64_t detailed_tile_count = 0;
+		uint64_t blocking_tile_count = 0;
+		uint64_t walkable_tile_count = 0;
+		uint64_t spawn_monster_count = 0;
+		uint64_t spawn_npc_count = 0;
+		uint64_t monster_count = 0;
+		uint64_t npc_count = 0;
+
+		uint64_t item_count = 0;
+		uint64_t loose_item_count = 0;
+		uint64_t depot_count = 0;
+		uint64_t action_item_count = 0;
+		uint64_t unique_item_count = 0;
+		uint64_t container_count = 0; // Only includes containers containing more than 1 item
+	};
+
+	double percent_pathable = 0.0;
+	double percent_detailed = 0.0;
+	double monsters_per_spawn = 0.0;
+	double npcs_per_spawn = 0.0;
+
+	int town_count = map.towns.count();
+	int house_count = map.houses.count();
+	std::map<uint32_t, uint32_t> town_sqm_count;
+	const Town* largest_town = nullptr;
+	uint64_t largest_town_size = 0;
+	uint64_t total_house_sqm = 0;
+	const House* largest_house = nullptr;
+	uint64_t largest_house_size = 0;
+	double houses_per_town = 0.0;
+	double sqm_per_house = 0.0;
+	double sqm_per_town = 0.0;
+
+	// Tiles are only read here, so every thread can count its own share of the map
+	const auto analyzeTile = [](TileStatistics &stats, const Tile* tile) {
+		if (tile->empty()) {
+			return;
+		}
+
+		stats.tile_count += 1;
+
+		bool is_detailed = false;
+		const auto analyzeItem = [&](const Item* item) {
+			stats.item_count += 1;
+			if (!item->isGroundTile() && !item->isBorder()) {
+				is_detailed = true;
+				const ItemType &it = g_items.getItemType(item->getID());
+				if (it.moveable) {
+					stats.loose_item_count += 1;
+				}
+				if (it.isDepot()) {
+					stats.depot_count += 1;
+				}
+				if (item->getActionID() > 0) {
+					stats.action_item_count += 1;
+				}
+				if (item->getUniqueID() > 0) {
+					stats.unique_item_count += 1;
+				}
+				if (const Container* c = dynamic_cast<const Container*>(item)) {
+					if (c->getItemCount()) {
+						stats.container_count += 1;
+					}
+				}
+			}
+		};
+		if (tile->ground) {
+			analyzeItem(tile->ground);
+		}
+
+		for (const Item* item : tile->items) {
+			analyzeItem(item);
+		}
+
+		if (tile->spawnMonster) {
+			stats.spawn_monster_count += 1;
+		}
+
+		if (tile->spawnNpc) {
+			stats.spawn_npc_count += 1;
+		}
+
+		stats.monster_count += tile->monsters.size();
+
+		if (tile->npc) {
+			stats.npc_count += 1;
+		}
+
+		if (tile->isBlocking()) {
+			stats.blocking_tile_count += 1;
+		} else {
+			stats.walkable_tile_count += 1;
+		}
+
+		if (is_detailed) {
+			stats.detailed_tile_count += 1;
+		}
+	};
+
+	const auto mergeStatistics = [](TileStatistics &into, const TileStatistics &from) {
+		into.tile_count += from.tile_count;
+		into.detailed_tile_count += from.detailed_tile_count;
+		into.blocking_tile_count += from.blocking_tile_count;
+		into.walkable_tile_count += from.walkable_tile_count;
+		into.spawn_monster_count += from.spawn_monster_count;
+		into.spawn_npc_count += from.spawn_npc_count;
+		into.monster_count += from.monster_count;
+		into.npc_count += from.npc_count;
+		into.item_count += from.item_count;
+		into.loose_item_count += from.loose_item_count;
+		into.depot_count += from.depot_count;
+		into.action_item_count += from.action_item_count;
+		into.unique_item_count += from.unique_item_count;
+		into.container_count += from.container_count;
+	};
+
+	int last_progress = -1;
+	const TileStatistics stats = parallel_reduce_TileOnMap(map, TileStatistics(), analyzeTile, mergeStatistics, [&](size_t done, size_t total) {
+		const int32_t done_percent = int32_t(int64_t(done) * 95ll / int64_t(total));
+		if (done_percent != last_progress) {
+			progress(done_percent);
+			last_progress = done_percent;
+		}
+	});
+
+	const uint64_t tile_count = stats.tile_count;
+	const uint64_t detailed_tile_count = stats.detailed_tile_count;
+	const uint64_t blocking_tile_count = stats.blocking_tile_count;
+	const uint64_t walkable_tile_count = stats.walkable_tile_count;
+	const uint64_t spawn_monster_count = stats.spawn_monster_count;
+	const uint64_t spawn_npc_count = stats.spawn_npc_count;
+	const uint64_t monster_count = stats.monster_count;
+	const uint64_t npc_count = stats.npc_count;
+	const uint64_t item_count = stats.item_count;
+	const uint64_t loose_item_count = stats.loose_item_count;
+	const uint64_t depot_count = stats.depot_count;
+	const uint64_t action_item_count = stats.action_item_count;
+	const uint64_t unique_item_count = stats.unique_item_count;
+	const uint64_t container_count = stats.container_count;
+
+	monsters_per_spawn = (spawn_monster_count != 0 ? double(monster_count) / double(spawn_monster_count) : -1.0);
+	npcs_per_spawn = (spawn_npc_count != 0 ? double(npc_count) / double(spawn_npc_count) : -1.0);
+	percent_pathable = 100.0 * (tile_count != 0 ? double(walkable_tile_count) / double(tile_count) : -1.0);
+	percent_detailed = 100.0 * (tile_count != 0 ? double(detailed_tile_count) / double(tile_count) : -1.0);
+
+	load_counter = 0;
+	Houses &houses = map.houses;
+	for (HouseMap::const_iterator hit = houses.begin(); hit != houses.end(); ++hit) {
+		const House* house = hit->second;
+
+		if (load_counter % 64) {
+			progress(int32_t(95ll + int64_t(load_counter) * 5ll / int64_t(house_count)));
+		}
+
+		if (house->size() > largest_house_size) {
+			largest_house = house;
+			largest_house_size = house->size();
+		}
+		total_house_sqm += house->size();
+		town_sqm_count[house->townid] += house->size();
+	}
+
+	houses_per_town = (town_count != 0 ? double(house_count) / double(town_count) : -1.0);
+	sqm_per_house = (house_count != 0 ? double(total_house_sqm) / double(house_count) : -1.0);
+	sqm_per_town = (town_count != 0 ? double(total_house_sqm) / double(town_count) : -1.0);
+
+	Towns &towns = map.towns;
+	for (std::map<uint32_t, uint32_t>::iterator town_iter = town_sqm_count.begin();
+		 town_iter != town_sqm_count.end();
+		 ++town_iter) {
+		// No load bar for this, load is non-existant
+		uint32_t town_id = town_iter->first;
+		uint32_t town_sqm = town_iter->second;
+		Town* town = towns.getTown(town_id);
+		if (town && town_sqm > largest_town_size) {
+			largest_town = town;
+			largest_town_size = town_sqm;
+		} else {
+			// Non-existant town!
+		}
+	}
+
+	std::ostringstream os;
+	os.setf(std::ios::fixed, std::ios::floatfield);
+	os.precision(2);
+	os << "Map statistics for the map \"" << map.getMapDescription() << "\"\n";
+	os << "\tTile data:\n";
+	os << "\t\tTotal number of tiles: " << tile_count << "\n";
+	os << "\t\tNumber of pathable tiles: " << walkable_tile_count << "\n";
+	os << "\t\tNumber of unpathable tiles: " << blocking_tile_count << "\n";
+	if (percent_pathable >= 0.0) {
+		os << "\t\tPercent walkable tiles: " << percent_pathable << "%\n";
+	}
+	os << "\t\tDetailed tiles: " << detailed_tile_count << "\n";
+	if (percent_detailed >= 0.0) {
+		os << "\t\tPercent detailed tiles: " << percent_detailed << "%\n";
+	}
+
+	os << "\tItem data:\n";
+	os << "\t\tTotal number of items: " << item_count << "\n";
+	os << "\t\tNumber of moveable tiles: " << loose_item_count << "\n";
+	os << "\t\tNumber of depots: " << depot_count << "\n";
+	os << "\t\tNumber of containers: " << container_count << "\n";
+	os << "\t\tNumber of items with Action ID: " << action_item_count << "\n";
+	os << "\t\tNumber of items with Unique ID: " << unique_item_count << "\n";
+
+	os << "\tMonster data:\n";
+	os << "\t\tTotal monster count: " << monster_count << "\n";
+	os << "\t\tTotal monster spawn count: " << spawn_monster_count << "\n";
+	os << "\t\tTotal npc count: " << npc_count << "\n";
+	os << "\t\tTotal npc spawn count: " << spawn_npc_count << "\n";
+	if (monsters_per_spawn >= 0) {
+		os << "\t\tMean monsters per spawn: " << monsters_per_spawn << "\n";
+	}
+
+	if (npcs_per_spawn >= 0) {
+		os << "\t\tMean npcs per spawn: " << npcs_per_spawn << "\n";
+	}
+
+	os << "\tTown/House data:\n";
+	os << "\t\tTotal number of towns: " << town_count << "\n";
+	os << "\t\tTotal number of houses: " << house_count << "\n";
+	if (houses_per_town >= 0) {
+		os << "\t\tMean houses per town: " << houses_per_town << "\n";
+	}
+	os << "\t\tTotal amount of housetiles: " << total_house_sqm << "\n";
+	if (sqm_per_house >= 0) {
+		os << "\t\tMean tiles per house: " << sqm_per_house << "\n";
+	}
+	if (sqm_per_town >= 0) {
+		os << "\t\tMean tiles per town: " << sqm_per_town << "\n";
+	}
+
+	if (largest_town) {
+		os << "\t\tLargest Town: \"" << largest_town->getName() << "\" (" << largest_town_size << " sqm)\n";
+	}
+	if (largest_house) {
+		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
+	}
+
+	const MapAllocatorStatistics allocator_stats = map.allocator.getStatistics();
+	const auto writePoolStatistics = [&os](const char* name, const MapPoolStatistics &stats) {
+		os << "\t\t" << name << ": " << stats.used << " / " << stats.capacity << " slots in " << stats.slabs << " slabs";
+		os << " (" << (stats.reservedBytes() / 1024) << " KB, " << (100.0 * stats.occupancy()) << "% occupied, ";
+		os << (100.0 * stats.fragmentation()) << "% fragmented)\n";
+	};
+	os << "\tAllocator data:\n";
+	writePoolStatistics("Tiles", allocator_stats.tiles);
+	writePoolStatistics("Plain items (all maps)", Item::getPoolStatistics());
+	writePoolStatistics("Floors", allocator_stats.floors);
+	writePoolStatistics("Nodes", allocator_stats.nodes);
+	if (history) {
+		os << "\t\tUndo history: " << history->size() << " actions (" << (history->memsize() / 1024) << " KB)\n";
+	}
+
+	os << "\n";
+	os << "Generated by Canary's Map Editor version " + __RME_VERSION__ + "\n";
+	return os.str();
+}
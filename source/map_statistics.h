@@ -0,0 +1,31 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_STATISTICS_H_
+#define RME_MAP_STATISTICS_H_
+
+#include <functional>
+#include <string>
+
+class Map;
+class ActionQueue;
+
+// The text of Map > Statistics, tiles, items, creatures, towns, houses and allocator usage.
+// history may be nullptr, progress is told how far the collection is from 0 to 100
+std::string GetMapStatisticsReport(Map &map, const ActionQueue* history, const std::function<void(int32_t)> &progress);
+
+#endif
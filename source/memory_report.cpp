@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "memory_report.h"
+#include "editor.h"
+#include "gui.h"
+#include "items.h"
+#include "minimap_window.h"
+#include "settings.h"
+#include "sprite_appearances.h"
+
+int64_t MemoryReport::getTotalBytes() const {
+	int64_t total = 0;
+	for (const Category &category : categories) {
+		total += category.bytes;
+	}
+	return total;
+}
+
+nlohmann::json MemoryReport::toJson() const {
+	nlohmann::json json;
+	json["total_bytes"] = getTotalBytes();
+
+	nlohmann::json &json_categories = json["categories"] = nlohmann::json::array();
+	for (const Category &category : categories) {
+		json_categories.push_back({ { "name", category.name }, { "bytes", category.bytes }, { "count", category.count } });
+	}
+
+	nlohmann::json &json_item_types = json["item_types"] = nlohmann::json::array();
+	for (const ItemType &type : item_types) {
+		json_item_types.push_back({ { "id", type.id }, { "name", type.name }, { "bytes", type.bytes }, { "count", type.count } });
+	}
+
+	json["sprite_cache"] = {
+		{ "budget_bytes", sprite_cache.budget_bytes },
+		{ "sheet_hits", sprite_cache.sheet_hits },
+		{ "sheet_misses", sprite_cache.sheet_misses },
+		{ "sheet_evictions", sprite_cache.sheet_evictions },
+		{ "sprite_hits", sprite_cache.sprite_hits },
+		{ "sprite_misses", sprite_cache.sprite_misses },
+		{ "sprite_evictions", sprite_cache.sprite_evictions },
+		{ "pinned_sprites", sprite_cache.pinned_sprites },
+	};
+	return json;
+}
+
+MemoryReport CollectMemoryReport(Editor* editor, size_t max_item_types) {
+	MemoryReport report;
+	const auto addCategory = [&report](const char* name, int64_t bytes, int64_t count) {
+		report.categories.push_back({ name, bytes, count });
+	};
+
+	if (editor) {
+		Map &map = editor->getMap();
+		const MapMemoryCounters &memory = map.memory;
+		const MapAllocatorStatistics allocator = map.allocator.getStatistics();
+
+		const int64_t tree_bytes = allocator.floors.reservedBytes() + allocator.nodes.reservedBytes() + map.getLeafDirectory().memsize();
+		addCategory("Tile tree", tree_bytes, allocator.floors.used + allocator.nodes.used);
+		addCategory("Tiles", memory.getTileBytes(), memory.getTileCount());
+		addCategory("Items", memory.getItemBytes(), memory.getItemCount());
+		addCategory("Item attributes", memory.getAttributeBytes(), 0);
+
+		const ActionQueue* history = editor->getHistoryActions();
+		addCategory("Undo queue", history ? history->memsize() : 0, history ? history->size() : 0);
+		addCategory("Save cache", map.save_cache.getMemoryUsage(), map.save_cache.getCleanColumnCount());
+
+		const auto &usage = memory.getItemTypeUsage();
+		for (size_t id = 0; id < usage.size(); ++id) {
+			if (usage[id].count > 0) {
+				report.item_types.push_back({ static_cast<uint16_t>(id), g_items.getItemType(id).name, usage[id].bytes, usage[id].count });
+			}
+		}
+		std::sort(report.item_types.begin(), report.item_types.end(), [](const MemoryReport::ItemType &a, const MemoryReport::ItemType &b) {
+			return a.bytes > b.bytes;
+		});
+		if (report.item_types.size() > max_item_types) {
+			report.item_types.resize(max_item_types);
+		}
+	}
+
+	addCategory("Sprite sheets", g_spriteAppearances.getLoadedSheetBytes(), g_spriteAppearances.getLoadedSheetCount());
+	addCategory("Decoded sprites", g_spriteAppearances.getCachedSpriteBytes(), g_spriteAppearances.getCachedSpriteCount());
+	addCategory("GL textures", g_gui.gfx.getLoadedTextureBytes(), g_gui.gfx.getLoadedTextureCount());
+
+	const SpriteCacheStatistics &sprite_cache = g_spriteAppearances.getCacheStatistics();
+	report.sprite_cache.budget_bytes = int64_t(g_settings.getInteger(Config::SPRITE_MEMORY_BUDGET)) * 1024 * 1024;
+	report.sprite_cache.sheet_hits = sprite_cache.sheet_hits;
+	report.sprite_cache.sheet_misses = sprite_cache.sheet_misses;
+	report.sprite_cache.sheet_evictions = sprite_cache.sheet_evictions;
+	report.sprite_cache.sprite_hits = sprite_cache.sprite_hits;
+	report.sprite_cache.sprite_misses = sprite_cache.sprite_misses;
+	report.sprite_cache.sprite_evictions = sprite_cache.sprite_evictions;
+	report.sprite_cache.pinned_sprites = g_spriteAppearances.getPinnedSpriteCount();
+
+	if (g_gui.copybuffer.canPaste()) {
+		const MapMemoryCounters &memory = g_gui.copybuffer.getBufferMap().memory;
+		addCategory("Copy buffer", memory.getTileBytes() + memory.getItemBytes() + memory.getAttributeBytes(), memory.getTileCount());
+	} else {
+		addCategory("Copy buffer", 0, 0);
+	}
+
+	addCategory("Minimap", g_gui.minimap ? g_gui.minimap->memsize() : 0, g_gui.minimap ? 1 : 0);
+	return report;
+}
@@ -0,0 +1,63 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MEMORY_REPORT_H_
+#define RME_MEMORY_REPORT_H_
+
+#include <nlohmann/json.hpp>
+
+class Editor;
+
+// Snapshot of the memory used by each part of the editor
+// Every figure comes from counters kept up to date by its owner, collecting a report never walks the map
+struct MemoryReport {
+	struct Category {
+		std::string name;
+		int64_t bytes = 0;
+		int64_t count = 0; // Number of objects making up the category
+	};
+	struct ItemType {
+		uint16_t id = 0;
+		std::string name;
+		int64_t bytes = 0;
+		int64_t count = 0;
+	};
+
+	// Counters of the budget shared by decoded sprite sheets and sprites
+	struct SpriteCache {
+		int64_t budget_bytes = 0;
+		uint64_t sheet_hits = 0;
+		uint64_t sheet_misses = 0;
+		uint64_t sheet_evictions = 0;
+		uint64_t sprite_hits = 0;
+		uint64_t sprite_misses = 0;
+		uint64_t sprite_evictions = 0;
+		int64_t pinned_sprites = 0;
+	};
+
+	std::vector<Category> categories;
+	std::vector<ItemType> item_types; // Item types of the current map, largest first
+	SpriteCache sprite_cache;
+
+	int64_t getTotalBytes() const;
+	nlohmann::json toJson() const;
+};
+
+// editor may be nullptr, then only the editor wide categories are filled in
+MemoryReport CollectMemoryReport(Editor* editor, size_t max_item_types = 64);
+
+#endif
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "memory_window.h"
+#include "memory_report.h"
+#include "gui.h"
+#include "gui_ids.h"
+
+namespace {
+	wxString formatMemoryBytes(int64_t bytes) {
+		if (std::abs(bytes) >= 1024 * 1024) {
+			return wxString::Format("%.1f MB", double(bytes) / (1024.0 * 1024.0));
+		}
+		return wxString::Format("%.1f KB", double(bytes) / 1024.0);
+	}
+}
+
+BEGIN_EVENT_TABLE(MemoryWindow, wxDialog)
+EVT_TIMER(wxID_ANY, MemoryWindow::OnRefreshTimer)
+EVT_BUTTON(MEMORY_WINDOW_REFRESH, MemoryWindow::OnClickRefresh)
+EVT_BUTTON(MEMORY_WINDOW_EXPORT, MemoryWindow::OnClickExport)
+END_EVENT_TABLE()
+
+MemoryWindow::MemoryWindow(wxWindow* parent) :
+	wxDialog(parent, wxID_ANY, "Memory Usage", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX),
+	refresh_timer(this) {
+	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
+
+	category_list = newd wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxSize(420, 250), wxLC_REPORT | wxLC_SINGLE_SEL);
+	category_list->AppendColumn("Category", wxLIST_FORMAT_LEFT, 180);
+	category_list->AppendColumn("Objects", wxLIST_FORMAT_RIGHT, 100);
+	category_list->AppendColumn("Size", wxLIST_FORMAT_RIGHT, 120);
+	topsizer->Add(category_list, wxSizerFlags(1).Expand().Border(wxALL, 5));
+
+	total_text = newd wxStaticText(this, wxID_ANY, "");
+	topsizer->Add(total_text, wxSizerFlags(0).Border(wxLEFT | wxRIGHT, 5));
+
+	sprite_cache_text = newd wxStaticText(this, wxID_ANY, "");
+	topsizer->Add(sprite_cache_text, wxSizerFlags(0).Border(wxLEFT | wxRIGHT | wxTOP, 5));
+
+	item_type_list = newd wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxSize(420, 200), wxLC_REPORT | wxLC_SINGLE_SEL);
+	item_type_list->AppendColumn("Item type", wxLIST_FORMAT_LEFT, 180);
+	item_type_list->AppendColumn("Count", wxLIST_FORMAT_RIGHT, 100);
+	item_type_list->AppendColumn("Size", wxLIST_FORMAT_RIGHT, 120);
+	topsizer->Add(item_type_list, wxSizerFlags(1).Expand().Border(wxALL, 5));
+
+	wxSizer* buttonsizer = newd wxBoxSizer(wxHORIZONTAL);
+	buttonsizer->Add(newd wxButton(this, MEMORY_WINDOW_REFRESH, "Refresh"), wxSizerFlags(1).Center());
+	buttonsizer->Add(newd wxButton(this, MEMORY_WINDOW_EXPORT, "Export as JSON"), wxSizerFlags(1).Center());
+	buttonsizer->Add(newd wxButton(this, wxID_CANCEL, "Close"), wxSizerFlags(1).Center());
+	topsizer->Add(buttonsizer, wxSizerFlags(0).Center().Border(wxALL, 5));
+
+	SetSizerAndFit(topsizer);
+	Centre(wxBOTH);
+
+	RefreshReport();
+	refresh_timer.Start(1000);
+}
+
+MemoryWindow::~MemoryWindow() {
+	refresh_timer.Stop();
+}
+
+void MemoryWindow::RefreshReport() {
+	const MemoryReport report = CollectMemoryReport(g_gui.GetCurrentEditor());
+
+	category_list->Freeze();
+	category_list->DeleteAllItems();
+	for (const MemoryReport::Category &category : report.categories) {
+		const long row = category_list->InsertItem(category_list->GetItemCount(), wxstr(category.name));
+		category_list->SetItem(row, 1, wxString::Format("%lld", static_cast<long long>(category.count)));
+		category_list->SetItem(row, 2, formatMemoryBytes(category.bytes));
+	}
+	category_list->Thaw();
+
+	item_type_list->Freeze();
+	item_type_list->DeleteAllItems();
+	for (const MemoryReport::ItemType &type : report.item_types) {
+		const long row = item_type_list->InsertItem(item_type_list->GetItemCount(), wxString::Format("%s (%d)", wxstr(type.name), type.id));
+		item_type_list->SetItem(row, 1, wxString::Format("%lld", static_cast<long long>(type.count)));
+		item_type_list->SetItem(row, 2, formatMemoryBytes(type.bytes));
+	}
+	item_type_list->Thaw();
+
+	total_text->SetLabel("Total: " + formatMemoryBytes(report.getTotalBytes()));
+
+	const MemoryReport::SpriteCache &cache = report.sprite_cache;
+	sprite_cache_text->SetLabel(wxString::Format(
+		"Sprite budget %s, sheets %llu hits / %llu misses / %llu evicted,\nsprites %llu hits / %llu misses / %llu evicted, %lld pinned",
+		formatMemoryBytes(cache.budget_bytes),
+		static_cast<unsigned long long>(cache.sheet_hits), static_cast<unsigned long long>(cache.sheet_misses), static_cast<unsigned long long>(cache.sheet_evictions),
+		static_cast<unsigned long long>(cache.sprite_hits), static_cast<unsigned long long>(cache.sprite_misses), static_cast<unsigned long long>(cache.sprite_evictions),
+		static_cast<long long>(cache.pinned_sprites)
+	));
+}
+
+void MemoryWindow::OnRefreshTimer(wxTimerEvent &WXUNUSED(event)) {
+	RefreshReport();
+}
+
+void MemoryWindow::OnClickRefresh(wxCommandEvent &WXUNUSED(event)) {
+	RefreshReport();
+}
+
+void MemoryWindow::OnClickExport(wxCommandEvent &WXUNUSED(event)) {
+	wxFileDialog dialog(this, "Export memory usage", "", "memory.json", "JSON files (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (dialog.ShowModal() != wxID_OK) {
+		return;
+	}
+
+	std::ofstream file(nstr(dialog.GetPath()), std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		g_gui.PopupDialog(this, "Error", "Could not open the file for writing.", wxOK);
+		return;
+	}
+	file << CollectMemoryReport(g_gui.GetCurrentEditor()).toJson().dump(2);
+}
@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MEMORY_WINDOW_H_
+#define RME_MEMORY_WINDOW_H_
+
+#include "main.h"
+
+#include <wx/listctrl.h>
+
+// Live breakdown of the memory used by the editor, refreshed every second while open
+class MemoryWindow : public wxDialog {
+public:
+	MemoryWindow(wxWindow* parent);
+	~MemoryWindow();
+
+	void OnRefreshTimer(wxTimerEvent &);
+	void OnClickRefresh(wxCommandEvent &);
+	void OnClickExport(wxCommandEvent &);
+
+private:
+	void RefreshReport();
+
+	wxListCtrl* category_list;
+	wxListCtrl* item_type_list;
+	wxStaticText* total_text;
+	wxStaticText* sprite_cache_text;
+	wxTimer refresh_timer;
+
+	DECLARE_EVENT_TABLE()
+};
+
+#endif
@@ -49,6 +49,11 @@ MinimapWindow::~MinimapWindow() {
 	}
 }
 
+size_t MinimapWindow::memsize() const {
+	const wxSize size = GetClientSize();
+	return sizeof(*this) + 256 * sizeof(wxPen) + size_t(std::max(0, size.x)) * size_t(std::max(0, size.y)) * 4;
+}
+
 void MinimapWindow::OnSize(wxSizeEvent &event) {
 	Refresh();
 }
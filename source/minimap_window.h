@@ -33,6 +33,9 @@ public:
 	void OnDelayedUpdate(wxTimerEvent &event);
 	void OnKey(wxKeyEvent &event);
 
+	// Pens and the paint back buffer
+	size_t memsize() const;
+
 protected:
 	wxPen* pens[256];
 	wxTimer update_timer;
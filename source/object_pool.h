@@ -0,0 +1,426 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_OBJECT_POOL_H_
+#define RME_OBJECT_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+struct MapPoolStatistics {
+	size_t object_size = 0;
+	size_t slabs = 0;
+	size_t capacity = 0; // Slots in all slabs
+	size_t carved = 0; // Slots that have been handed out at least once
+	size_t used = 0; // Slots currently holding a live object
+	size_t peak = 0;
+
+	size_t reservedBytes() const noexcept {
+		return capacity * object_size;
+	}
+	size_t usedBytes() const noexcept {
+		return used * object_size;
+	}
+	// Ratio of live objects to reserved slots
+	double occupancy() const noexcept {
+		return capacity == 0 ? 0.0 : double(used) / double(capacity);
+	}
+	// Ratio of freed holes to slots that have been handed out, 0 means the pool is perfectly packed
+	double fragmentation() const noexcept {
+		return carved == 0 ? 0.0 : double(carved - used) / double(carved);
+	}
+
+	MapPoolStatistics &operator+=(const MapPoolStatistics &other) noexcept {
+		slabs += other.slabs;
+		capacity += other.capacity;
+		carved += other.carved;
+		used += other.used;
+		peak += other.peak;
+		return *this;
+	}
+};
+
+// Fixed size object pool, objects are carved out of large slabs instead of
+// getting one heap allocation each. Freed slots are kept in an intrusive free
+// list and reused, and all slabs can be dropped at once with release().
+template <typename T, size_t SlabObjects = 4096>
+class MapObjectPool {
+public:
+	MapObjectPool() = default;
+	~MapObjectPool() {
+		release();
+	}
+
+	MapObjectPool(const MapObjectPool &) = delete;
+	MapObjectPool &operator=(const MapObjectPool &) = delete;
+
+	void* allocate() {
+		Slot* slot = free_list;
+		if (slot) {
+			free_list = slot->next;
+		} else {
+			if (bump == bump_end) {
+				grow();
+			}
+			slot = bump++;
+			++carved;
+		}
+
+		++used;
+		if (used > peak) {
+			peak = used;
+		}
+		return slot;
+	}
+
+	void deallocate(void* memory) noexcept {
+		if (!memory) {
+			return;
+		}
+		Slot* slot = static_cast<Slot*>(memory);
+		slot->next = free_list;
+		free_list = slot;
+		--used;
+	}
+
+	template <typename... Args>
+	T* create(Args &&... args) {
+		return new (allocate()) T(std::forward<Args>(args)...);
+	}
+
+	void destroy(T* object) {
+		if (object) {
+			object->~T();
+			deallocate(object);
+		}
+	}
+
+	// Drops every slab in one go, objects still living in the pool are NOT destroyed
+	void release() noexcept {
+		slabs.clear();
+		free_list = nullptr;
+		bump = bump_end = nullptr;
+		carved = used = 0;
+	}
+
+	MapPoolStatistics getStatistics() const noexcept {
+		MapPoolStatistics stats;
+		stats.object_size = sizeof(Slot);
+		stats.slabs = slabs.size();
+		stats.capacity = slabs.size() * SlabObjects;
+		stats.carved = carved;
+		stats.used = used;
+		stats.peak = peak;
+		return stats;
+	}
+
+private:
+	union Slot {
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	void grow() {
+		slabs.emplace_back(new Slot[SlabObjects]);
+		bump = slabs.back().get();
+		bump_end = bump + SlabObjects;
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> slabs;
+	Slot* free_list = nullptr;
+	Slot* bump = nullptr;
+	Slot* bump_end = nullptr;
+	size_t carved = 0;
+	size_t used = 0;
+	size_t peak = 0;
+};
+
+// Slab pool whose objects are freed without knowing the pool: every slab is aligned to its
+// size, so the slab an object lives in is found from its address. A slab goes back to the heap
+// as soon as it is empty (one empty slab is kept to avoid churn). Slabs still holding objects
+// when the pool is released are handed over to those objects, the last one freed drops its slab.
+// Allocating and freeing lock the pool, freeing must not race with the destruction of the pool.
+template <typename T, size_t SlabBytes = 256 * 1024>
+class SlabPool {
+	static_assert((SlabBytes & (SlabBytes - 1)) == 0, "SlabBytes must be a power of two");
+
+public:
+	SlabPool() = default;
+	~SlabPool() {
+		release();
+	}
+
+	SlabPool(const SlabPool &) = delete;
+	SlabPool &operator=(const SlabPool &) = delete;
+
+	void* allocate() {
+		std::scoped_lock lock(mutex);
+		Slab* slab = available;
+		if (!slab) {
+			slab = createSlab();
+		}
+
+		Slot* slot = slab->free_list;
+		if (slot) {
+			slab->free_list = slot->next;
+		} else {
+			slot = slab->getSlots() + slab->carved++;
+			++carved;
+		}
+		if (slab->live.fetch_add(1, std::memory_order_relaxed) == 0) {
+			--empty_slabs;
+		}
+		if (!slab->free_list && slab->carved == SlabObjects) {
+			unlinkAvailable(slab);
+		}
+
+		++used;
+		if (used > peak) {
+			peak = used;
+		}
+		return slot;
+	}
+
+	static void deallocate(void* memory) noexcept {
+		if (!memory) {
+			return;
+		}
+		Slab* slab = getSlab(memory);
+		SlabPool* owner = slab->owner.load(std::memory_order_acquire);
+		if (owner) {
+			owner->free(slab, static_cast<Slot*>(memory));
+		} else {
+			freeOrphan(slab);
+		}
+	}
+
+	// Frees the empty slabs and hands the others over to the objects still in them
+	void release() noexcept {
+		std::scoped_lock lock(mutex);
+		for (Slab* slab : slabs) {
+			if (slab->live.load(std::memory_order_acquire) == 0) {
+				destroySlab(slab);
+			} else {
+				slab->owner.store(nullptr, std::memory_order_release);
+			}
+		}
+		slabs.clear();
+		available = nullptr;
+		empty_slabs = 0;
+		carved = used = 0;
+	}
+
+	MapPoolStatistics getStatistics() const {
+		std::scoped_lock lock(mutex);
+		MapPoolStatistics stats;
+		stats.object_size = sizeof(Slot);
+		stats.slabs = slabs.size();
+		stats.capacity = slabs.size() * SlabObjects;
+		stats.carved = carved;
+		stats.used = used;
+		stats.peak = peak;
+		return stats;
+	}
+
+private:
+	union Slot {
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	// Sits at the start of its slab, the slots follow it
+	struct Slab {
+		std::atomic<SlabPool*> owner;
+		std::atomic<size_t> live;
+		size_t carved = 0;
+		size_t index = 0; // In the slabs of the owner
+		Slot* free_list = nullptr;
+		Slab* prev = nullptr; // Slabs with a free slot
+		Slab* next = nullptr;
+		bool linked = false;
+
+		Slot* getSlots() noexcept {
+			return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(this) + HeaderBytes);
+		}
+	};
+
+	static constexpr size_t HeaderBytes = (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+	static constexpr size_t SlabObjects = (SlabBytes - HeaderBytes) / sizeof(Slot);
+	static_assert(SlabObjects > 0, "SlabBytes is too small for T");
+
+	static Slab* getSlab(void* memory) noexcept {
+		return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(memory) & ~uintptr_t(SlabBytes - 1));
+	}
+
+	Slab* createSlab() {
+		void* memory = ::operator new(SlabBytes, std::align_val_t(SlabBytes));
+		Slab* slab = new (memory) Slab();
+		slab->owner.store(this, std::memory_order_relaxed);
+		slab->live.store(0, std::memory_order_relaxed);
+		slab->index = slabs.size();
+		slabs.push_back(slab);
+		++empty_slabs;
+		linkAvailable(slab);
+		return slab;
+	}
+
+	static void destroySlab(Slab* slab) noexcept {
+		slab->~Slab();
+		::operator delete(slab, std::align_val_t(SlabBytes));
+	}
+
+	static void freeOrphan(Slab* slab) noexcept {
+		if (slab->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			destroySlab(slab);
+		}
+	}
+
+	void free(Slab* slab, Slot* slot) noexcept {
+		std::unique_lock lock(mutex);
+		// Released while this thread was waiting
+		if (slab->owner.load(std::memory_order_relaxed) != this) {
+			lock.unlock();
+			freeOrphan(slab);
+			return;
+		}
+
+		slot->next = slab->free_list;
+		slab->free_list = slot;
+		--used;
+		if (!slab->linked) {
+			linkAvailable(slab);
+		}
+		if (slab->live.fetch_sub(1, std::memory_order_relaxed) != 1) {
+			return;
+		}
+
+		if (empty_slabs == 0) {
+			++empty_slabs;
+			return;
+		}
+		unlinkAvailable(slab);
+		carved -= slab->carved;
+		Slab* last = slabs.back();
+		last->index = slab->index;
+		slabs[slab->index] = last;
+		slabs.pop_back();
+		destroySlab(slab);
+	}
+
+	void linkAvailable(Slab* slab) noexcept {
+		slab->prev = nullptr;
+		slab->next = available;
+		if (available) {
+			available->prev = slab;
+		}
+		available = slab;
+		slab->linked = true;
+	}
+
+	void unlinkAvailable(Slab* slab) noexcept {
+		if (slab->prev) {
+			slab->prev->next = slab->next;
+		} else {
+			available = slab->next;
+		}
+		if (slab->next) {
+			slab->next->prev = slab->prev;
+		}
+		slab->prev = slab->next = nullptr;
+		slab->linked = false;
+	}
+
+	mutable std::mutex mutex;
+	std::vector<Slab*> slabs;
+	Slab* available = nullptr;
+	size_t empty_slabs = 0;
+	size_t carved = 0;
+	size_t used = 0;
+	size_t peak = 0;
+};
+
+// SlabPool split in shards, each thread allocates from a shard of its own so threads allocating
+// at the same time (e.g. when decoding a map) do not wait on each other. An object goes back to
+// the shard it came from.
+template <typename T, size_t SlabBytes = 256 * 1024, size_t Shards = 16>
+class ShardedSlabPool {
+public:
+	void* allocate() {
+		return shards[getShardIndex()].allocate();
+	}
+	static void deallocate(void* memory) noexcept {
+		SlabPool<T, SlabBytes>::deallocate(memory);
+	}
+
+	void release() noexcept {
+		for (SlabPool<T, SlabBytes> &shard : shards) {
+			shard.release();
+		}
+	}
+
+	MapPoolStatistics getStatistics() const {
+		MapPoolStatistics stats;
+		for (const SlabPool<T, SlabBytes> &shard : shards) {
+			const MapPoolStatistics shard_stats = shard.getStatistics();
+			stats.object_size = shard_stats.object_size;
+			stats += shard_stats;
+		}
+		return stats;
+	}
+
+private:
+	static size_t getShardIndex() noexcept {
+		static std::atomic<size_t> next_index { 0 };
+		thread_local const size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % Shards;
+		return index;
+	}
+
+	std::array<SlabPool<T, SlabBytes>, Shards> shards;
+};
+
+// Process wide ShardedSlabPool, for objects that are created and destroyed with plain new/delete
+// from anywhere in the editor
+template <typename T, size_t SlabBytes = 256 * 1024>
+class SharedObjectPool {
+public:
+	static void* allocate() {
+		return getPool().allocate();
+	}
+	static void deallocate(void* memory) noexcept {
+		ShardedSlabPool<T, SlabBytes>::deallocate(memory);
+	}
+	static MapPoolStatistics getStatistics() {
+		return getPool().getStatistics();
+	}
+
+private:
+	static ShardedSlabPool<T, SlabBytes> &getPool() {
+		// Intentionally leaked, objects may still be released by static destructors during shutdown.
+		// Its slabs are freed as soon as they are empty all the same.
+		static auto* pool = new ShardedSlabPool<T, SlabBytes>();
+		return *pool;
+	}
+};
+
+#endif
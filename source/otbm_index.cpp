@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "otbm_index.h"
+#include "filehandle.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	constexpr char OTBMIndexIdentifier[] = "OTBI";
+	// 2: stamped with the map file, no copy of the skeleton
+	constexpr uint32_t OTBMIndexVersion = 2;
+}
+
+OTBMIndex::OTBMIndex() :
+	scanner(std::make_unique<OTBMAreaScanner>(scanned_skeleton)) {
+	////
+}
+
+void OTBMIndex::feed(const uint8_t* data, size_t length) {
+	scanner->feed(data, length, stream_size);
+	stream_size += length;
+}
+
+bool OTBMIndex::finish() {
+	if (!scanner->isComplete()) {
+		return false;
+	}
+
+	// Areas without a complete base can not be looked up
+	for (const OTBMAreaScanner::Area &area : scanner->getAreas()) {
+		if (area.has_base) {
+			areas.push_back(area);
+		}
+	}
+	scanner->getAreas().clear();
+	scanned_skeleton = std::vector<uint8_t>();
+	return true;
+}
+
+void OTBMIndex::clear() {
+	scanned_skeleton.clear();
+	areas.clear();
+	scanner = std::make_unique<OTBMAreaScanner>(scanned_skeleton);
+	stream_size = 0;
+}
+
+OTBMIndex::FileStamp OTBMIndex::getFileStamp(const std::string &map_filename) {
+	std::error_code error;
+	const uintmax_t size = fs::file_size(map_filename, error);
+	if (error) {
+		return FileStamp();
+	}
+	const fs::file_time_type modified = fs::last_write_time(map_filename, error);
+	if (error) {
+		return FileStamp();
+	}
+
+	FileStamp stamp;
+	stamp.size = size;
+	stamp.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+	return stamp;
+}
+
+bool OTBMIndex::load(const std::string &map_filename, uint64_t expected_stream_size) {
+	clear();
+
+	const FileStamp stamp = getFileStamp(map_filename);
+	if (stamp.size == 0) {
+		return false;
+	}
+
+	FileReadHandle f(getFilename(map_filename));
+	char identifier[4];
+	uint32_t version;
+	uint64_t map_size, map_modified;
+	uint32_t area_count;
+	if (!f.isOk() || !f.getRAW(reinterpret_cast<uint8_t*>(identifier), 4) || memcmp(identifier, OTBMIndexIdentifier, 4) != 0) {
+		return false;
+	}
+	if (!f.getU32(version) || version != OTBMIndexVersion || !f.getU64(stream_size) || stream_size != expected_stream_size) {
+		return false;
+	}
+	// Written for another version of the map file
+	if (!f.getU64(map_size) || !f.getU64(map_modified) || map_size != stamp.size || static_cast<int64_t>(map_modified) != stamp.modified) {
+		return false;
+	}
+	if (!f.getU32(area_count)) {
+		return false;
+	}
+
+	areas.reserve(area_count);
+	for (uint32_t i = 0; i < area_count; ++i) {
+		OTBMAreaScanner::Area &area = areas.emplace_back();
+		uint16_t x, y;
+		uint8_t z;
+		if (!f.getU64(area.offset) || !f.getU64(area.size) || !f.getU16(x) || !f.getU16(y) || !f.getU8(z)) {
+			clear();
+			return false;
+		}
+		area.has_base = true;
+		area.base_x = x;
+		area.base_y = y;
+		area.base_z = z;
+	}
+	return true;
+}
+
+bool OTBMIndex::save(const std::string &map_filename) const {
+	const FileStamp stamp = getFileStamp(map_filename);
+	if (stamp.size == 0) {
+		return false;
+	}
+
+	FileWriteHandle f(getFilename(map_filename));
+	if (!f.isOk()) {
+		return false;
+	}
+
+	f.addRAW(OTBMIndexIdentifier);
+	f.addU32(OTBMIndexVersion);
+	f.addU64(stream_size);
+	f.addU64(stamp.size);
+	f.addU64(static_cast<uint64_t>(stamp.modified));
+	f.addU32(static_cast<uint32_t>(areas.size()));
+	for (const OTBMAreaScanner::Area &area : areas) {
+		f.addU64(area.offset);
+		f.addU64(area.size);
+		f.addU16(area.base_x);
+		f.addU16(area.base_y);
+		f.addU8(area.base_z);
+	}
+	f.flush();
+	return f.isOk();
+}
+
+std::vector<OTBMAreaScanner::Area> OTBMIndex::findAreas(const Position &from, const Position &to) const {
+	const int min_x = std::min(from.x, to.x);
+	const int min_y = std::min(from.y, to.y);
+	const int min_z = std::min(from.z, to.z);
+	const int max_x = std::max(from.x, to.x);
+	const int max_y = std::max(from.y, to.y);
+	const int max_z = std::max(from.z, to.z);
+
+	std::vector<OTBMAreaScanner::Area> found;
+	for (const OTBMAreaScanner::Area &area : areas) {
+		// The tiles of an area lie within 256 tiles of its base
+		if (area.base_z < min_z || area.base_z > max_z) {
+			continue;
+		}
+		if (area.base_x > max_x || area.base_x + 255 < min_x || area.base_y > max_y || area.base_y + 255 < min_y) {
+			continue;
+		}
+		found.push_back(area);
+	}
+	return found;
+}
+
+bool OTBMIndex::matches(const std::vector<OTBMAreaScanner::Area> &areas, const uint8_t* data, size_t size) {
+	for (const OTBMAreaScanner::Area &area : areas) {
+		if (area.size < 2 || area.offset + area.size > size) {
+			return false;
+		}
+		const uint8_t* node = data + area.offset;
+		if (node[0] != NODE_START || node[1] != OTBM_TILE_AREA || node[area.size - 1] != NODE_END) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool OTBMIndex::readSkeleton(const uint8_t* data, size_t size, std::vector<uint8_t> &skeleton) const {
+	skeleton.clear();
+	uint64_t position = 0;
+	for (const OTBMAreaScanner::Area &area : areas) {
+		if (area.offset < position || area.offset + area.size > size) {
+			skeleton.clear();
+			return false;
+		}
+		skeleton.insert(skeleton.end(), data + position, data + area.offset);
+		position = area.offset + area.size;
+	}
+	skeleton.insert(skeleton.end(), data + position, data + size);
+	return true;
+}
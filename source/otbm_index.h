@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_OTBM_INDEX_H_
+#define RME_OTBM_INDEX_H_
+
+#include "iomap_otbm.h"
+
+// Where every tile area of an OTBM file is, kept in a sidecar file next to the map so that a part
+// of it can be read without scanning the whole file. Offsets count from the first byte after the
+// identifier. The index is stamped with the size and modification time of the map file it was
+// written for. Every byte outside the tile areas (the map header, towns and waypoints) is read from
+// the map file itself and reads like a map without tiles.
+class OTBMIndex {
+public:
+	static std::string getFilename(const std::string &map_filename) {
+		return map_filename + ".idx";
+	}
+
+	OTBMIndex();
+
+	OTBMIndex(const OTBMIndex &) = delete;
+	OTBMIndex &operator=(const OTBMIndex &) = delete;
+
+	// Builds the index from the node stream of a map file, fed in order in chunks of any size
+	void feed(const uint8_t* data, size_t length);
+	// Whether the stream fed so far is a complete map, the index can only be used or saved then
+	bool finish();
+	void clear();
+
+	// Reads the index next to the map file, fails when there is none or it was written for another
+	// version of the file
+	bool load(const std::string &map_filename, uint64_t stream_size);
+	// Writes the index next to the map file, which must be complete and closed
+	bool save(const std::string &map_filename) const;
+
+	// The tile areas that may hold tiles inside the box, on the floors from.z to to.z
+	std::vector<OTBMAreaScanner::Area> findAreas(const Position &from, const Position &to) const;
+	// Whether every area starts and ends where the index says in the node stream
+	static bool matches(const std::vector<OTBMAreaScanner::Area> &areas, const uint8_t* data, size_t size);
+
+	// Copies every byte of the node stream outside the indexed tile areas, false if they do not fit it
+	bool readSkeleton(const uint8_t* data, size_t size, std::vector<uint8_t> &skeleton) const;
+
+	const std::vector<OTBMAreaScanner::Area> &getAreas() const noexcept {
+		return areas;
+	}
+
+private:
+	// Size and modification time of a map file, both 0 when it can not be read
+	struct FileStamp {
+		uint64_t size = 0;
+		int64_t modified = 0;
+	};
+	static FileStamp getFileStamp(const std::string &map_filename);
+
+	// Only filled while the index is built, it is read from the map file afterwards
+	std::vector<uint8_t> scanned_skeleton;
+	std::vector<OTBMAreaScanner::Area> areas;
+	std::unique_ptr<OTBMAreaScanner> scanner;
+	uint64_t stream_size = 0;
+};
+
+#endif
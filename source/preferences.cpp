@@ -96,6 +96,21 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	use_old_item_properties_window->SetToolTip("Enables the use of the old item properties window");
 	sizer->Add(use_old_item_properties_window, 0, wxLEFT | wxTOP, 5);
 
+	incremental_save_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Only re-encode changed areas when saving");
+	incremental_save_chkbox->SetValue(g_settings.getBoolean(Config::INCREMENTAL_SAVE));
+	incremental_save_chkbox->SetToolTip("Keeps the saved form of every 256x256 area in memory, so the next save only encodes the areas edited since. Uses about as much memory as the map file, for every open map.");
+	sizer->Add(incremental_save_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	background_save_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Save in the background");
+	background_save_chkbox->SetValue(g_settings.getBoolean(Config::BACKGROUND_SAVE));
+	background_save_chkbox->SetToolTip("Only the changed areas are encoded when saving, the files are written while you keep editing. Compressed and paged maps are always saved in the foreground.");
+	sizer->Add(background_save_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	otbm_index_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Write a tile area index next to the map");
+	otbm_index_chkbox->SetValue(g_settings.getBoolean(Config::SAVE_OTBM_INDEX));
+	otbm_index_chkbox->SetToolTip("Saves where every tile area is in a .otbm.idx file, so that parts of the map can be read without reading the whole file.");
+	sizer->Add(otbm_index_chkbox, 0, wxLEFT | wxTOP, 5);
+
 	sizer->AddSpacer(10);
 
 	auto* grid_sizer = newd wxFlexGridSizer(2, 10, 10);
@@ -126,6 +141,16 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	grid_sizer->Add(delete_backup_days_spin, 0);
 	SetWindowToolTip(tmptext, delete_backup_days_spin, "Configure the number of days after which backups will be automatically deleted.");
 
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Load maps on demand above (MB): "), 0);
+	paged_map_threshold_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::PAGED_MAP_THRESHOLD)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 0x100000);
+	grid_sizer->Add(paged_map_threshold_spin, 0);
+	SetWindowToolTip(tmptext, paged_map_threshold_spin, "Maps larger than this are only indexed when opened, and their areas are read as they are viewed or edited. 0 always loads the whole map.");
+
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "On demand map memory budget (MB): "), 0);
+	paged_map_budget_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::PAGED_MAP_MEMORY_BUDGET)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 64, 0x100000);
+	grid_sizer->Add(paged_map_budget_spin, 0);
+	SetWindowToolTip(tmptext, paged_map_budget_spin, "Areas of a map loaded on demand that were not edited are dropped again once the tiles use more than this.");
+
 	sizer->Add(grid_sizer, 0, wxALL, 5);
 	sizer->AddSpacer(10);
 
@@ -260,6 +285,11 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	sizer->Add(icon_selection_shadow_chkbox, 0, wxLEFT | wxTOP, 5);
 	SetWindowToolTip(icon_selection_shadow_chkbox, "When this option is checked, selected items in the palette menu will be shaded.");
 
+	sprite_sheet_cache_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Cache decoded sprite sheets");
+	sprite_sheet_cache_chkbox->SetValue(g_settings.getBoolean(Config::SPRITE_SHEET_CACHE));
+	sizer->Add(sprite_sheet_cache_chkbox, 0, wxLEFT | wxTOP, 5);
+	SetWindowToolTip(sprite_sheet_cache_chkbox, "When this option is checked, decompressed client sprite sheets are kept in a file in the user data directory so the next start does not decompress them again.\nThe file can take a few gigabytes for recent clients and is written in the background the first time, which decompresses every sheet once more. Takes effect when the client is loaded again.");
+
 	sizer->AddSpacer(5);
 
 	auto* subsizer = newd wxFlexGridSizer(2, 10, 10);
@@ -333,6 +363,11 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	subsizer->Add(screenshot_format_choice, 0);
 	SetWindowToolTip(screenshot_format_choice, tmp, "This will affect the screenshot format used by the editor.\nTo take a screenshot, press F11.");
 
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Sprite memory budget (MB): "), 0);
+	sprite_memory_budget_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::SPRITE_MEMORY_BUDGET)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 32, 0x100000);
+	subsizer->Add(sprite_memory_budget_spin, 0);
+	SetWindowToolTip(sprite_memory_budget_spin, tmp, "Decompressed sprite sheets and sprites that were not used for a while are dropped once they take more than this. They are decompressed again when needed.");
+
 	sizer->Add(subsizer, 1, wxEXPAND | wxALL, 5);
 
 	// Advanced g_settings
@@ -610,6 +645,11 @@ void PreferencesWindow::Apply() {
 	g_settings.setInteger(Config::WORKER_THREADS, worker_threads_spin->GetValue());
 	g_settings.setInteger(Config::REPLACE_SIZE, replace_size_spin->GetValue());
 	g_settings.setInteger(Config::DELETE_BACKUP_DAYS, delete_backup_days_spin->GetValue());
+	g_settings.setInteger(Config::PAGED_MAP_THRESHOLD, paged_map_threshold_spin->GetValue());
+	g_settings.setInteger(Config::PAGED_MAP_MEMORY_BUDGET, paged_map_budget_spin->GetValue());
+	g_settings.setInteger(Config::INCREMENTAL_SAVE, incremental_save_chkbox->GetValue());
+	g_settings.setInteger(Config::BACKGROUND_SAVE, background_save_chkbox->GetValue());
+	g_settings.setInteger(Config::SAVE_OTBM_INDEX, otbm_index_chkbox->GetValue());
 	g_settings.setInteger(Config::COPY_POSITION_FORMAT, position_format->GetSelection());
 	g_settings.setInteger(Config::COPY_AREA_FORMAT, area_format->GetSelection());
 	if (g_settings.getBoolean(Config::SHOW_TILESET_EDITOR) != enable_tileset_editing_chkbox->GetValue()) {
@@ -678,6 +718,8 @@ void PreferencesWindow::Apply() {
 	// g_settings.setInteger(Config::CURSOR_ALT_ALPHA, clr.Alpha());
 
 	g_settings.setInteger(Config::HIDE_ITEMS_WHEN_ZOOMED, hide_items_when_zoomed_chkbox->GetValue());
+	g_settings.setInteger(Config::SPRITE_SHEET_CACHE, sprite_sheet_cache_chkbox->GetValue());
+	g_settings.setInteger(Config::SPRITE_MEMORY_BUDGET, sprite_memory_budget_spin->GetValue());
 	/*
 	g_settings.setInteger(Config::TEXTURE_MANAGEMENT, texture_managment_chkbox->GetValue());
 	g_settings.setInteger(Config::TEXTURE_CLEAN_PULSE, clean_interval_spin->GetValue());
@@ -49,11 +49,16 @@ protected:
 	wxCheckBox* show_welcome_dialog_chkbox;
 	wxCheckBox* enable_tileset_editing_chkbox;
 	wxCheckBox* use_old_item_properties_window;
+	wxCheckBox* incremental_save_chkbox;
+	wxCheckBox* background_save_chkbox;
+	wxCheckBox* otbm_index_chkbox;
 	wxSpinCtrl* undo_size_spin;
 	wxSpinCtrl* undo_mem_size_spin;
 	wxSpinCtrl* worker_threads_spin;
 	wxSpinCtrl* replace_size_spin;
 	wxSpinCtrl* delete_backup_days_spin;
+	wxSpinCtrl* paged_map_threshold_spin;
+	wxSpinCtrl* paged_map_budget_spin;
 	wxRadioBox* position_format;
 	wxRadioBox* area_format;
 
@@ -78,6 +83,8 @@ protected:
 	wxDirPickerCtrl* screenshot_directory_picker;
 	wxChoice* screenshot_format_choice;
 	wxCheckBox* hide_items_when_zoomed_chkbox;
+	wxCheckBox* sprite_sheet_cache_chkbox;
+	wxSpinCtrl* sprite_memory_budget_spin;
 	wxColourPickerCtrl* cursor_color_pick;
 	wxColourPickerCtrl* cursor_alt_color_pick;
 	wxTextCtrl* palette_icons_col_size;
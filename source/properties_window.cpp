@@ -418,11 +418,11 @@ void PropertiesWindow::setBasicAttributes() {
 	const auto uid = simpleUniqueIdField->GetValue();
 
 	if (aid > 0) {
-		edit_item->setAttribute("aid", ItemAttribute(aid));
+		edit_item->setAttribute(ItemAttributeKey::ActionId, ItemAttribute(aid));
 	}
 
 	if (uid > 0) {
-		edit_item->setAttribute("uid", ItemAttribute(uid));
+		edit_item->setAttribute(ItemAttributeKey::UniqueId, ItemAttribute(uid));
 	}
 }
 
@@ -89,10 +89,12 @@ void Selection::add(const Tile* tile, Item* item) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
-	item->select();
+	// Make a copy of the tile with the item selected, the item itself may be a record shared
+	// with other tiles (see Item::compact) and is left alone
 	Tile* new_tile = tile->deepCopy(editor.getMap());
-	item->deselect();
+	if (Item* copy = new_tile->getItemAt(tile->getIndexOf(item))) {
+		copy->select();
+	}
 
 	if (g_settings.getInteger(Config::BORDER_IS_GROUND)) {
 		if (item->isBorder()) {
@@ -202,11 +204,9 @@ void Selection::remove(Tile* tile, Item* item) {
 	ASSERT(tile);
 	ASSERT(item);
 
-	bool selected = item->isSelected();
-	item->deselect();
 	Tile* new_tile = tile->deepCopy(editor.getMap());
-	if (selected) {
-		item->select();
+	if (Item* copy = new_tile->getItemAt(tile->getIndexOf(item))) {
+		copy->deselect();
 	}
 	if (item->isBorder() && g_settings.getInteger(Config::BORDER_IS_GROUND)) {
 		new_tile->deselectGround();
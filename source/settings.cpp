@@ -273,6 +273,11 @@ void Settings::IO(IOMode mode) {
 	Int(SAVE_WITH_OTB_MAGIC_NUMBER, 0);
 	Int(REPLACE_SIZE, 500);
 	Int(DELETE_BACKUP_DAYS, 0);
+	Int(PAGED_MAP_THRESHOLD, 0);
+	Int(PAGED_MAP_MEMORY_BUDGET, 2048);
+	Int(INCREMENTAL_SAVE, 0);
+	Int(BACKGROUND_SAVE, 0);
+	Int(SAVE_OTBM_INDEX, 0);
 	Int(COPY_POSITION_FORMAT, 0);
 	Int(COPY_AREA_FORMAT, 0);
 
@@ -286,6 +291,8 @@ void Settings::IO(IOMode mode) {
 	Int(ICON_BACKGROUND, 0);
 	Int(HARD_REFRESH_RATE, 200);
 	Int(HIDE_ITEMS_WHEN_ZOOMED, 1);
+	Int(SPRITE_SHEET_CACHE, 0);
+	Int(SPRITE_MEMORY_BUDGET, 512);
 	String(SCREENSHOT_DIRECTORY, "");
 	String(SCREENSHOT_FORMAT, "png");
 	Int(MINIMAP_UPDATE_DELAY, 333);
@@ -64,6 +64,8 @@ namespace Config {
 		SHOW_ONLY_TILEFLAGS,
 		SHOW_ONLY_MODIFIED_TILES,
 		HIDE_ITEMS_WHEN_ZOOMED,
+		SPRITE_SHEET_CACHE,
+		SPRITE_MEMORY_BUDGET,
 		GROUP_ACTIONS,
 		SCROLL_SPEED,
 		ZOOM_SPEED,
@@ -93,6 +95,11 @@ namespace Config {
 		SAVE_WITH_OTB_MAGIC_NUMBER,
 		REPLACE_SIZE,
 		DELETE_BACKUP_DAYS,
+		PAGED_MAP_THRESHOLD,
+		PAGED_MAP_MEMORY_BUDGET,
+		INCREMENTAL_SAVE,
+		BACKGROUND_SAVE,
+		SAVE_OTBM_INDEX,
 
 		USE_OLD_ITEM_PROPERTIES_WINDOW,
 		USE_LARGE_CONTAINER_ICONS,
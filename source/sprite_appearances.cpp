@@ -18,9 +18,11 @@
 #include "main.h"
 
 #include "sprite_appearances.h"
+#include "sprite_sheet_cache.h"
 #include "settings.h"
 #include "filehandle.h"
 #include "gui.h"
+#include "thread_pool.h"
 
 #include <lzma.h>
 
@@ -33,7 +35,12 @@ void SpriteAppearances::init() {
 	sheets.reserve(4000);
 }
 
+SpriteAppearances::~SpriteAppearances() {
+	stopDecoders();
+}
+
 void SpriteAppearances::terminate() {
+	stopDecoders();
 	unload();
 }
 
@@ -45,16 +52,19 @@ bool SpriteAppearances::loadCatalogContent(const std::string &dir, bool loadData
 		return false;
 	}
 
-	std::ifstream file(catalogPath, std::ios::in);
+	std::ifstream file(catalogPath, std::ios::in | std::ios::binary);
 	if (!file.is_open()) {
 		spdlog::error("Unable to open catalog-content.json.");
 		return false;
 	}
 
-	json document = json::parse(file, nullptr, false);
+	// Kept as text, the sheet cache is keyed by its hash
+	const std::string catalog((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	json document = json::parse(catalog, nullptr, false);
 
 	file.close();
 
+	std::vector<SpriteSheetPtr> catalogSheets;
 	for (const auto &obj : document) {
 		const auto &type = obj["type"];
 		if (type == "appearances") {
@@ -64,29 +74,97 @@ bool SpriteAppearances::loadCatalogContent(const std::string &dir, bool loadData
 
 			SpriteSheetPtr sheet = SpriteSheetPtr(new SpriteSheet(obj["firstspriteid"].get<int>(), lastSpriteId, static_cast<SpriteLayout>(obj["spritetype"].get<int>()), (fs::path(dir) / fs::path(obj["file"].get<std::string>())).string()));
 			sheets.push_back(sheet);
+			catalogSheets.push_back(sheet);
 
 			spritesCount = std::max<int>(spritesCount, lastSpriteId);
+		}
+	}
 
-			if (loadData) {
-				if (!loadSpriteSheet(sheet)) {
-					spdlog::error("[SpriteAppearances::loadCatalogContent] - Unable to load sprite sheet");
-					return false;
-				}
-			}
+	if (g_settings.getBoolean(Config::SPRITE_SHEET_CACHE)) {
+		openSheetCache(dir, catalog, catalogSheets);
+	}
+
+	if (!loadData) {
+		return true;
+	}
+
+	// Sheets mapped from the cache are loaded already
+	std::erase_if(catalogSheets, [](const SpriteSheetPtr &sheet) { return sheet->loaded; });
+
+	// Every sheet is decoded on its own, so they are spread over all threads
+	std::vector<std::unique_ptr<uint8_t[]>> decoded(catalogSheets.size());
+	ThreadPool::getInstance().parallelFor(catalogSheets.size(), 1, [&](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i) {
+			decoded[i] = decodeSpriteSheet(catalogSheets[i]->path);
+		}
+	});
+
+	for (size_t i = 0; i < catalogSheets.size(); ++i) {
+		if (!decoded[i]) {
+			spdlog::error("[SpriteAppearances::loadCatalogContent] - Unable to load sprite sheet");
+			return false;
 		}
+		installSheet(catalogSheets[i], std::move(decoded[i]));
 	}
 	return true;
 }
 
+void SpriteAppearances::openSheetCache(const std::string &dir, const std::string &catalog, const std::vector<SpriteSheetPtr> &catalogSheets) {
+	// One cache per assets directory, so switching between clients does not rebuild it every time
+	const fs::path directory = fs::path(g_gui.GetLocalDataDirectory().ToStdString()) / "cache";
+	std::error_code error;
+	fs::create_directories(directory, error);
+	if (error) {
+		spdlog::warn("Could not create sprite sheet cache directory {}: {}", directory.string(), error.message());
+		return;
+	}
+
+	const std::string assets = fs::absolute(dir, error).lexically_normal().string();
+	const fs::path path = directory / fmt::format("sprites-{:016x}.bin", SpriteSheetCache::hash(assets.data(), assets.size()));
+	sheet_cache = std::make_unique<SpriteSheetCache>(path.string(), &SpriteAppearances::decodeSpriteSheet);
+
+	std::vector<SpriteSheetCache::Entry> entries;
+	entries.reserve(catalogSheets.size());
+	for (const SpriteSheetPtr &sheet : catalogSheets) {
+		entries.push_back(SpriteSheetCache::makeEntry(sheet->path));
+	}
+
+	const std::vector<const uint8_t*> pixels = sheet_cache->open(SpriteSheetCache::hash(catalog.data(), catalog.size()), std::move(entries));
+	size_t mapped = 0;
+	for (size_t i = 0; i < catalogSheets.size(); ++i) {
+		if (pixels[i]) {
+			catalogSheets[i]->pixels = pixels[i];
+			catalogSheets[i]->loaded = true;
+			++mapped;
+		}
+	}
+	loaded_sheet_count += mapped;
+	spdlog::info("{} of {} sprite sheets mapped from {}", mapped, catalogSheets.size(), path.string());
+
+	if (sheet_cache->needsRebuild()) {
+		sheet_cache->startRebuild();
+	}
+}
+
 bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	if (sheet->loaded) {
 		return false;
 	}
 
-	std::ifstream file(sheet->path, std::ios::binary | std::ios::in);
+	std::unique_ptr<uint8_t[]> data = decodeSpriteSheet(sheet->path);
+	if (!data) {
+		return false;
+	}
+
+	installSheet(sheet, std::move(data));
+	return true;
+}
+
+std::unique_ptr<uint8_t[]> SpriteAppearances::decodeSpriteSheet(const std::string &path) {
+	std::ifstream file(path, std::ios::binary | std::ios::in);
 	if (!file.is_open()) {
 		spdlog::error("[SpriteAppearances::loadSpriteSheet] - Unable to open given sheets files");
-		return false;
+		return nullptr;
 	}
 
 	std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), (std::istreambuf_iterator<char>()));
@@ -138,7 +216,7 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	lzma_ret ret = lzma_raw_decoder(&stream, filters);
 	if (ret != LZMA_OK) {
 		spdlog::error("Failed to initialize lzma raw decoder result: {}", static_cast<int>(ret));
-		return false;
+		return nullptr;
 	}
 
 	std::unique_ptr<uint8_t[]> decompressed = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE); // uncompressed size, bmp file + 122 bytes header
@@ -151,7 +229,8 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	ret = lzma_code(&stream, LZMA_RUN);
 	if (ret != LZMA_STREAM_END) {
 		spdlog::error("Failed to decode lzma buffer result: {}", static_cast<int>(ret));
-		return false;
+		lzma_end(&stream);
+		return nullptr;
 	}
 
 	lzma_end(&stream); // free memory
@@ -170,16 +249,205 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 		std::swap_ranges(itr1, itr1 + SPRITE_SHEET_WIDTH_BYTES, itr2);
 	}
 
-	sheet->data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
-	std::memcpy(sheet->data.get(), pixelData, BYTES_IN_SPRITE_SHEET);
+	std::unique_ptr<uint8_t[]> data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
+	std::memcpy(data.get(), pixelData, BYTES_IN_SPRITE_SHEET);
+	return data;
+}
 
+void SpriteAppearances::installSheet(const SpriteSheetPtr &sheet, std::unique_ptr<uint8_t[]> data) {
+	sheet->data = std::move(data);
+	sheet->pixels = sheet->data.get();
 	sheet->loaded = true;
-	return true;
+	loaded_sheet_count += 1;
+	loaded_sheet_bytes += LZMA_UNCOMPRESSED_SIZE;
+
+	cache_entries.push_front({ sheet, 0, LZMA_UNCOMPRESSED_SIZE });
+	cached_sheets[sheet.get()] = cache_entries.begin();
+	trimCache();
+}
+
+void SpriteAppearances::touchSheet(const SpriteSheet* sheet) {
+	const auto it = cached_sheets.find(sheet);
+	if (it != cached_sheets.end()) {
+		cache_entries.splice(cache_entries.begin(), cache_entries, it->second);
+	}
+}
+
+void SpriteAppearances::trimCache() {
+	const int64_t budget = int64_t(g_settings.getInteger(Config::SPRITE_MEMORY_BUDGET)) * 1024 * 1024;
+
+	// Every entry but the newest is looked at once at most, pinned ones move to the front
+	size_t remaining = cache_entries.size();
+	while (loaded_sheet_bytes + cached_sprite_bytes > budget && remaining-- > 1) {
+		const CacheList::iterator oldest = std::prev(cache_entries.end());
+		if (oldest->sheet) {
+			evictSheet(oldest->sheet);
+			cached_sheets.erase(oldest->sheet.get());
+		} else {
+			const auto it = sprites.find(oldest->sprite_id);
+			if (it->second.sprite.use_count() > 1) {
+				cache_entries.splice(cache_entries.begin(), cache_entries, oldest);
+				continue;
+			}
+			cached_sprite_bytes -= oldest->bytes;
+			sprites.erase(it);
+			++cache_statistics.sprite_evictions;
+		}
+		cache_entries.erase(oldest);
+	}
+}
+
+void SpriteAppearances::evictSheet(const SpriteSheetPtr &sheet) {
+	// Loaded again by the next request
+	sheet->data.reset();
+	sheet->pixels = nullptr;
+	sheet->loaded = false;
+	sheet->requested = false;
+	loaded_sheet_count -= 1;
+	loaded_sheet_bytes -= LZMA_UNCOMPRESSED_SIZE;
+	++cache_statistics.sheet_evictions;
+}
+
+size_t SpriteAppearances::getPinnedSpriteCount() const {
+	size_t count = 0;
+	for (const auto &[id, cached] : sprites) {
+		if (cached.sprite.use_count() > 1) {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool SpriteAppearances::requestSheet(int spriteId) {
+	const SpriteSheetPtr sheet = getSheetBySpriteId(spriteId, false);
+	if (!sheet) {
+		return true;
+	}
+	if (sheet->loaded) {
+		touchSheet(sheet.get());
+		return true;
+	}
+	if (sheet->requested) {
+		return false;
+	}
+
+	sheet->requested = true;
+	++cache_statistics.sheet_misses;
+	if (decoders.empty()) {
+		startDecoders();
+	}
+	{
+		std::lock_guard<std::mutex> lock(decode_mutex);
+		decode_queue.push_back(sheet);
+	}
+	decode_ready.notify_one();
+	return false;
+}
+
+void SpriteAppearances::startDecoders() {
+	// Leaves a core to the GUI thread
+	const unsigned int hardware = std::thread::hardware_concurrency();
+	const size_t count = std::clamp<size_t>(hardware > 1 ? hardware - 1 : 1, 1, 8);
+
+	stopping_decoders = false;
+	decoders.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		decoders.emplace_back([this]() { decoderLoop(); });
+	}
+}
+
+void SpriteAppearances::stopDecoders() {
+	{
+		std::lock_guard<std::mutex> lock(decode_mutex);
+		stopping_decoders = true;
+		decode_queue.clear();
+	}
+	decode_ready.notify_all();
+
+	for (std::thread &decoder : decoders) {
+		decoder.join();
+	}
+	decoders.clear();
+}
+
+void SpriteAppearances::decoderLoop() {
+	while (true) {
+		SpriteSheetPtr sheet;
+		uint64_t generation;
+		{
+			std::unique_lock<std::mutex> lock(decode_mutex);
+			decode_ready.wait(lock, [this]() { return stopping_decoders || !decode_queue.empty(); });
+			if (stopping_decoders) {
+				return;
+			}
+			sheet = std::move(decode_queue.front());
+			decode_queue.pop_front();
+			generation = decode_generation;
+		}
+
+		std::unique_ptr<uint8_t[]> data = decodeSpriteSheet(sheet->path);
+
+		bool first = false;
+		{
+			std::lock_guard<std::mutex> lock(decode_mutex);
+			first = decoded_sheets.empty();
+			decoded_sheets.push_back({ std::move(sheet), std::move(data), generation });
+		}
+
+		// One call collects everything decoded until it runs
+		if (first && wxTheApp) {
+			wxTheApp->CallAfter([]() {
+				g_spriteAppearances.collectDecodedSheets();
+			});
+		}
+	}
+}
+
+void SpriteAppearances::collectDecodedSheets() {
+	std::vector<DecodedSheet> decoded;
+	{
+		std::lock_guard<std::mutex> lock(decode_mutex);
+		decoded.swap(decoded_sheets);
+	}
+
+	bool installed = false;
+	for (DecodedSheet &entry : decoded) {
+		// A failed sheet stays requested, it is not tried again until the assets are reloaded
+		if (entry.generation != decode_generation || !entry.data || entry.sheet->loaded) {
+			continue;
+		}
+		installSheet(entry.sheet, std::move(entry.data));
+		installed = true;
+	}
+
+	if (installed) {
+		for (wxWindow* window : wxTopLevelWindows) {
+			window->Refresh();
+		}
+	}
 }
 
 void SpriteAppearances::unload() {
+	{
+		std::lock_guard<std::mutex> lock(decode_mutex);
+		decode_queue.clear();
+		decoded_sheets.clear();
+		++decode_generation;
+	}
+
 	spritesCount = 0;
+	cache_entries.clear();
+	cached_sheets.clear();
 	sheets.clear();
+	// After the sheets, some of them point into it
+	sheet_cache.reset();
+	loaded_sheet_count = 0;
+	loaded_sheet_bytes = 0;
+
+	// Sprites of the old assets, images holding one keep it alive
+	sprites.clear();
+	cached_sprite_bytes = 0;
+	cache_statistics = {};
 }
 
 SpriteSheetPtr SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true */) {
@@ -197,8 +465,14 @@ SpriteSheetPtr SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true
 	}
 
 	const SpriteSheetPtr &sheet = *sheetIt;
-	if (load && !sheet->loaded) {
-		loadSpriteSheet(sheet);
+	if (load) {
+		if (sheet->loaded) {
+			++cache_statistics.sheet_hits;
+			touchSheet(sheet.get());
+		} else {
+			++cache_statistics.sheet_misses;
+			loadSpriteSheet(sheet);
+		}
 	}
 
 	return sheet;
@@ -265,8 +539,11 @@ SpritePtr SpriteAppearances::getSprite(int spriteId) {
 	auto it = sprites.find(spriteId);
 	if (it != sprites.end()) {
 		spdlog::debug("Sprite {} found in cache.", spriteId);
-		return it->second;
+		++cache_statistics.sprite_hits;
+		cache_entries.splice(cache_entries.begin(), cache_entries, it->second.entry);
+		return it->second.sprite;
 	}
+	++cache_statistics.sprite_misses;
 
 	// Retrieve sprite sheet
 	const auto &sheet = getSheetBySpriteId(spriteId);
@@ -310,8 +587,8 @@ SpritePtr SpriteAppearances::getSprite(int spriteId) {
 		return nullptr;
 	}
 
-	// Validate memory for sheet->data
-	if (!sheet->data) {
+	// Validate memory for sheet->pixels
+	if (!sheet->pixels) {
 		spdlog::error("Sheet data is null for sprite {}.", spriteId);
 		return nullptr;
 	}
@@ -338,7 +615,7 @@ SpritePtr SpriteAppearances::getSprite(int spriteId) {
 			return nullptr;
 		}
 
-		auto bufferData = &sheet->data[bufferDataStart];
+		auto bufferData = &sheet->pixels[bufferDataStart];
 		auto dest = &sprite->pixels[offset * spriteWidthBytes];
 
 		// Copy data using std::ranges::copy
@@ -346,7 +623,12 @@ SpritePtr SpriteAppearances::getSprite(int spriteId) {
 	}
 
 	// Cache the sprite
-	sprites[spriteId] = sprite;
+	const int64_t bytes = sizeof(Sprites) + sprite->pixels.capacity();
+	cache_entries.push_front({ nullptr, spriteId, bytes });
+	sprites[spriteId] = { sprite, cache_entries.begin() };
+	cached_sprite_bytes += bytes;
+	// The sprite is held here, so it is pinned while the cache is trimmed
+	trimCache();
 
 	return sprite;
 }
@@ -22,7 +22,15 @@
 #include "main.h"
 #include "graphics.h"
 
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 class GameSprite;
+class SpriteSheetCache;
 
 // APPEARANCES
 #define LZMA_UNCOMPRESSED_SIZE BYTES_IN_SPRITE_SHEET + 122
@@ -136,7 +144,7 @@ public:
 	}
 
 	bool exportSheetImage(const std::string &file, bool fixMagenta = false) {
-		wxImage image(384, 384, data.get(), true);
+		wxImage image(384, 384, const_cast<uint8_t*>(pixels), true);
 		return image.SaveFile(wxString(file), wxBITMAP_TYPE_PNG);
 	};
 
@@ -144,16 +152,29 @@ public:
 	int lastId = 0;
 	SpriteLayout spriteLayout = SpriteLayout::ONE_BY_ONE;
 	std::unique_ptr<uint8_t[]> data;
+	const uint8_t* pixels = nullptr; // data, or the block of the sheet in the sheet cache
 	std::string path;
 	bool loaded = false;
+	bool requested = false; // Queued for the decoder threads, once
 };
 
 using SpritePtr = std::shared_ptr<Sprites>;
 using SpriteSheetPtr = std::shared_ptr<SpriteSheet>;
 
+struct SpriteCacheStatistics {
+	uint64_t sheet_hits = 0; // Sheet pixels used without decoding
+	uint64_t sheet_misses = 0; // Sheets decoded, for the first time or after being evicted
+	uint64_t sheet_evictions = 0;
+	uint64_t sprite_hits = 0;
+	uint64_t sprite_misses = 0;
+	uint64_t sprite_evictions = 0;
+};
+
 //@bindsingleton g_spriteAppearances
 class SpriteAppearances {
 public:
+	~SpriteAppearances();
+
 	void init();
 	void terminate();
 
@@ -194,17 +215,98 @@ public:
 	void saveSheetToFile(const SpriteSheetPtr &sheet, const std::string &file);
 	SpriteSheetPtr getSheetBySpriteId(int id, bool load = true);
 
+	// Returns whether the sheet of a sprite is loaded, if not it is queued for the decoder threads
+	// and every window is repainted once it is ready. Lets the GUI thread skip a sprite for a few
+	// frames instead of waiting for LZMA.
+	bool requestSheet(int spriteId);
+
 	void addSpriteSheet(SpriteSheetPtr sheet) {
 		sheets.push_back(sheet);
 	}
 
 	void saveSpriteToFile(int id, const std::string &file);
 
+	// Decoded sheets and cached sprites share one memory budget, the least recently used are
+	// dropped and loaded again when they are needed. A sprite is pinned, never dropped, while
+	// anything besides the cache holds its SpritePtr, like an image keeping its pixels for GL.
+	const SpriteCacheStatistics &getCacheStatistics() const noexcept {
+		return cache_statistics;
+	}
+	size_t getPinnedSpriteCount() const;
+
+	size_t getLoadedSheetCount() const noexcept {
+		return loaded_sheet_count;
+	}
+	// Decompressed pixel data held by loaded sheets, not counting the ones mapped from the sheet cache
+	int64_t getLoadedSheetBytes() const noexcept {
+		return loaded_sheet_bytes;
+	}
+	size_t getCachedSpriteCount() const noexcept {
+		return sprites.size();
+	}
+	// Pixel data of the sprites cut out of the sheets
+	int64_t getCachedSpriteBytes() const noexcept {
+		return cached_sprite_bytes;
+	}
+
 private:
+	// Reads and decompresses a sheet file, touches nothing shared so any thread may call it
+	static std::unique_ptr<uint8_t[]> decodeSpriteSheet(const std::string &path);
+	void installSheet(const SpriteSheetPtr &sheet, std::unique_ptr<uint8_t[]> data);
+	// Maps the sheets that did not change since the last run from the sheet cache
+	void openSheetCache(const std::string &dir, const std::string &catalog, const std::vector<SpriteSheetPtr> &catalogSheets);
+
+	void startDecoders();
+	void stopDecoders();
+	void decoderLoop();
+	// Installs what the decoder threads finished, on the GUI thread
+	void collectDecodedSheets();
+
+	// Owned sheets and cached sprites, most recently used first. Sheets mapped from the sheet
+	// cache take no memory of their own and are left out.
+	struct CacheEntry {
+		SpriteSheetPtr sheet; // nullptr for a sprite
+		int sprite_id = 0;
+		int64_t bytes = 0;
+	};
+	using CacheList = std::list<CacheEntry>;
+
+	struct CachedSprite {
+		SpritePtr sprite;
+		CacheList::iterator entry;
+	};
+
+	void touchSheet(const SpriteSheet* sheet);
+	// Drops the least recently used sheets and sprites until the memory budget is met. The most
+	// recently used entry always stays.
+	void trimCache();
+	void evictSheet(const SpriteSheetPtr &sheet);
+
+	struct DecodedSheet {
+		SpriteSheetPtr sheet;
+		std::unique_ptr<uint8_t[]> data; // nullptr if decoding failed
+		uint64_t generation = 0;
+	};
+
 	int spritesCount = 0;
+	size_t loaded_sheet_count = 0;
+	int64_t loaded_sheet_bytes = 0;
+	int64_t cached_sprite_bytes = 0;
 	std::vector<SpriteSheetPtr> sheets;
-	std::map<int, SpritePtr> sprites;
+	std::unordered_map<int, CachedSprite> sprites;
+	CacheList cache_entries;
+	std::unordered_map<const SpriteSheet*, CacheList::iterator> cached_sheets;
+	SpriteCacheStatistics cache_statistics;
 	std::string appearanceFile;
+	std::unique_ptr<SpriteSheetCache> sheet_cache;
+
+	std::vector<std::thread> decoders;
+	std::mutex decode_mutex;
+	std::condition_variable decode_ready;
+	std::deque<SpriteSheetPtr> decode_queue;
+	std::vector<DecodedSheet> decoded_sheets;
+	uint64_t decode_generation = 0; // Bumped by unload, so sheets of old assets are dropped
+	bool stopping_decoders = false;
 };
 
 extern SpriteAppearances g_spriteAppearances;
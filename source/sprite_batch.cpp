@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "sprite_batch.h"
+
+void SpriteBatch::add(const TextureAtlas::Region &region, float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+	++quad_count;
+	if (!enabled) {
+		drawImmediate(region, x, y, width, height, red, green, blue, alpha);
+		return;
+	}
+
+	const uint32_t tint = red | (green << 8) | (blue << 16) | (static_cast<uint32_t>(alpha) << 24);
+	if (region.texture != texture || tint != color) {
+		flush();
+		texture = region.texture;
+		color = tint;
+	}
+
+	vertices.push_back({ x, y, region.u0, region.v0 });
+	vertices.push_back({ x + width, y, region.u1, region.v0 });
+	vertices.push_back({ x + width, y + height, region.u1, region.v1 });
+	vertices.push_back({ x, y + height, region.u0, region.v1 });
+}
+
+void SpriteBatch::addSquare(float x, float y, float size, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+	add(atlas.getWhiteRegion(), x, y, size, size, red, green, blue, alpha);
+}
+
+void SpriteBatch::flush() {
+	if (vertices.empty()) {
+		return;
+	}
+
+	// Squares are drawn from the white sprite, so texturing is needed even when the caller
+	// turned it off around them
+	const bool textured = glIsEnabled(GL_TEXTURE_2D);
+	if (!textured) {
+		glEnable(GL_TEXTURE_2D);
+	}
+	atlas.bind(texture);
+
+	const size_t quads = vertices.size() / 4;
+	for (GLuint quad = static_cast<GLuint>(indices.size() / 6); quad < quads; ++quad) {
+		const GLuint first = quad * 4;
+		indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+	}
+
+	glColor4ub(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].u);
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(quads * 6), GL_UNSIGNED_INT, indices.data());
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	++draw_call_count;
+
+	if (!textured) {
+		glDisable(GL_TEXTURE_2D);
+	}
+	vertices.clear();
+	texture = 0;
+}
+
+void SpriteBatch::setEnabled(bool enabled) {
+	flush();
+	this->enabled = enabled;
+}
+
+void SpriteBatch::drawImmediate(const TextureAtlas::Region &region, float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+	const bool textured = glIsEnabled(GL_TEXTURE_2D);
+	if (!textured) {
+		glEnable(GL_TEXTURE_2D);
+	}
+	atlas.bind(region.texture);
+
+	glColor4ub(red, green, blue, alpha);
+	glBegin(GL_QUADS);
+	glTexCoord2f(region.u0, region.v0);
+	glVertex2f(x, y);
+	glTexCoord2f(region.u1, region.v0);
+	glVertex2f(x + width, y);
+	glTexCoord2f(region.u1, region.v1);
+	glVertex2f(x + width, y + height);
+	glTexCoord2f(region.u0, region.v1);
+	glVertex2f(x, y + height);
+	glEnd();
+	++draw_call_count;
+
+	if (!textured) {
+		glDisable(GL_TEXTURE_2D);
+	}
+}
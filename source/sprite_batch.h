@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_BATCH_H_
+#define RME_SPRITE_BATCH_H_
+
+#include "texture_atlas.h"
+
+#include <vector>
+
+// Collects the textured quads of a frame in a client side vertex array and draws them as indexed
+// triangles. Quads are drawn in the order they were added, since later sprites must cover earlier
+// ones, and the batch is drawn whenever the next quad is on another atlas page or has another
+// tint. With the sprites packed into a few pages and most of them drawn untinted, a floor takes
+// a handful of calls. The tint is set with glColor rather than per vertex, software renderers
+// such as llvmpipe shade a constant colour noticeably faster.
+// The batch has to be flushed before anything is drawn without it, or before the GL state it
+// relies on (blending, the current matrix) is changed. When batching is disabled every quad is
+// drawn right away with glBegin/glEnd, which is how the map was drawn before.
+class SpriteBatch {
+public:
+	explicit SpriteBatch(TextureAtlas &atlas) :
+		atlas(atlas) { }
+
+	void add(const TextureAtlas::Region &region, float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
+	// Adds an untextured quad, drawn with the white sprite of the atlas
+	void addSquare(float x, float y, float size, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
+	void flush();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const noexcept {
+		return enabled;
+	}
+
+	// Counted since the last resetStatistics
+	size_t getQuadCount() const noexcept {
+		return quad_count;
+	}
+	size_t getDrawCallCount() const noexcept {
+		return draw_call_count;
+	}
+	void resetStatistics() noexcept {
+		quad_count = 0;
+		draw_call_count = 0;
+	}
+
+private:
+	struct Vertex {
+		float x, y;
+		float u, v;
+	};
+
+	void drawImmediate(const TextureAtlas::Region &region, float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
+
+	TextureAtlas &atlas;
+	std::vector<Vertex> vertices;
+	std::vector<GLuint> indices; // Two triangles for every quad, only ever grows
+	GLuint texture = 0; // Page of the queued quads
+	uint32_t color = 0; // RGBA tint of the queued quads
+	bool enabled = true;
+
+	size_t quad_count = 0;
+	size_t draw_call_count = 0;
+};
+
+#endif
@@ -0,0 +1,251 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "sprite_sheet_cache.h"
+#include "sprite_appearances.h"
+
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+	constexpr char SheetCacheMagic[8] = { 'R', 'M', 'E', 'S', 'P', 'R', 'C', '\0' };
+	constexpr uint32_t SheetCacheVersion = 1;
+	constexpr uint64_t SheetCacheAlignment = 4096;
+}
+
+// The file is only read by the machine that wrote it, so everything is in native byte order
+struct SpriteSheetCache::Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t block_size;
+	uint64_t catalog_hash;
+	uint64_t count;
+};
+
+struct SpriteSheetCache::TableEntry {
+	uint64_t name_hash;
+	uint64_t file_size;
+	int64_t modified;
+	uint64_t offset; // 0 if the sheet could not be decoded
+};
+
+SpriteSheetCache::SpriteSheetCache(const std::string &path, Decoder decoder) :
+	path(path),
+	decoder(decoder) {
+	////
+}
+
+SpriteSheetCache::~SpriteSheetCache() {
+	close();
+}
+
+SpriteSheetCache::Entry SpriteSheetCache::makeEntry(const std::string &path) {
+	Entry entry;
+	entry.path = path;
+
+	const std::string name = fs::path(path).filename().string();
+	entry.name_hash = hash(name.data(), name.size());
+
+	std::error_code error;
+	const uintmax_t size = fs::file_size(path, error);
+	if (error) {
+		return entry;
+	}
+	const fs::file_time_type modified = fs::last_write_time(path, error);
+	if (error) {
+		return entry;
+	}
+	entry.file_size = size;
+	entry.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+	return entry;
+}
+
+uint64_t SpriteSheetCache::hash(const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t value = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < size; ++i) {
+		value ^= bytes[i];
+		value *= 0x100000001B3ULL;
+	}
+	return value;
+}
+
+std::vector<const uint8_t*> SpriteSheetCache::open(uint64_t catalog_hash, std::vector<Entry> entries) {
+	close();
+	this->catalog_hash = catalog_hash;
+	this->entries = std::move(entries);
+	offsets.assign(this->entries.size(), 0);
+	up_to_date = false;
+
+	std::vector<const uint8_t*> pixels(this->entries.size(), nullptr);
+
+	// Left behind by a rebuild that could not replace the mapped file
+	std::error_code error;
+	const std::string pending = path + ".new";
+	if (fs::exists(pending, error)) {
+		fs::rename(pending, path, error);
+		if (error) {
+			spdlog::warn("Could not replace sprite sheet cache {}: {}", path, error.message());
+		}
+	}
+
+	if (!mapping.open(path)) {
+		return pixels;
+	}
+
+	const uint8_t* data = mapping.getData();
+	const size_t size = mapping.getSize();
+
+	Header header;
+	if (size < sizeof(header)) {
+		mapping.close();
+		return pixels;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, SheetCacheMagic, sizeof(header.magic)) != 0 || header.version != SheetCacheVersion || header.block_size != BYTES_IN_SPRITE_SHEET || header.count > (size - sizeof(header)) / sizeof(TableEntry)) {
+		spdlog::info("Sprite sheet cache {} is outdated", path);
+		mapping.close();
+		return pixels;
+	}
+
+	std::vector<TableEntry> table(header.count);
+	std::memcpy(table.data(), data + sizeof(header), table.size() * sizeof(TableEntry));
+
+	// Looked up by name so sheets that did not change survive a client update
+	std::unordered_map<uint64_t, const TableEntry*> cached;
+	cached.reserve(table.size());
+	for (const TableEntry &entry : table) {
+		if (entry.offset != 0 && entry.offset <= size && size - entry.offset >= BYTES_IN_SPRITE_SHEET) {
+			cached.emplace(entry.name_hash, &entry);
+		}
+	}
+
+	bool complete = true;
+	for (size_t i = 0; i < this->entries.size(); ++i) {
+		const Entry &entry = this->entries[i];
+		if (entry.file_size == 0) {
+			continue;
+		}
+		const auto it = cached.find(entry.name_hash);
+		if (it == cached.end() || it->second->file_size != entry.file_size || it->second->modified != entry.modified) {
+			complete = false;
+			continue;
+		}
+		offsets[i] = it->second->offset;
+		pixels[i] = data + offsets[i];
+	}
+
+	up_to_date = complete && header.catalog_hash == catalog_hash;
+	return pixels;
+}
+
+void SpriteSheetCache::close() {
+	stopping = true;
+	if (rebuilder.joinable()) {
+		rebuilder.join();
+	}
+	stopping = false;
+	mapping.close();
+}
+
+void SpriteSheetCache::startRebuild() {
+	if (rebuilder.joinable()) {
+		return;
+	}
+	rebuilder = std::thread([this]() { rebuild(); });
+}
+
+void SpriteSheetCache::rebuild() {
+	const std::string temporary = path + ".tmp";
+	std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		spdlog::warn("Could not write sprite sheet cache {}", temporary);
+		return;
+	}
+
+	Header header {};
+	std::memcpy(header.magic, SheetCacheMagic, sizeof(header.magic));
+	header.version = SheetCacheVersion;
+	header.block_size = BYTES_IN_SPRITE_SHEET;
+	header.catalog_hash = catalog_hash;
+	header.count = entries.size();
+
+	// The table is written again once the offsets are known
+	std::vector<TableEntry> table(entries.size(), TableEntry {});
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TableEntry));
+
+	uint64_t position = sizeof(header) + table.size() * sizeof(TableEntry);
+	position = (position + SheetCacheAlignment - 1) / SheetCacheAlignment * SheetCacheAlignment;
+	file.seekp(static_cast<std::streamoff>(position));
+
+	size_t copied = 0;
+	size_t decoded = 0;
+	for (size_t i = 0; i < entries.size() && file.good(); ++i) {
+		const Entry &entry = entries[i];
+		table[i].name_hash = entry.name_hash;
+		table[i].file_size = entry.file_size;
+		table[i].modified = entry.modified;
+		// Stopped early, the sheets left out are decoded by the next rebuild
+		if (entry.file_size == 0 || stopping) {
+			continue;
+		}
+
+		const uint8_t* pixels = offsets[i] != 0 ? mapping.getData() + offsets[i] : nullptr;
+		std::unique_ptr<uint8_t[]> data;
+		if (pixels) {
+			++copied;
+		} else {
+			data = decoder(entry.path);
+			if (!data) {
+				continue;
+			}
+			pixels = data.get();
+			++decoded;
+		}
+
+		table[i].offset = position;
+		file.write(reinterpret_cast<const char*>(pixels), BYTES_IN_SPRITE_SHEET);
+		position += BYTES_IN_SPRITE_SHEET;
+	}
+
+	file.seekp(sizeof(header));
+	file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TableEntry));
+	file.close();
+
+	std::error_code error;
+	if (!file) {
+		spdlog::warn("Could not write sprite sheet cache {}", temporary);
+		fs::remove(temporary, error);
+		return;
+	}
+
+	// Windows does not replace a mapped file, open picks it up next time
+	fs::rename(temporary, path, error);
+	if (error) {
+		fs::rename(temporary, path + ".new", error);
+	}
+	if (error) {
+		spdlog::warn("Could not replace sprite sheet cache {}: {}", path, error.message());
+		fs::remove(temporary, error);
+		return;
+	}
+	spdlog::info("Sprite sheet cache {} written, {} sheets decoded and {} kept", path, decoded, copied);
+}
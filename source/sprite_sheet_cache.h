@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_SHEET_CACHE_H_
+#define RME_SPRITE_SHEET_CACHE_H_
+
+#include "filehandle.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decompressed client sprite sheets kept in one file that is mapped when the client is loaded,
+// so a sheet whose file did not change since the cache was written skips LZMA. Every sheet is a
+// raw block of BYTES_IN_SPRITE_SHEET bytes, found by the hash of its file name and checked
+// against the size and modification time of that file.
+class SpriteSheetCache {
+public:
+	struct Entry {
+		std::string path;
+		uint64_t name_hash = 0;
+		uint64_t file_size = 0; // 0 if the sheet file could not be read, it is never cached
+		int64_t modified = 0;
+	};
+
+	// Reads and decompresses a sheet file, called from the rebuild thread
+	using Decoder = std::unique_ptr<uint8_t[]> (*)(const std::string &path);
+
+	SpriteSheetCache(const std::string &path, Decoder decoder);
+	~SpriteSheetCache();
+
+	SpriteSheetCache(const SpriteSheetCache &) = delete;
+	SpriteSheetCache &operator=(const SpriteSheetCache &) = delete;
+
+	// Fills an entry from the sheet file on disk
+	static Entry makeEntry(const std::string &path);
+	// FNV-1a
+	static uint64_t hash(const void* data, size_t size);
+
+	// Maps the cache file and returns the pixels of every entry found in it, nullptr for the
+	// sheets that have to be decoded. The pixels stay valid until close.
+	std::vector<const uint8_t*> open(uint64_t catalog_hash, std::vector<Entry> entries);
+	// Stops a running rebuild, keeping the sheets it wrote so far, and unmaps the file
+	void close();
+
+	// Whether the file did not match the catalog passed to open
+	bool needsRebuild() const noexcept {
+		return !up_to_date;
+	}
+	// Writes a new cache file for the catalog passed to open on a background thread. Blocks of
+	// the current file are copied, the rest is decoded. It replaces the current file when done,
+	// or at the next open if the file cannot be replaced while it is mapped.
+	void startRebuild();
+
+private:
+	struct Header;
+	struct TableEntry;
+
+	void rebuild();
+
+	std::string path;
+	Decoder decoder;
+	MappedFile mapping;
+	uint64_t catalog_hash = 0;
+	std::vector<Entry> entries;
+	std::vector<uint64_t> offsets; // Of the pixels of each entry in the mapping, 0 if not there
+	bool up_to_date = false;
+
+	std::thread rebuilder;
+	std::atomic<bool> stopping { false };
+};
+
+#endif
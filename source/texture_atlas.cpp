@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "texture_atlas.h"
+
+TextureAtlas::~TextureAtlas() {
+	clear();
+}
+
+const TextureAtlas::Region* TextureAtlas::insert(uint32_t id, int width, int height, const uint8_t* rgba) {
+	erase(id);
+
+	if (page_size == 0) {
+		GLint max_size = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+		page_size = std::min(PageSize, std::max<int>(max_size, 256));
+	}
+
+	const int slot_width = width + 2 * Border;
+	const int slot_height = height + 2 * Border;
+	if (width <= 0 || height <= 0 || slot_width > page_size || slot_height > page_size) {
+		return nullptr;
+	}
+
+	Page* page = nullptr;
+	for (const auto &candidate : pages) {
+		if (candidate->slot_width == slot_width && candidate->slot_height == slot_height && !candidate->free_slots.empty()) {
+			page = candidate.get();
+			break;
+		}
+	}
+	if (!page) {
+		page = addPage(slot_width, slot_height);
+	}
+
+	const uint32_t slot = page->free_slots.back();
+	page->free_slots.pop_back();
+	++page->used;
+
+	// The border repeats the outermost texels, like GL_CLAMP_TO_EDGE did for a texture of its own
+	std::vector<uint8_t> pixels(static_cast<size_t>(slot_width) * slot_height * 4);
+	for (int y = 0; y < slot_height; ++y) {
+		const uint8_t* source_row = rgba + static_cast<size_t>(std::clamp(y - Border, 0, height - 1)) * width * 4;
+		uint8_t* target = pixels.data() + static_cast<size_t>(y) * slot_width * 4;
+		std::memcpy(target, source_row, 4);
+		std::memcpy(target + Border * 4, source_row, static_cast<size_t>(width) * 4);
+		std::memcpy(target + (Border + width) * 4, source_row + (width - 1) * 4, 4);
+	}
+
+	const int x = (slot % page->columns) * slot_width;
+	const int y = (slot / page->columns) * slot_height;
+	bind(page->texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, slot_width, slot_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	Entry &entry = entries[id];
+	entry.page = page;
+	entry.slot = slot;
+
+	const float scale = 1.f / page_size;
+	entry.region.texture = page->texture;
+	entry.region.u0 = (x + Border) * scale;
+	entry.region.v0 = (y + Border) * scale;
+	entry.region.u1 = (x + Border + width) * scale;
+	entry.region.v1 = (y + Border + height) * scale;
+	return &entry.region;
+}
+
+void TextureAtlas::erase(uint32_t id) {
+	auto it = entries.find(id);
+	if (it == entries.end()) {
+		return;
+	}
+
+	Page* page = it->second.page;
+	page->free_slots.push_back(it->second.slot);
+	--page->used;
+	entries.erase(it);
+
+	// The last page of a size is kept, sprites of that size are likely to be loaded again soon
+	if (page->used != 0) {
+		return;
+	}
+	const bool has_sibling = std::any_of(pages.begin(), pages.end(), [page](const auto &other) {
+		return other.get() != page && other->slot_width == page->slot_width && other->slot_height == page->slot_height;
+	});
+	if (has_sibling) {
+		if (bound_texture == page->texture) {
+			bound_texture = 0;
+		}
+		glDeleteTextures(1, &page->texture);
+		pages.erase(std::find_if(pages.begin(), pages.end(), [page](const auto &other) { return other.get() == page; }));
+	}
+}
+
+void TextureAtlas::clear() {
+	for (const auto &page : pages) {
+		glDeleteTextures(1, &page->texture);
+	}
+	pages.clear();
+	entries.clear();
+	bound_texture = 0;
+}
+
+const TextureAtlas::Region &TextureAtlas::getWhiteRegion() {
+	if (const Region* region = find(WhiteId)) {
+		return *region;
+	}
+
+	const std::vector<uint8_t> white(rme::SpritePixelsSize * 4, 0xFF);
+	return *insert(WhiteId, rme::SpritePixels, rme::SpritePixels, white.data());
+}
+
+void TextureAtlas::bind(GLuint texture) {
+	if (texture != bound_texture) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		bound_texture = texture;
+	}
+}
+
+TextureAtlas::Page* TextureAtlas::addPage(int slot_width, int slot_height) {
+	auto page = std::make_unique<Page>();
+	page->slot_width = slot_width;
+	page->slot_height = slot_height;
+	page->columns = page_size / slot_width;
+
+	// Slots are handed out from the top left corner
+	const uint32_t slots = page->columns * (page_size / slot_height);
+	page->free_slots.reserve(slots);
+	for (uint32_t slot = slots; slot > 0; --slot) {
+		page->free_slots.push_back(slot - 1);
+	}
+
+	glGenTextures(1, &page->texture);
+	bind(page->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Nearest Filtering
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Nearest Filtering
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); // GL_CLAMP_TO_EDGE
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F); // GL_CLAMP_TO_EDGE
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_size, page_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	pages.push_back(std::move(page));
+	return pages.back().get();
+}
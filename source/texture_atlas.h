@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_TEXTURE_ATLAS_H_
+#define RME_TEXTURE_ATLAS_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Packs the textures of the sprites into a few large GL textures, so that drawing a screen full
+// of sprites only switches textures a handful of times. A page holds slots of one size only and
+// every slot has a one texel border that repeats the edges of its sprite, so that a scaled sprite
+// never samples its neighbours. Textures are looked up by the same ids the sprites used as GL
+// texture names before, a page that runs empty is released.
+// Every call needs the GL context of the map canvases.
+class TextureAtlas {
+public:
+	static constexpr int PageSize = 2048;
+	static constexpr int Border = 1;
+	static constexpr uint32_t WhiteId = 0xFFFFFFFF; // Above every sprite id and free texture id
+
+	struct Region {
+		GLuint texture = 0; // GL name of the page
+		float u0 = 0.f;
+		float v0 = 0.f;
+		float u1 = 0.f;
+		float v1 = 0.f;
+	};
+
+	TextureAtlas() = default;
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas &) = delete;
+	TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+	// Uploads width x height RGBA pixels as the texture of id, replacing the one it had.
+	// Returns nullptr if the texture does not fit on a page.
+	const Region* insert(uint32_t id, int width, int height, const uint8_t* rgba);
+	void erase(uint32_t id);
+	void clear();
+
+	const Region* find(uint32_t id) const {
+		auto it = entries.find(id);
+		return it != entries.end() ? &it->second.region : nullptr;
+	}
+
+	// A plain white sprite, so that untextured quads can be drawn in the same batch as sprites
+	const Region &getWhiteRegion();
+
+	// Binds a page unless it is still bound, resetBinding must be called after anything else
+	// binds a texture
+	void bind(GLuint texture);
+	void resetBinding() noexcept {
+		bound_texture = 0;
+	}
+
+	size_t getPageCount() const noexcept {
+		return pages.size();
+	}
+	int64_t getReservedBytes() const noexcept {
+		return static_cast<int64_t>(pages.size()) * page_size * page_size * 4;
+	}
+
+private:
+	struct Page {
+		GLuint texture = 0;
+		int slot_width = 0; // Border included
+		int slot_height = 0;
+		int columns = 0;
+		std::vector<uint32_t> free_slots;
+		uint32_t used = 0;
+	};
+
+	struct Entry {
+		Region region;
+		Page* page = nullptr;
+		uint32_t slot = 0;
+	};
+
+	Page* addPage(int slot_width, int slot_height);
+
+	std::vector<std::unique_ptr<Page>> pages;
+	std::unordered_map<uint32_t, Entry> entries;
+	int page_size = 0; // PageSize or less if the driver can not make textures that large
+	GLuint bound_texture = 0;
+};
+
+#endif
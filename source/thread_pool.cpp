@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "thread_pool.h"
+
+#include <atomic>
+
+namespace {
+	thread_local bool inside_parallel_loop = false;
+	thread_local size_t current_worker = 0;
+}
+
+struct ThreadPool::Job {
+	const RangeFunction &function;
+	size_t count;
+	size_t grain;
+	std::atomic<size_t> next { 0 };
+	std::atomic<size_t> done { 0 };
+	std::exception_ptr error;
+	std::mutex error_mutex;
+
+	Job(const RangeFunction &function, size_t count, size_t grain) :
+		function(function), count(count), grain(grain) { }
+};
+
+ThreadPool &ThreadPool::getInstance() {
+	static ThreadPool instance;
+	return instance;
+}
+
+ThreadPool::ThreadPool() {
+	const unsigned int hardware = std::thread::hardware_concurrency();
+	const size_t count = hardware > 1 ? hardware - 1 : 0;
+
+	workers.reserve(count);
+	for (size_t worker = 1; worker <= count; ++worker) {
+		workers.emplace_back([this, worker]() { workerLoop(worker); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	job_ready.notify_all();
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const RangeFunction &function, const ProgressFunction &progress) {
+	if (count == 0) {
+		return;
+	}
+	grain = std::max<size_t>(grain, 1);
+
+	if (workers.empty() || inside_parallel_loop || count <= grain) {
+		function(0, count, current_worker);
+		if (progress) {
+			progress(count, count);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+
+	Job current(function, count, grain);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &current;
+		pending_workers = workers.size();
+		++generation;
+	}
+	job_ready.notify_all();
+
+	runChunks(current, 0, progress ? &progress : nullptr);
+
+	{
+		// Every worker checks in, so none of them can touch the job after this returns
+		std::unique_lock<std::mutex> lock(mutex);
+		job_done.wait(lock, [this]() { return pending_workers == 0; });
+		job = nullptr;
+	}
+
+	if (progress) {
+		progress(count, count);
+	}
+	if (current.error) {
+		std::rethrow_exception(current.error);
+	}
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+	uint64_t seen_generation = 0;
+	while (true) {
+		Job* current;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_ready.wait(lock, [&]() { return stopping || generation != seen_generation; });
+			if (stopping) {
+				return;
+			}
+			seen_generation = generation;
+			current = job;
+		}
+
+		runChunks(*current, worker, nullptr);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--pending_workers;
+		}
+		job_done.notify_one();
+	}
+}
+
+void ThreadPool::runChunks(Job &current, size_t worker, const ProgressFunction* progress) {
+	inside_parallel_loop = true;
+	current_worker = worker;
+	while (true) {
+		const size_t begin = current.next.fetch_add(current.grain);
+		if (begin >= current.count) {
+			break;
+		}
+		const size_t end = std::min(begin + current.grain, current.count);
+
+		try {
+			current.function(begin, end, worker);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(current.error_mutex);
+			if (!current.error) {
+				current.error = std::current_exception();
+			}
+			// Skip whatever is left
+			current.next.store(current.count);
+		}
+
+		const size_t done = current.done.fetch_add(end - begin) + (end - begin);
+		if (progress) {
+			(*progress)(done, current.count);
+		}
+	}
+	inside_parallel_loop = false;
+}
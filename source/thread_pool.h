@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_THREAD_POOL_H_
+#define RME_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by the whole editor
+// Only one parallel loop runs at a time, the calling thread takes part in it
+class ThreadPool {
+public:
+	// Called with a half open range [begin, end) and the index of the thread running it
+	using RangeFunction = std::function<void(size_t begin, size_t end, size_t worker)>;
+	// Called on the calling thread only, with the number of indices done so far
+	using ProgressFunction = std::function<void(size_t done, size_t total)>;
+
+	static ThreadPool &getInstance();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	// Number of threads that can run a loop at once, including the calling thread
+	size_t getThreadCount() const noexcept {
+		return workers.size() + 1;
+	}
+
+	// Splits [0, count) into chunks of at most grain indices and runs them on all threads
+	// Blocks until every chunk is done, exceptions thrown by a chunk are rethrown here
+	// Nested calls from inside a chunk run serially on the current thread
+	void parallelFor(size_t count, size_t grain, const RangeFunction &function, const ProgressFunction &progress = nullptr);
+
+private:
+	ThreadPool();
+	~ThreadPool();
+
+	struct Job;
+
+	void workerLoop(size_t worker);
+	void runChunks(Job &job, size_t worker, const ProgressFunction* progress);
+
+	std::vector<std::thread> workers;
+
+	std::mutex submit_mutex; // Held for the whole duration of a loop
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	std::condition_variable job_done;
+	Job* job = nullptr;
+	uint64_t generation = 0;
+	size_t pending_workers = 0;
+	bool stopping = false;
+};
+
+#endif
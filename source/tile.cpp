@@ -74,6 +74,15 @@ Tile::~Tile() {
 	delete spawnNpc;
 }
 
+void* Tile::operator new(size_t size) {
+	ASSERT(size == sizeof(Tile));
+	return TilePool::allocate();
+}
+
+void Tile::operator delete(void* memory) noexcept {
+	TilePool::deallocate(memory);
+}
+
 Tile* Tile::deepCopy(BaseMap &map) const {
 	Tile* copy = map.allocator.allocateTile(location);
 	copy->flags = flags;
@@ -104,6 +113,82 @@ Tile* Tile::deepCopy(BaseMap &map) const {
 	return copy;
 }
 
+namespace {
+	// How far ahead of the last match shareItems looks for the next one
+	constexpr size_t ShareItemsWindow = 16;
+
+	// Replaces the item by a reference to the other one if it can stand in for it
+	bool shareItem(Item*&item, Item* other) {
+		if (item == other) {
+			return true;
+		}
+		if (!item->matches(*other)) {
+			return false;
+		}
+
+		Item* shared = other->share();
+		if (!shared) {
+			return false;
+		}
+		delete item;
+		item = shared;
+		return true;
+	}
+
+	void unshareItem(Item*&item) {
+		if (item && item->isShared()) {
+			Item* copy = item->deepCopy();
+			delete item;
+			item = copy;
+		}
+	}
+
+	// Only items whose selection changes need a copy of their own
+	void setItemSelected(Item*&item, bool select) {
+		if (item->isSelected() == select) {
+			return;
+		}
+		unshareItem(item);
+		if (select) {
+			item->select();
+		} else {
+			item->deselect();
+		}
+	}
+}
+
+void Tile::shareItems(const Tile &other) {
+	if (ground && other.ground) {
+		shareItem(ground, other.ground);
+	}
+
+	// Both stacks keep their order, so the next match is searched for after the previous one
+	size_t next = 0;
+	for (Item*&item : items) {
+		const size_t last = std::min(other.items.size(), next + ShareItemsWindow);
+		for (size_t index = next; index < last; ++index) {
+			if (shareItem(item, other.items[index])) {
+				next = index + 1;
+				break;
+			}
+		}
+	}
+}
+
+void Tile::compactItems() {
+	ground = Item::compact(ground);
+	for (Item*&item : items) {
+		item = Item::compact(item);
+	}
+}
+
+void Tile::unshareItems() {
+	unshareItem(ground);
+	for (Item*&item : items) {
+		unshareItem(item);
+	}
+}
+
 uint32_t Tile::memsize() const {
 	uint32_t mem = sizeof(*this);
 	if (ground) {
@@ -343,7 +428,7 @@ void Tile::select() {
 		return;
 	}
 	if (ground) {
-		ground->select();
+		setItemSelected(ground, true);
 	}
 	if (spawnMonster) {
 		spawnMonster->select();
@@ -358,8 +443,8 @@ void Tile::select() {
 	for (const auto monster : monsters) {
 		monster->select();
 	}
-	for (Item* item : items) {
-		item->select();
+	for (Item*&item : items) {
+		setItemSelected(item, true);
 	}
 
 	statflags |= TILESTATE_SELECTED;
@@ -367,7 +452,7 @@ void Tile::select() {
 
 void Tile::deselect() {
 	if (ground) {
-		ground->deselect();
+		setItemSelected(ground, false);
 	}
 	if (spawnMonster) {
 		spawnMonster->deselect();
@@ -383,8 +468,8 @@ void Tile::deselect() {
 		monster->deselect();
 	}
 
-	for (Item* item : items) {
-		item->deselect();
+	for (Item*&item : items) {
+		setItemSelected(item, false);
 	}
 
 	statflags &= ~TILESTATE_SELECTED;
@@ -711,16 +796,16 @@ void Tile::carpetize(BaseMap* parent) {
 void Tile::selectGround() {
 	bool selected = false;
 	if (ground) {
-		ground->select();
+		setItemSelected(ground, true);
 		selected = true;
 	}
 	ItemVector::iterator it;
 
-	for (Item* item : items) {
+	for (Item*&item : items) {
 		if (!item->isBorder()) {
 			break;
 		}
-		item->select();
+		setItemSelected(item, true);
 		selected = true;
 	}
 
@@ -731,14 +816,14 @@ void Tile::selectGround() {
 
 void Tile::deselectGround() {
 	if (ground) {
-		ground->deselect();
+		setItemSelected(ground, false);
 	}
-	for (Item* item : items) {
+	for (Item*&item : items) {
 		if (!item->isBorder()) {
 			break;
 		}
 
-		item->deselect();
+		setItemSelected(item, false);
 	}
 }
 
@@ -23,6 +23,7 @@
 #include "map_region.h"
 #include "spawn_npc.h"
 #include "npc.h"
+#include "zones.h"
 #include <unordered_set>
 
 enum {
@@ -57,7 +58,7 @@ public: // Members
 	Npc* npc;
 	SpawnNpc* spawnNpc;
 	uint32_t house_id; // House id for this tile (pointer not safe)
-	std::set<unsigned int> zones;
+	TileZoneSet zones;
 
 public:
 	// ALWAYS use this constructor if the Tile is EVER going to be placed on a map
@@ -67,8 +68,24 @@ public:
 
 	~Tile();
 
+	// Tiles are carved out of the TilePool slabs, or the MapAllocator slabs of
+	// their map through placement new (see map_allocator.h)
+	static void* operator new(size_t size);
+	static void* operator new(size_t, void* place) noexcept {
+		return place;
+	}
+	static void operator delete(void* memory) noexcept;
+	static void operator delete(void*, void*) noexcept { }
+
 	// Argument is a the map to allocate the tile from
 	Tile* deepCopy(BaseMap &map) const;
+	// For tiles kept in the undo history, replaces the items that match one of the other tile (the
+	// one in the map) by a reference to it, so only the items that changed are held twice
+	void shareItems(const Tile &other);
+	// Replaces the plain items by their shared records (see Item::compact)
+	void compactItems();
+	// Gives the tile its own copy of every shared item, before they are changed in place
+	void unshareItems();
 
 	// The location of the tile
 	// Stores state that remains between the tile being moved (like house exits)
@@ -273,7 +290,7 @@ public: // Functions
 	}
 
 	bool hasZone(unsigned int zone) const {
-		return zones.find(zone) != zones.end();
+		return zones.contains(zone);
 	}
 
 	void addZone(unsigned int zone) {
@@ -63,3 +63,157 @@ unsigned int Zones::generateID() {
 	}
 	return id;
 }
+
+void Zones::addTileZones(const Position &position, const TileZoneSet &tile_zones) {
+	for (unsigned int zone : tile_zones) {
+		tile_indexes[zone].add(position);
+	}
+}
+
+void Zones::removeTileZones(const Position &position, const TileZoneSet &tile_zones) {
+	for (unsigned int zone : tile_zones) {
+		auto it = tile_indexes.find(zone);
+		if (it == tile_indexes.end()) {
+			continue;
+		}
+		it->second.remove(position);
+		if (it->second.empty()) {
+			tile_indexes.erase(it);
+		}
+	}
+}
+
+const ZoneTileIndex* Zones::getTileIndex(unsigned int id) const {
+	auto it = tile_indexes.find(id);
+	if (it == tile_indexes.end()) {
+		return nullptr;
+	}
+	return &it->second;
+}
+
+std::vector<std::pair<unsigned int, ZoneTileIndex>> Zones::takeDeletedTileIndexes() {
+	std::vector<std::pair<unsigned int, ZoneTileIndex>> deleted;
+	for (auto it = tile_indexes.begin(); it != tile_indexes.end();) {
+		if (hasZone(it->first)) {
+			++it;
+		} else {
+			deleted.emplace_back(it->first, std::move(it->second));
+			it = tile_indexes.erase(it);
+		}
+	}
+	return deleted;
+}
+
+// Zone tile index
+
+uint64_t ZoneTileIndex::getBlockKey(const Position &position) noexcept {
+	const uint64_t block_x = static_cast<uint64_t>(position.x >> BlockShift) & 0xFFFF;
+	const uint64_t block_y = static_cast<uint64_t>(position.y >> BlockShift) & 0xFFFF;
+	return (static_cast<uint64_t>(position.z) << 32) | (block_y << 16) | block_x;
+}
+
+uint64_t ZoneTileIndex::getBlockBit(const Position &position) noexcept {
+	return uint64_t(1) << (((position.y & BlockMask) << BlockShift) | (position.x & BlockMask));
+}
+
+void ZoneTileIndex::add(const Position &position) {
+	uint64_t &bits = blocks[getBlockKey(position)];
+	const uint64_t bit = getBlockBit(position);
+	if ((bits & bit) == 0) {
+		bits |= bit;
+		++count;
+	}
+}
+
+void ZoneTileIndex::remove(const Position &position) {
+	auto it = blocks.find(getBlockKey(position));
+	if (it == blocks.end()) {
+		return;
+	}
+
+	const uint64_t bit = getBlockBit(position);
+	if ((it->second & bit) != 0) {
+		it->second &= ~bit;
+		--count;
+		if (it->second == 0) {
+			blocks.erase(it);
+		}
+	}
+}
+
+// Tile zone set
+
+TileZoneSet::TileZoneSet(const TileZoneSet &other) :
+	TileZoneSet() {
+	*this = other;
+}
+
+TileZoneSet &TileZoneSet::operator=(const TileZoneSet &other) {
+	if (&other == this) {
+		return *this;
+	}
+
+	clear();
+	if (other.count > capacity) {
+		heap_zones = newd unsigned int[other.count];
+		capacity = other.count;
+	}
+	std::copy(other.begin(), other.end(), data());
+	count = other.count;
+	return *this;
+}
+
+TileZoneSet::~TileZoneSet() {
+	clear();
+}
+
+bool TileZoneSet::contains(unsigned int zone) const noexcept {
+	return std::binary_search(begin(), end(), zone);
+}
+
+bool TileZoneSet::insert(unsigned int zone) {
+	unsigned int* first = data();
+	unsigned int* position = std::lower_bound(first, first + count, zone);
+	if (position != first + count && *position == zone) {
+		return false;
+	}
+
+	const size_t offset = position - first;
+	if (count == capacity) {
+		ASSERT(capacity < 0x8000);
+		const uint16_t new_capacity = capacity * 2;
+		unsigned int* grown = newd unsigned int[new_capacity];
+		std::copy(first, first + count, grown);
+		if (!isInline()) {
+			delete[] heap_zones;
+		}
+		heap_zones = grown;
+		capacity = new_capacity;
+		first = grown;
+	}
+
+	std::copy_backward(first + offset, first + count, first + count + 1);
+	first[offset] = zone;
+	++count;
+	return true;
+}
+
+bool TileZoneSet::erase(unsigned int zone) noexcept {
+	unsigned int* first = data();
+	unsigned int* position = std::lower_bound(first, first + count, zone);
+	if (position == first + count || *position != zone) {
+		return false;
+	}
+
+	std::copy(position + 1, first + count, position);
+	--count;
+	return true;
+}
+
+void TileZoneSet::clear() noexcept {
+	if (!isInline()) {
+		delete[] heap_zones;
+		capacity = InlineCapacity;
+	}
+	count = 0;
+}
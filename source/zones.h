@@ -18,8 +18,102 @@
 #ifndef RME_ZONES_H_
 #define RME_ZONES_H_
 
+#include "position.h"
+
+#include <bit>
+
 typedef std::map<std::string, unsigned int> ZoneMap;
 
+// Sorted set of the zone ids of a tile
+// Tiles rarely carry more than a couple of zones, so those are stored inline
+class TileZoneSet {
+public:
+	using const_iterator = const unsigned int*;
+
+	TileZoneSet() noexcept :
+		count(0), capacity(InlineCapacity) { }
+	TileZoneSet(const TileZoneSet &other);
+	TileZoneSet &operator=(const TileZoneSet &other);
+	~TileZoneSet();
+
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	size_t size() const noexcept {
+		return count;
+	}
+	bool contains(unsigned int zone) const noexcept;
+
+	// Returns false if the zone was already (insert) or not (erase) in the set
+	bool insert(unsigned int zone);
+	bool erase(unsigned int zone) noexcept;
+	void clear() noexcept;
+
+	const_iterator begin() const noexcept {
+		return data();
+	}
+	const_iterator end() const noexcept {
+		return data() + count;
+	}
+
+private:
+	static constexpr uint16_t InlineCapacity = 2;
+
+	bool isInline() const noexcept {
+		return capacity == InlineCapacity;
+	}
+	unsigned int* data() noexcept {
+		return isInline() ? inline_zones : heap_zones;
+	}
+	const unsigned int* data() const noexcept {
+		return isInline() ? inline_zones : heap_zones;
+	}
+
+	union {
+		unsigned int inline_zones[InlineCapacity];
+		unsigned int* heap_zones;
+	};
+	uint16_t count;
+	uint16_t capacity;
+};
+
+// Positions of all map tiles carrying one zone, one bit per tile in 8x8 blocks
+class ZoneTileIndex {
+public:
+	void add(const Position &position);
+	void remove(const Position &position);
+
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	size_t size() const noexcept {
+		return count;
+	}
+
+	template <typename F>
+	void forEach(F &&f) const {
+		for (const auto &[key, bits] : blocks) {
+			const int base_x = static_cast<int>(key & 0xFFFF) << BlockShift;
+			const int base_y = static_cast<int>((key >> 16) & 0xFFFF) << BlockShift;
+			const int z = static_cast<int>(key >> 32);
+			for (uint64_t remaining = bits; remaining != 0; remaining &= remaining - 1) {
+				const int bit = std::countr_zero(remaining);
+				f(Position(base_x + (bit & BlockMask), base_y + (bit >> BlockShift), z));
+			}
+		}
+	}
+
+private:
+	static constexpr int BlockShift = 3;
+	static constexpr int BlockMask = (1 << BlockShift) - 1;
+
+	static uint64_t getBlockKey(const Position &position) noexcept;
+	static uint64_t getBlockBit(const Position &position) noexcept;
+
+	std::unordered_map<uint64_t, uint64_t> blocks;
+	size_t count = 0;
+};
+
 class Zones {
 public:
 	Zones(Map &map) :
@@ -39,6 +133,13 @@ public:
 	bool hasZone(unsigned int id);
 	void removeZone(const std::string &name);
 
+	// Spatial index of the tiles on the map, kept up to date by Map::updateZones
+	void addTileZones(const Position &position, const TileZoneSet &tile_zones);
+	void removeTileZones(const Position &position, const TileZoneSet &tile_zones);
+	const ZoneTileIndex* getTileIndex(unsigned int id) const;
+	// Removes and returns the indexes of zone ids that are used by tiles but no longer registered
+	std::vector<std::pair<unsigned int, ZoneTileIndex>> takeDeletedTileIndexes();
+
 	ZoneMap zones;
 
 	ZoneMap::iterator begin() {
@@ -57,6 +158,7 @@ public:
 private:
 	Map &map;
 	std::unordered_set<unsigned int> used_ids;
+	std::unordered_map<unsigned int, ZoneTileIndex> tile_indexes;
 
 	unsigned int generateID();
 };